@@ -30,6 +30,7 @@
 #include "../d_io.h"
 #include "../d_dwfile.h"
 #include "../i_system.h"
+#include "../m_ctype.h"
 #include "../w_wad.h"
 
 #include "confuse.h"
@@ -80,24 +81,128 @@ static void my_assert(const char *msg, const char *file, int line)
 }
 #endif
 
+//=============================================================================
 //
-// cfg_strndup
+// Option Hashing
 //
-// haleyjd 11/08/09: just use this unconditionally, because I cannot be
-// bothered to build GCC version detection into the makefiles for Linux
-// now that GCC 4.4.x has this function.
+// Every section built from the same cfg_opt_t table shares one open-addressed
+// table mapping option names to their index in the table. Tables are kept in
+// a registry keyed on the address of the cfg_opt_t array and live for the
+// rest of the program, like the arrays themselves.
 //
-static char *cfg_strndup(const char *s, size_t n)
+
+#define CFG_NUMHASHCHAINS 61
+
+struct cfg_opthash_t
 {
-   char *r;
-   
-   if(s == 0)
+   const cfg_opt_t *opts;  // options the table was built from
+   cfg_opthash_t   *next;  // next in registry chain
+   unsigned int     mask;  // number of slots minus one
+   int             *slots; // option index plus one, or 0 if empty
+};
+
+static cfg_opthash_t *cfg_opthashes[CFG_NUMHASHCHAINS];
+
+//
+// cfg_hashname
+//
+// Case-insensitive hash of the first len characters of name, so that one
+// table serves sections with and without CFGF_NOCASE.
+//
+static unsigned int cfg_hashname(const char *name, size_t len)
+{
+   unsigned int h = 0;
+
+   while(len--)
+      h = ectype::toUpper((unsigned char)*name++) + (h << 6) + (h << 16) - h;
+
+   return h;
+}
+
+//
+// cfg_getopthash
+//
+// Returns the name table for an options array, building it the first time.
+//
+static cfg_opthash_t *cfg_getopthash(const cfg_opt_t *opts)
+{
+   unsigned int chain = (unsigned int)(((size_t)opts >> 4) % CFG_NUMHASHCHAINS);
+   cfg_opthash_t *hash;
+   unsigned int numopts, numslots;
+
+   for(hash = cfg_opthashes[chain]; hash; hash = hash->next)
+   {
+      if(hash->opts == opts)
+         return hash;
+   }
+
+   for(numopts = 0; opts[numopts].name; numopts++) /* do nothing */ ;
+
+   // keep the table at most half full
+   for(numslots = 4; numslots < numopts * 2; numslots <<= 1) /* do nothing */ ;
+
+   hash        = estructalloc(cfg_opthash_t, 1);
+   hash->opts  = opts;
+   hash->mask  = numslots - 1;
+   hash->slots = ecalloc(int *, numslots, sizeof(int));
+
+   // Insert in order with linear probing, so that if two options only differ
+   // in case, a lookup reaches the earlier one first, as a scan would.
+   for(unsigned int i = 0; i < numopts; i++)
+   {
+      const char  *name = opts[i].name;
+      unsigned int slot = cfg_hashname(name, strlen(name)) & hash->mask;
+
+      while(hash->slots[slot])
+         slot = (slot + 1) & hash->mask;
+      hash->slots[slot] = i + 1;
+   }
+
+   hash->next = cfg_opthashes[chain];
+   cfg_opthashes[chain] = hash;
+
+   return hash;
+}
+
+//
+// cfg_findopt
+//
+// Looks up the option named by the first len characters of name in a single
+// section.
+//
+static cfg_opt_t *cfg_findopt(cfg_t *sec, const char *name, size_t len)
+{
+   bool nocase = is_set(CFGF_NOCASE, sec->flags);
+
+   if(!sec->opthash)
+   {
+      for(int i = 0; sec->opts[i].name; i++)
+      {
+         const char *optname = sec->opts[i].name;
+
+         if(!(nocase ? strncasecmp(optname, name, len) : 
+                       strncmp(optname, name, len)) && !optname[len])
+            return &sec->opts[i];
+      }
       return 0;
-   
-   r = ecalloc(char *, 1, n + 1);
-   strncpy(r, s, n);
-   r[n] = 0;
-   return r;
+   }
+
+   cfg_opthash_t *hash = sec->opthash;
+   unsigned int   slot = cfg_hashname(name, len) & hash->mask;
+   int            index;
+
+   while((index = hash->slots[slot]))
+   {
+      const char *optname = sec->opts[index - 1].name;
+
+      if(!(nocase ? strncasecmp(optname, name, len) : 
+                    strncmp(optname, name, len)) && !optname[len])
+         return &sec->opts[index - 1];
+
+      slot = (slot + 1) & hash->mask;
+   }
+
+   return 0;
 }
 
 //=============================================================================
@@ -107,28 +212,28 @@ static char *cfg_strndup(const char *s, size_t n)
 
 cfg_opt_t *cfg_getopt(cfg_t *cfg, const char *name)
 {
-   int i;
    cfg_t *sec = cfg;
+   cfg_opt_t *opt;
    
    cfg_assert(cfg && cfg->name && name);
 
    // haleyjd 07/11/03: from CVS, traverses subsections
    while(name && *name)
    {
-      char *secname;
       size_t len = strcspn(name, "|");
 
       if(name[len] == 0) /* no more subsections */
          break;
       if(len)
       {
-         secname = cfg_strndup(name, len);
-         sec = cfg_getsec(sec, secname);
-         if(sec == 0)
-            cfg_error(cfg, "no such option '%s'\n", secname);
-         efree(secname);
-         if(sec == 0)
+         if(!(opt = cfg_findopt(sec, name, len)))
+         {
+            cfg_error(cfg, "no such option '%.*s'\n", (int)len, name);
             return 0;
+         }
+         cfg_assert(opt->type == CFGT_SEC);
+         cfg_assert(opt->values && opt->nvalues);
+         sec = opt->values[0]->section;
       }
       name += len;
       name += strspn(name, "|");
@@ -138,19 +243,9 @@ cfg_opt_t *cfg_getopt(cfg_t *cfg, const char *name)
    if(name[0] == '+' || name[0] == '-')
       ++name; // skip past it for lookup
    
-   for(i = 0; sec->opts[i].name; i++)
-   {
-      if(is_set(CFGF_NOCASE, sec->flags))
-      {
-         if(strcasecmp(sec->opts[i].name, name) == 0)
-            return &sec->opts[i];
-      } 
-      else 
-      {
-         if(strcmp(sec->opts[i].name, name) == 0)
-            return &sec->opts[i];
-      }
-   }
+   if((opt = cfg_findopt(sec, name, strlen(name))))
+      return opt;
+
    cfg_error(cfg, "no such option '%s'\n", name);
    return 0;
 }
@@ -436,12 +531,82 @@ cfg_t *cfg_gettitleprops(cfg_t *cfg)
 // Internal Value Maintenance
 //
 
+//
+// Values are carved out of large blocks instead of being allocated one at a
+// time. Freed values go onto a free list, and the blocks are returned to the
+// zone once no values are in use, which normally happens when the last cfg_t
+// is freed.
+//
+
+#define CFG_VALUESPERBLOCK 1024
+
+struct cfg_valueblock_t
+{
+   cfg_valueblock_t *next;
+   cfg_value_t       values[CFG_VALUESPERBLOCK];
+};
+
+static cfg_valueblock_t *cfg_valueblocks;
+static unsigned int      cfg_blockvaluesused; // values used from newest block
+static cfg_value_t      *cfg_freevalues;
+static unsigned int      cfg_numlivevalues;
+
+static cfg_value_t *cfg_newval()
+{
+   cfg_value_t *val;
+
+   if(cfg_freevalues)
+   {
+      val = cfg_freevalues;
+      cfg_freevalues = val->nextfree;
+   }
+   else
+   {
+      if(!cfg_valueblocks || cfg_blockvaluesused == CFG_VALUESPERBLOCK)
+      {
+         cfg_valueblock_t *block = emalloc(cfg_valueblock_t *, sizeof(*block));
+         block->next = cfg_valueblocks;
+         cfg_valueblocks = block;
+         cfg_blockvaluesused = 0;
+      }
+      val = &cfg_valueblocks->values[cfg_blockvaluesused++];
+   }
+
+   memset(val, 0, sizeof(*val));
+   ++cfg_numlivevalues;
+
+   return val;
+}
+
+static void cfg_freeval(cfg_value_t *val)
+{
+   val->nextfree = cfg_freevalues;
+   cfg_freevalues = val;
+
+   if(--cfg_numlivevalues == 0)
+   {
+      while(cfg_valueblocks)
+      {
+         cfg_valueblock_t *next = cfg_valueblocks->next;
+         efree(cfg_valueblocks);
+         cfg_valueblocks = next;
+      }
+      cfg_freevalues = 0;
+   }
+}
+
 static cfg_value_t *cfg_addval(cfg_opt_t *opt)
 {
-   opt->values = erealloc(cfg_value_t **, opt->values,
-                          (opt->nvalues+1) * sizeof(cfg_value_t *));
+   // The values array grows in powers of two, so it is full exactly when
+   // nvalues is zero or a power of two.
+   if(!(opt->nvalues & (opt->nvalues - 1)))
+   {
+      opt->values = erealloc(cfg_value_t **, opt->values,
+                             (opt->nvalues ? opt->nvalues * 2 : 1) * 
+                             sizeof(cfg_value_t *));
+   }
    cfg_assert(opt->values);
-   opt->values[opt->nvalues] = estructalloc(cfg_value_t, 1);
+   opt->values[opt->nvalues] = cfg_newval();
    return opt->values[opt->nvalues++];
 }
 
@@ -599,6 +764,7 @@ cfg_value_t *cfg_setopt(cfg_t *cfg, cfg_opt_t *opt, const char *value)
       val->section->namealloc = estrdup(opt->name); // haleyjd 04/14/11
       val->section->name      = val->section->namealloc;
       val->section->opts      = cfg_dupopts(opt->subopts);
+      val->section->opthash   = cfg_getopthash(opt->subopts);
       val->section->flags     = cfg->flags;
       val->section->flags    |= CFGF_ALLOCATED;
       val->section->filename  = cfg->filename;
@@ -669,7 +835,7 @@ void cfg_free_value(cfg_opt_t *opt)
          efree(opt->values[i]->string);
       else if(opt->type == CFGT_SEC || opt->type == CFGT_MVPROP) // haleyjd
          cfg_free(opt->values[i]->section);
-      efree(opt->values[i]);
+      cfg_freeval(opt->values[i]);
    }
    efree(opt->values);
    opt->values = 0;
@@ -1411,6 +1577,7 @@ cfg_t *cfg_init(cfg_opt_t *opts, cfg_flag_t flags)
    cfg->errfunc  = 0;
    cfg->lexfunc  = 0;    // haleyjd
    cfg->lookfor  = NULL; // haleyjd
+   cfg->opthash  = cfg_getopthash(opts);
 
    // haleyjd: removed ENABLE_NLS
 
@@ -91,6 +91,7 @@ enum cfg_dialect_t
 
 union  cfg_value_t;
 struct cfg_opt_t;
+struct cfg_opthash_t;
 struct cfg_t;
 
 typedef int cfg_flag_t;
@@ -180,6 +181,8 @@ struct cfg_t
                                 * when initially opening a file. */
    const char *lookfor;    /**< Name of a function to look for. */
    cfg_t *displaced;       /**< haleyjd: pointer to a displaced section */
+   cfg_opthash_t *opthash; /**< Name lookup table for opts, shared by all
+                                * sections built from the same options */
 };
 
 /** 
@@ -192,6 +195,7 @@ union cfg_value_t
    bool   boolean;     /**< boolean value */
    char  *string;      /**< string value */
    cfg_t *section;     /**< section value */
+   cfg_value_t *nextfree; /**< link in the list of free values */
 };
 
 /** 
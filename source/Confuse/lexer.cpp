@@ -116,6 +116,36 @@ static char *lexer_buffer_file(DWFILE *dwfile, size_t *len)
    return buffer;
 }
 
+//
+// In-place tokens
+//
+// Most tokens need no unescaping, so rather than being copied out they are
+// returned as pointers into the buffer, terminated by overwriting the
+// character just past them. That character is put back when the lexer is next
+// called, before anything else reads the buffer; mytext is only ever valid
+// until then anyway.
+//
+static char *pendingpos;  // where the last in-place token was terminated
+static char  pendingchar; // the character that was there
+
+static void lexer_restore()
+{
+   if(pendingpos)
+   {
+      *pendingpos = pendingchar;
+      pendingpos  = NULL;
+   }
+}
+
+static const char *lexer_terminate(char *start, char *end)
+{
+   pendingpos  = end;
+   pendingchar = *end;
+   *end = '\0';
+
+   return start;
+}
+
 static void lexer_free_buffer()
 {
    if(lexbuffer)
@@ -170,6 +200,9 @@ void lexer_reset()
    // free qstring buffer
    qstr.freeBuffer();
 
+   // the buffer holding any in-place token is being thrown away
+   pendingpos = NULL;
+
    // ensure that buffer state is reset
    lexer_free_buffer();
 }
@@ -444,18 +477,29 @@ static int lexer_state_stringcoalesce(lexerstate_t *ls)
 }
 
 //
-// lexer_state_unquotedstring
+// lexer_unquoted_end
 //
-static int lexer_state_unquotedstring(lexerstate_t *ls)
+// Returns true if the character ends an unquoted string.
+//
+static bool lexer_unquoted_end(char c)
 {
-   char c = ls->c;
-
-   if((!unquoted_spaces && (c == ' ' || c == '\t'))       || 
+   return 
+      (!unquoted_spaces && (c == ' ' || c == '\t'))       || 
       (currentDialect >= CFG_DIALECT_ALFHEIM && c == ':') ||
       c == '"'  || c == '\'' || c == '\n' || c == '='     || 
       c == '{'  || c == '}'  || c == '('  || c == ')'     || 
       c == '+'  || c == ','  || c == '#'  || c == '/'     || 
-      c == ';')
+      c == ';';
+}
+
+//
+// lexer_state_unquotedstring
+//
+static int lexer_state_unquotedstring(lexerstate_t *ls)
+{
+   char c = ls->c;
+
+   if(lexer_unquoted_end(c))
    {
       // any special character ends an unquoted string
       --bufferpos; // put it back
@@ -509,6 +553,129 @@ static int lexer_state_heredoc(lexerstate_t *ls)
    }
 }
 
+//
+// lexer_scan_unquoted
+//
+// Scans an unquoted string whose first character has just been read. If it
+// ends cleanly it is returned in place; otherwise what was scanned so far is
+// copied to qstr and the state machine carries on from there.
+//
+static int lexer_scan_unquoted(lexerstate_t *ls)
+{
+   char *start = bufferpos - 1;
+   char *end   = bufferpos;
+
+   while(*end && *end != '\r' && !lexer_unquoted_end(*end))
+      ++end;
+
+   if(*end == '\r')
+   {
+      char *next = end;
+
+      while(*next == '\r')
+         ++next;
+
+      // a \r inside the string is dropped, which needs a copy
+      if(*next && !lexer_unquoted_end(*next))
+      {
+         qstr.copy(start, end - start);
+         bufferpos = end;
+         ls->state = STATE_UNQUOTEDSTRING;
+         return -1;
+      }
+   }
+
+   bufferpos = end;
+   mytext = lexer_terminate(start, end);
+
+   return CFGT_STR;
+}
+
+//
+// lexer_scan_quoted
+//
+// Scans a quoted string whose opening quote has just been read. Strings with
+// escapes or line breaks, and strings followed by another string literal to
+// coalesce with, go through the state machine.
+//
+static int lexer_scan_quoted(lexerstate_t *ls)
+{
+   char  quote = ls->c;
+   char *start = bufferpos;
+   char *end   = bufferpos;
+   char *next;
+
+   ls->stringtype = (quote == '\'' ? 2 : 1);
+
+   while(*end && *end != quote && *end != '\\' && *end != '\n' && *end != '\r')
+      ++end;
+
+   if(*end != quote)
+   {
+      qstr.copy(start, end - start);
+      bufferpos = end;
+      ls->state = STATE_STRING;
+      return -1;
+   }
+
+   next = end + 1;
+   while(*next == ' ' || *next == '\t' || *next == '\n' || *next == '\r')
+      ++next;
+
+   if(*next == '"' || *next == '\'')
+   {
+      qstr.copy(start, end - start);
+      bufferpos = end + 1;
+      ls->state = STATE_STRINGCOALESCE;
+      return -1;
+   }
+
+   for(char *p = end + 1; p < next; p++)
+   {
+      if(*p == '\n')
+         ls->cfg->line++;
+   }
+
+   bufferpos = next;
+   mytext = lexer_terminate(start, end);
+
+   return CFGT_STR;
+}
+
+//
+// lexer_scan_heredoc
+//
+// Scans a heredoc string whose opening delimiter has just been read. Only a
+// heredoc containing \r characters, which are dropped, needs a copy.
+//
+static int lexer_scan_heredoc(lexerstate_t *ls)
+{
+   char  quote = (ls->heredoctype == HEREDOC_SINGLE ? '\'' : '"');
+   char *start = bufferpos;
+   char *end   = bufferpos;
+   int   lines = 0;
+
+   while(*end && *end != '\r' && !(*end == quote && end[1] == '@'))
+   {
+      if(*end == '\n')
+         ++lines;
+      ++end;
+   }
+
+   if(*end != quote)
+   {
+      qstr.clear();
+      ls->state = STATE_HEREDOC;
+      return -1;
+   }
+
+   ls->cfg->line += lines;
+   bufferpos = end + 2;
+   mytext = lexer_terminate(start, end);
+
+   return CFGT_STR;
+}
+
 //
 // lexer_state_none
 //
@@ -568,9 +735,7 @@ static int lexer_state_none(lexerstate_t *ls)
       if(*bufferpos != '=') // look ahead to next character
       {
          // if not '=', start an unquoted string
-         qstr.clear();
-         qstr += ls->c;
-         ls->state = STATE_UNQUOTEDSTRING;
+         ret = lexer_scan_unquoted(ls);
       }
       else
       {
@@ -583,15 +748,9 @@ static int lexer_state_none(lexerstate_t *ls)
       mytext = ",";
       ret = ',';
       break;
-   case '"': // open double-quoted string
-      qstr.clear();
-      ls->state = STATE_STRING;
-      ls->stringtype = 1;
-      break;
+   case '"':  // open double-quoted string
    case '\'': // open single-quoted string
-      qstr.clear();
-      ls->state = STATE_STRING;
-      ls->stringtype = 2;
+      ret = lexer_scan_quoted(ls);
       break;
    case '@': // possibly open heredoc string
       if(*bufferpos == '"' || *bufferpos == '\'') // look ahead to next character
@@ -607,8 +766,7 @@ static int lexer_state_none(lexerstate_t *ls)
             break;
          }
          ++bufferpos; // move past secondary delimiter character
-         qstr.clear();
-         ls->state = STATE_HEREDOC;
+         ret = lexer_scan_heredoc(ls);
          break;
       }
       // fall through, @ is not special unless followed by " or '
@@ -619,11 +777,7 @@ static int lexer_state_none(lexerstate_t *ls)
          ret    = ':'; 
       }
       else
-      {
-         qstr.clear();
-         qstr += ls->c;
-         ls->state = STATE_UNQUOTEDSTRING;
-      }
+         ret = lexer_scan_unquoted(ls);
       break;
    }
 
@@ -659,6 +813,9 @@ int mylex(cfg_t *cfg)
    ls.stringtype = 0;
    ls.cfg        = cfg;
 
+   // put back the character overwritten by the last in-place token
+   lexer_restore();
+
 include:
    while((ls.c = *bufferpos++))
    {
@@ -1008,6 +1008,9 @@ static void ACS_setLineBlocking(int tag, int block)
    line_t *l;
    int linenum = -1;
 
+   // blocking everything also blocks sight
+   P_SightWorldChanged();
+
    while((l = P_FindLine(tag, &linenum)) != NULL)
    {
       switch(block)
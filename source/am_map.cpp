@@ -23,6 +23,7 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
 #include "z_zone.h"
 #include "i_system.h"
 
@@ -39,10 +40,14 @@
 #include "e_inventory.h"
 #include "ev_specials.h"
 #include "g_bind.h"
+#include "m_bbox.h"
+#include "m_collection.h"
+#include "m_compare.h"
 #include "p_maputl.h"
 #include "p_portal.h"
 #include "p_setup.h"
 #include "p_spec.h"
+#include "polyobj.h"
 #include "st_stuff.h"
 #include "r_draw.h"
 #include "r_dynseg.h"
@@ -1227,11 +1232,11 @@ static bool AM_clipMline(mline_t *ml, fline_t *fl)
 //
 static void AM_drawFline(fline_t *fl, int color )
 {
-   int x,  y;
+   byte *dest;
    int dx, dy;
    int sx, sy;
    int ax, ay;
-   int d;
+   int d, count;
 
 #ifdef RANGECHECK         // killough 2/22/98    
    //static int fuck = 0;
@@ -1250,44 +1255,55 @@ static void AM_drawFline(fline_t *fl, int color )
 
    dx = fl->b.x - fl->a.x;
    ax = 2 * (dx < 0 ? -dx : dx);
-   sx = dx < 0 ? -1 : 1;
+   sx = dx < 0 ? -vbscreen.pixelsize : vbscreen.pixelsize;
    
    dy = fl->b.y - fl->a.y;
    ay = 2 * (dy < 0 ? -dy : dy);
-   sy = dy < 0 ? -1 : 1;
+   sy = dy < 0 ? -vbscreen.pitch : vbscreen.pitch;
 
-   x = fl->a.x;
-   y = fl->a.y;
+   // step through the framebuffer directly rather than recomputing the
+   // address of every dot
+   dest = VBADDRESS(&vbscreen, fl->a.x, fl->a.y);
    
    if(ax > ay)
    {
+      count = ax / 2;
+
+      // horizontal lines are filled in one go
+      if(!ay && vbscreen.pixelsize == 1)
+      {
+         memset(dx < 0 ? dest - count : dest, color, count + 1);
+         return;
+      }
+
       d = ay - ax/2;
       while(1)
       {
-         PUTDOT(x, y, color);
-         if(x == fl->b.x) return;
+         *dest = color;
+         if(!count--) return;
          if(d >= 0)
          {
-            y += sy;
+            dest += sy;
             d -= ax;
          }
-         x += sx;
+         dest += sx;
          d += ay;
       }
    }
    else
    {
+      count = ay / 2;
       d = ax - ay/2;
       while(1)
       {
-         PUTDOT(x, y, color);
-         if(y == fl->b.y) return;
+         *dest = color;
+         if(!count--) return;
          if(d >= 0)
          {
-            x += sx;
+            dest += sx;
             d -= ay;
          }
-         y += sy;
+         dest += sy;
          d += ax;
       }
    }
@@ -1298,9 +1314,8 @@ static void AM_drawFline(fline_t *fl, int color )
 //
 // haleyjd 06/13/09: Pixel plotter for Wu line drawing.
 //
-static void AM_putWuDot(int x, int y, int color, int weight)
+inline static void AM_putWuDot(byte *dest, int color, int weight)
 {
-   byte *dest = VBADDRESS(&vbscreen, x, y);
    unsigned int *fg2rgb = Col2RGB8[weight];
    unsigned int *bg2rgb = Col2RGB8[64 - weight];
    unsigned int fg, bg;
@@ -1330,7 +1345,8 @@ static void AM_putWuDot(int x, int y, int color, int weight)
 static void AM_drawFlineWu(fline_t *fl, int color)
 {
    int dx, dy, xdir = 1;
-   int x, y;   
+   int xstep, ystep;
+   byte *dest;
 
    // swap end points if necessary
    if(fl->a.y > fl->b.y)
@@ -1360,10 +1376,11 @@ static void AM_drawFlineWu(fline_t *fl, int color)
    }
 
    // draw first pixel
-   PUTDOT(fl->a.x, fl->a.y, color);
+   dest = VBADDRESS(&vbscreen, fl->a.x, fl->a.y);
+   *dest = color;
 
-   x = fl->a.x;
-   y = fl->a.y;
+   xstep = xdir * vbscreen.pixelsize;
+   ystep = vbscreen.pitch;
 
    if(dy > dx)
    {
@@ -1379,14 +1396,14 @@ static void AM_drawFlineWu(fline_t *fl, int color)
 
          // if error has overflown, advance x coordinate
          if(erroracc <= erroracctmp)
-            x += xdir;
+            dest += xstep;
          
-         y += 1; // advance y
+         dest += ystep; // advance y
 
          // the trick is in the trig!
-         AM_putWuDot(x, y, color, 
+         AM_putWuDot(dest, color, 
                      finecosine[erroracc >> wu_fineshift] >> wu_fixedshift);
-         AM_putWuDot(x + xdir, y, color, 
+         AM_putWuDot(dest + xstep, color, 
                      finesine[erroracc >> wu_fineshift] >> wu_fixedshift);
       }
    }
@@ -1404,14 +1421,14 @@ static void AM_drawFlineWu(fline_t *fl, int color)
 
          // if error has overflown, advance y coordinate
          if(erroracc <= erroracctmp)
-            y += 1;
+            dest += ystep;
          
-         x += xdir; // advance x
+         dest += xstep; // advance x
 
          // the trick is in the trig!
-         AM_putWuDot(x, y, color, 
+         AM_putWuDot(dest, color, 
                      finecosine[erroracc >> wu_fineshift] >> wu_fixedshift);
-         AM_putWuDot(x, y + 1, color, 
+         AM_putWuDot(dest + ystep, color, 
                      finesine[erroracc >> wu_fineshift] >> wu_fixedshift);
       }
    }
@@ -1623,6 +1640,297 @@ inline static bool AM_drawAsClosedDoor(line_t *line)
            AM_isDoorClosed(line));
 }
 
+//=============================================================================
+//
+// Spatial Index
+//
+// Lines and sectors are bucketed by their bounding boxes into a coarse grid,
+// built the first time the automap is drawn on a level, so that drawing only
+// has to look at what lies near the visible window.
+//
+
+#define AM_GRIDSHIFT 9 // 512 map units per cell
+
+// things are drawn with markers scaled to 16 units around their position
+#define AM_THINGMARGIN 32.0
+
+struct amgrid_t
+{
+   int  orgx, orgy;    // lower-left corner of the grid, in map units
+   int  width, height; // dimensions in cells
+   int *cellstart;     // width*height+1 offsets into items
+   int *items;         // line or sector numbers, ascending within each cell
+   int *always;        // numbers without a fixed position, checked every time
+   int  numalways;
+};
+
+// returns false if the item has no fixed bounding box
+typedef bool (*amgridbox_t)(int num, fixed_t *box);
+
+// returns the portal group of an item
+typedef int (*amgridgroup_t)(int num);
+
+static amgrid_t am_linegrid;
+static amgrid_t am_sectorgrid;
+
+// item numbers found by grid queries; sorted but may contain duplicates
+static PODCollection<int> am_visible;
+
+// marks polyobject lines while building the line grid
+static bool *am_polylines;
+
+//
+// AM_gridCoord
+//
+// Returns the clamped cell coordinate for a map coordinate relative to the
+// grid origin.
+//
+static int AM_gridCoord(double v, int size)
+{
+   return (int)eclamp(floor(v / (1 << AM_GRIDSHIFT)), 0.0, size - 1.0);
+}
+
+//
+// AM_gridCells
+//
+// Finds the range of grid cells covering a map-space box.
+//
+static void AM_gridCells(const amgrid_t &grid, double x1, double y1,
+                         double x2, double y2, 
+                         int &cx1, int &cy1, int &cx2, int &cy2)
+{
+   cx1 = AM_gridCoord(x1 - grid.orgx, grid.width);
+   cx2 = AM_gridCoord(x2 - grid.orgx, grid.width);
+   cy1 = AM_gridCoord(y1 - grid.orgy, grid.height);
+   cy2 = AM_gridCoord(y2 - grid.orgy, grid.height);
+}
+
+//
+// AM_boxCells
+//
+static void AM_boxCells(const amgrid_t &grid, const fixed_t *box,
+                        int &cx1, int &cy1, int &cx2, int &cy2)
+{
+   AM_gridCells(grid, M_FixedToDouble(box[BOXLEFT]), 
+                M_FixedToDouble(box[BOXBOTTOM]),
+                M_FixedToDouble(box[BOXRIGHT]), 
+                M_FixedToDouble(box[BOXTOP]), cx1, cy1, cx2, cy2);
+}
+
+//
+// AM_buildGrid
+//
+static void AM_buildGrid(amgrid_t &grid, int count, amgridbox_t getbox)
+{
+   fixed_t box[4];
+   int minx = D_MAXINT, miny = D_MAXINT, maxx = D_MININT, maxy = D_MININT;
+   int i, cell, numcells, total, numalways = 0;
+   int cx1, cy1, cx2, cy2, cx, cy;
+   int *cursors;
+
+   // find the extent of everything with a bounding box
+   for(i = 0; i < count; i++)
+   {
+      if(!getbox(i, box))
+         continue;
+
+      minx = emin(minx, box[BOXLEFT  ] >> FRACBITS);
+      maxx = emax(maxx, box[BOXRIGHT ] >> FRACBITS);
+      miny = emin(miny, box[BOXBOTTOM] >> FRACBITS);
+      maxy = emax(maxy, box[BOXTOP   ] >> FRACBITS);
+   }
+
+   if(minx > maxx || miny > maxy)
+      minx = maxx = miny = maxy = 0;
+
+   grid.orgx   = minx;
+   grid.orgy   = miny;
+   grid.width  = ((maxx - minx) >> AM_GRIDSHIFT) + 1;
+   grid.height = ((maxy - miny) >> AM_GRIDSHIFT) + 1;
+
+   numcells = grid.width * grid.height;
+   cursors  = ecalloc(int *, numcells + 1, sizeof(int));
+
+   // count the items falling into each cell
+   for(i = 0; i < count; i++)
+   {
+      if(!getbox(i, box))
+      {
+         ++numalways;
+         continue;
+      }
+
+      AM_boxCells(grid, box, cx1, cy1, cx2, cy2);
+      for(cy = cy1; cy <= cy2; cy++)
+         for(cx = cx1; cx <= cx2; cx++)
+            ++cursors[cy * grid.width + cx + 1];
+   }
+
+   // convert counts to starting offsets
+   for(cell = 0; cell < numcells; cell++)
+      cursors[cell + 1] += cursors[cell];
+   total = cursors[numcells];
+
+   Z_Malloc((numcells + 1 + total + numalways) * sizeof(int), PU_LEVEL, 
+            (void **)&grid.cellstart);
+   memcpy(grid.cellstart, cursors, (numcells + 1) * sizeof(int));
+   grid.items     = grid.cellstart + numcells + 1;
+   grid.always    = grid.items + total;
+   grid.numalways = 0;
+
+   // fill in the cells in ascending order
+   for(i = 0; i < count; i++)
+   {
+      if(!getbox(i, box))
+      {
+         grid.always[grid.numalways++] = i;
+         continue;
+      }
+
+      AM_boxCells(grid, box, cx1, cy1, cx2, cy2);
+      for(cy = cy1; cy <= cy2; cy++)
+         for(cx = cx1; cx <= cx2; cx++)
+            grid.items[cursors[cy * grid.width + cx]++] = i;
+   }
+
+   efree(cursors);
+}
+
+//
+// AM_lineBox
+//
+static bool AM_lineBox(int num, fixed_t *box)
+{
+   if(am_polylines && am_polylines[num])
+      return false; // polyobject lines move around
+
+   memcpy(box, lines[num].bbox, sizeof(lines[num].bbox));
+   return true;
+}
+
+//
+// AM_sectorBox
+//
+// Sector bounding boxes are taken from their lines.
+//
+static bool AM_sectorBox(int num, fixed_t *box)
+{
+   const sector_t &sector = sectors[num];
+
+   if(!sector.linecount)
+      return false;
+
+   M_ClearBox(box);
+   for(int i = 0; i < sector.linecount; i++)
+   {
+      const line_t *line = sector.lines[i];
+      M_AddToBox(box, line->bbox[BOXLEFT],  line->bbox[BOXBOTTOM]);
+      M_AddToBox(box, line->bbox[BOXRIGHT], line->bbox[BOXTOP]);
+   }
+   return true;
+}
+
+static int AM_lineGroup(int num)   { return lines[num].frontsector->groupid; }
+static int AM_sectorGroup(int num) { return sectors[num].groupid;            }
+
+//
+// AM_checkGrids
+//
+// Builds the spatial index for the current level if it does not exist yet.
+// The grids are PU_LEVEL and are discarded along with the level.
+//
+static void AM_checkGrids()
+{
+   if(!am_linegrid.cellstart)
+   {
+      am_polylines = ecalloc(bool *, numlines, sizeof(bool));
+      for(int i = 0; i < numPolyObjects; i++)
+      {
+         for(int j = 0; j < PolyObjects[i].numLines; j++)
+            am_polylines[PolyObjects[i].lines[j] - lines] = true;
+      }
+
+      AM_buildGrid(am_linegrid, numlines, AM_lineBox);
+
+      efree(am_polylines);
+      am_polylines = NULL;
+   }
+
+   if(!am_sectorgrid.cellstart)
+      AM_buildGrid(am_sectorgrid, numsectors, AM_sectorBox);
+}
+
+//
+// AM_queryGrid
+//
+// Adds to am_visible the items in the grid which may be visible in the
+// automap window, extended by margin, when drawn displaced by the given link
+// offset. If group is not negative, only items in that portal group are
+// added.
+//
+static void AM_queryGrid(const amgrid_t &grid, const linkoffset_t *link,
+                         double margin, int group, amgridgroup_t getgroup)
+{
+   double dx = link ? M_FixedToDouble(link->x) : 0.0;
+   double dy = link ? M_FixedToDouble(link->y) : 0.0;
+   int cx1, cy1, cx2, cy2;
+
+   AM_gridCells(grid, m_x - margin - dx, m_y - margin - dy, 
+                m_x2 + margin - dx, m_y2 + margin - dy, cx1, cy1, cx2, cy2);
+
+   for(int cy = cy1; cy <= cy2; cy++)
+   {
+      for(int cx = cx1; cx <= cx2; cx++)
+      {
+         int cell = cy * grid.width + cx;
+
+         for(int i = grid.cellstart[cell]; i < grid.cellstart[cell + 1]; i++)
+         {
+            if(group < 0 || getgroup(grid.items[i]) == group)
+               am_visible.add(grid.items[i]);
+         }
+      }
+   }
+
+   for(int i = 0; i < grid.numalways; i++)
+   {
+      if(group < 0 || getgroup(grid.always[i]) == group)
+         am_visible.add(grid.always[i]);
+   }
+}
+
+//
+// AM_queryGroups
+//
+// Queries a grid once for each portal group other than skipgroup, using that
+// group's offset into the automap's coordinate space.
+//
+static void AM_queryGroups(const amgrid_t &grid, double margin, int skipgroup,
+                           amgridgroup_t getgroup)
+{
+   int numgroups = P_PortalGroupCount();
+
+   for(int group = 0; group < numgroups; group++)
+   {
+      if(group != skipgroup)
+      {
+         AM_queryGrid(grid, group > 0 ? P_GetLinkOffset(group, 0) : NULL, 
+                      margin, group, getgroup);
+      }
+   }
+}
+
+//
+// AM_sortVisible
+//
+// Puts the results of grid queries back into level order, which is the
+// order everything was drawn in when the whole level was scanned.
+//
+static void AM_sortVisible()
+{
+   std::sort(am_visible.begin(), am_visible.end());
+}
+
 //
 // Determines visible lines, draws them.
 // This is LineDef based, not LineSeg based.
@@ -1641,21 +1949,29 @@ inline static bool AM_drawAsClosedDoor(line_t *line)
 //
 static void AM_drawWalls()
 {
-   int i;
+   int prev;
    static mline_t l;
    
    int plrgroup = plr->mo->groupid;
 
+   AM_checkGrids();
+
    // Draw overlay lines first so they will not obscure the (more important)
    // normal map lines
    if(mapportal_overlay && useportalgroups)
    {
-      for(i = 0; i < numlines; ++i)
-      {
-         line_t *line = &lines[i];
+      am_visible.makeEmpty();
+      AM_queryGroups(am_linegrid, 0.0, plrgroup, AM_lineGroup);
+      AM_sortVisible();
 
-         if(line->frontsector->groupid == plrgroup)
+      prev = -1;
+      for(int i : am_visible)
+      {
+         if(i == prev)
             continue;
+         prev = i;
+
+         line_t *line = &lines[i];
 
          l.a.x = line->v1->fx;
          l.a.y = line->v1->fy;
@@ -1702,9 +2018,25 @@ static void AM_drawWalls()
       }
    }
 
+   // find the lines near the window
+   am_visible.makeEmpty();
+   if(mapportal_overlay && useportalgroups)
+   {
+      AM_queryGrid(am_linegrid, plrgroup > 0 ? P_GetLinkOffset(plrgroup, 0) : NULL,
+                   0.0, plrgroup, AM_lineGroup);
+   }
+   else
+      AM_queryGrid(am_linegrid, NULL, 0.0, -1, NULL);
+   AM_sortVisible();
+
    // draw the unclipped visible portions of all lines
-   for(i = 0; i < numlines; i++)
+   prev = -1;
+   for(int i : am_visible)
    {
+      if(i == prev)
+         continue;
+      prev = i;
+
       line_t *line = &lines[i];
 
       l.a.x = line->v1->fx;
@@ -2114,10 +2446,25 @@ static void AM_drawPlayers()
 static void AM_drawThings(int colors, int colorrange)
 {
    fixed_t tx, ty; // SoM: Moved thing coords to variables for linked portals
+   int prev = -1;
+
+   AM_checkGrids();
+
+   // find the sectors near the window, allowing for the size of the markers
+   am_visible.makeEmpty();
+   if(mapportal_overlay && useportalgroups)
+      AM_queryGroups(am_sectorgrid, AM_THINGMARGIN, -1, AM_sectorGroup);
+   else
+      AM_queryGrid(am_sectorgrid, NULL, AM_THINGMARGIN, -1, NULL);
+   AM_sortVisible();
    
-   // for all sectors
-   for(int i = 0; i < numsectors; i++)
+   // for all sectors near the window
+   for(int i : am_visible)
    {
+      if(i == prev)
+         continue;
+      prev = i;
+
       Mobj *t = sectors[i].thinglist;
 
       while(t) // for all things in that sector
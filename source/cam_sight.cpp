@@ -76,6 +76,7 @@
 #include "p_setup.h"
 #include "p_skin.h"     // ioanch 20160131: for use
 #include "p_spec.h"     // ioanch 20160101: for bullet effects
+#include "p_valid.h"
 #include "polyobj.h"
 #include "r_pcheck.h"   // ioanch 20160109: for correct portal plane z
 #include "r_defs.h"
@@ -85,12 +86,6 @@
 #include "r_state.h"
 #include "s_sound.h"    // ioanch 20160131: for use
 
-// ioanch 20151230: defined macros for the validcount sets here
-#define VALID_ALLOC(set, n) ((set) = ecalloc(byte *, 1, (((n) + 7) & ~7) / 8))
-#define VALID_FREE(set) efree(set)
-#define VALID_ISSET(set, i) ((set)[(i) >> 3] & (1 << ((i) & 7)))
-#define VALID_SET(set, i) ((set)[(i) >> 3] |= 1 << ((i) & 7))
-
 #define RECURSION_LIMIT 64
 
 //=============================================================================
@@ -232,15 +227,13 @@ class PathTraverser
 public:
    bool traverse(fixed_t cx, fixed_t cy, fixed_t tx, fixed_t ty);
    PathTraverser(const PTDef &indef, void *incontext) : 
-      trace(), def(indef), context(incontext), portalguard()
+      trace(), def(indef), context(incontext), 
+      valid(ValidContext::Acquire()), portalguard()
    {
-      VALID_ALLOC(validlines, ::numlines);
-      VALID_ALLOC(validpolys, ::numPolyObjects);
    }
    ~PathTraverser()
    {
-      VALID_FREE(validlines);
-      VALID_FREE(validpolys);
+      ValidContext::Release(valid);
    }
 
    divline_t trace;
@@ -252,8 +245,7 @@ private:
 
    const PTDef def;
    void *const context;
-   byte *validlines;
-   byte *validpolys;
+   ValidContext *const valid; // own marks, as traversals may nest
    struct
    {
       bool hitpblock;
@@ -392,7 +384,7 @@ bool PathTraverser::checkLine(size_t linenum)
    int s1, s2;
    divline_t dl;
 
-   VALID_SET(validlines, linenum);
+   valid->markLine(ld);
 
    s1 = P_PointOnDivlineSide(ld->v1->x, ld->v1->y, &trace);
    s2 = P_PointOnDivlineSide(ld->v2->x, ld->v2->y, &trace);
@@ -471,18 +463,13 @@ bool PathTraverser::blockLinesIterator(int x, int y)
    while(plink)
    {
       polyobj_t *po = (*plink)->po;
-      int polynum = po - PolyObjects;
 
        // if polyobj hasn't been checked
-      if(!VALID_ISSET(validpolys, polynum))
+      if(valid->markPolyobj(po))
       {
-         VALID_SET(validpolys, polynum);
-         
          for(int i = 0; i < po->numLines; ++i)
          {
-            int linenum = po->lines[i] - lines;
-
-            if(VALID_ISSET(validlines, linenum))
+            if(valid->lineMarked(po->lines[i]))
                continue; // line has already been checked
 
             if(!checkLine(po->lines[i] - ::lines))
@@ -506,7 +493,7 @@ bool PathTraverser::blockLinesIterator(int x, int y)
       if(linenum >= numlines)
          continue;
 
-      if(VALID_ISSET(validlines, linenum))
+      if(valid->lineMarked(&lines[linenum]))
          continue; // line has already been checked
 
       if(!checkLine(linenum))
@@ -833,6 +820,13 @@ bool CamContext::sightTraverse(const intercept_t *in, void *vcontext,
 
    CamContext &context = *static_cast<CamContext *>(vcontext);
 
+   if(context.params->sectormask)
+   {
+      *context.params->sectormask |= P_SightSectorBit(li->frontsector);
+      if(li->backsector)
+         *context.params->sectormask |= P_SightSectorBit(li->backsector);
+   }
+
    // avoid round-off errors if possible
    fixed_t totalfrac = context.state.originfrac ? context.state.originfrac +
       FixedMul(in->frac, FRACUNIT - context.state.originfrac) : in->frac;
@@ -1035,6 +1029,7 @@ bool CamContext::recurse(int newfromid, fixed_t x, fixed_t y,
    params.cgroupid = newfromid;
    params.tgroupid = this->params->tgroupid;
    params.prev = this->params;
+   params.sectormask = this->params->sectormask;
 
    *result = checkSight(params, &instate);
    return true;
@@ -1072,6 +1067,15 @@ bool CamContext::checkSight(const camsightparams_t &params,
 
    bool result = false;
 
+   if(params.sectormask)
+   {
+      *params.sectormask |= P_SightSectorBit(csec) | P_SightSectorBit(tsec);
+      if(csec->heightsec != -1)
+         *params.sectormask |= P_SightSectorBit(&sectors[csec->heightsec]);
+      if(tsec->heightsec != -1)
+         *params.sectormask |= P_SightSectorBit(&sectors[tsec->heightsec]);
+   }
+
    if(link || !(rejectmatrix[pnum >> 3] & (1 << (pnum & 7))))
    {
       // killough 4/19/98: make fake floors and ceilings block monster view
@@ -1120,6 +1124,8 @@ bool CamContext::checkSight(const camsightparams_t &params,
          if(link)
          {
             tsec = R_PointInSubsector(tx, ty)->sector;
+            if(params.sectormask)
+               *params.sectormask |= P_SightSectorBit(tsec);
             if(context.checkPortalSector(tsec, FRACUNIT, FRACUNIT, 
                traverser.trace))
             {
@@ -52,6 +52,7 @@ struct camsightparams_t
    int     tgroupid; // target portal groupid
 
    const camsightparams_t *prev; // previous invocation
+   uint64_t *sectormask; // if set, gets P_SightSectorBit of sectors looked at
 
    void setCamera(const camera_t &camera, fixed_t height);
    void setLookerMobj(const Mobj *mo);
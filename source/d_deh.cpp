@@ -1512,6 +1512,14 @@ void deh_procAmmo(DWFILE *fpin, char *line)
       else
          deh_LogPrintf("Invalid ammo string index for '%s'\n", key);
    }
+
+   // refresh the compiled fields of the altered effects
+   if(ammotype)
+      ammotype->compile();
+   if(smallitem)
+      smallitem->compile();
+   if(largeitem)
+      largeitem->compile();
 }
 
 // ====================================================================
@@ -1924,6 +1932,9 @@ void deh_procMisc(DWFILE *fpin, char *line) // done
       else
          deh_LogPrintf("Invalid misc item string index for '%s'\n", key);
    }
+
+   // refresh the compiled fields of any altered item effects
+   E_CompileItemEffects();
 }
 
 // ====================================================================
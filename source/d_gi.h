@@ -319,7 +319,7 @@ struct missioninfo_t
 };
 
 // function pointer types
-typedef int  (*gimusformapfn_t)();
+typedef int  (*gimusformapfn_t)(int episode, int map);
 typedef int  (*gimuscheatfn_t )(const char *);
 typedef void (*ginewgamefn_t  )();
 typedef int  (*gipartimefn_t  )(int, int);
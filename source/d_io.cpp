@@ -34,6 +34,7 @@
 #include "doomtype.h"
 #include "d_io.h"
 #include "d_dwfile.h"
+#include "m_compare.h"
 #include "m_misc.h"
 #include "w_wad.h"
 
@@ -217,15 +218,11 @@ size_t DWFILE::read(void *dest, size_t p_size, size_t p_num)
    else
    {
       size_t numbytes = p_size * p_num;
-      size_t numbytesread = 0;
-      byte *d = (byte *)dest;
-
-      while(numbytesread < numbytes && size)
-      {
-         *d++ = *inp++;
-         size--;
-         numbytesread++;
-      }
+      size_t numbytesread = emin(numbytes, (size_t)size);
+
+      memcpy(dest, inp, numbytesread);
+      inp  += numbytesread;
+      size -= (int)numbytesread;
 
       return numbytesread;
    }
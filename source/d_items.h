@@ -29,7 +29,7 @@
 #include "doomdef.h"
 #include "m_dllist.h"
 
-class MetaTable;
+class ItemEffect;
 
 //
 // haleyjd 09/11/07: weapon flags
@@ -54,7 +54,7 @@ struct weaponinfo_t
    weapontype_t id;           // haleyjd 06/28/13: weapontype id number
    const char  *name;         // haleyjd 06/29/13: name of weapon
 
-   MetaTable   *ammo;         // haleyjd 08/05/13: ammo artifact type
+   ItemEffect  *ammo;         // haleyjd 08/05/13: ammo artifact type
    int          upstate;
    int          downstate;
    int          readystate;
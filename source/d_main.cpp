@@ -47,6 +47,7 @@
 #include "d_io.h"
 #include "d_iwad.h"
 #include "d_net.h"
+#include "d_pacer.h"
 #include "doomstat.h"
 #include "dstrings.h"
 #include "e_edf.h"
@@ -66,9 +67,11 @@
 #include "in_lude.h"
 #include "m_argv.h"
 #include "m_compare.h"
+#include "m_jobs.h"
 #include "m_misc.h"
 #include "m_syscfg.h"
 #include "m_qstr.h"
+#include "m_vidcap.h"
 #include "mn_engin.h"
 #include "p_chase.h"
 #include "p_setup.h"
@@ -651,7 +654,10 @@ void D_Display()
 
       if(inwipe)
       {
-         bool wait = (wipewait == 1 || (wipewait == 2 && demoplayback));
+         // the blocking wipe runs on real time, which doesn't advance
+         // while a demo is being rendered
+         bool wait = !vidcapactive &&
+                     (wipewait == 1 || (wipewait == 2 && demoplayback));
          
          // about to start wiping; if wipewait is enabled, save everything 
          // that was just drawn
@@ -1266,6 +1272,8 @@ static void D_DoomInit()
 
    FindResponseFile(); // Append response file arguments to command-line
 
+   M_InitJobs();       // start the job threads
+
    // haleyjd 08/18/07: set base path and user path
    D_SetBasePath();
    D_SetUserPath();
@@ -1420,7 +1428,7 @@ static void D_DoomInit()
    {
       if((p = M_CheckParm("-fastdemo")) && p < myargc-1)  // killough
          fastdemo = true;            // run at fastest speed possible
-      else
+      else if(!(p = M_CheckParm("-renderdemo")) || p >= myargc-1)
          p = M_CheckParm("-timedemo");
    }
 
@@ -1840,6 +1848,12 @@ static void D_DoomInit()
       G_DeferedPlayDemo(myargv[p]);
       singledemo = true;            // quit after one demo
    }
+   else if((p = M_CheckParm("-renderdemo")) && ++p < myargc)
+   {
+      M_StartVidCap(myargv[p]);     // render to files at a fixed framerate
+      G_DeferedPlayDemo(myargv[p]);
+      singledemo = true;            // quit after one demo
+   }
    else if((p = M_CheckMultiParm(playdemoparms, 1)) && ++p < myargc)
    {
       G_DeferedPlayDemo(myargv[p]);
@@ -1915,6 +1929,9 @@ void D_DoomMain()
    // killough 12/98: inlined D_DoomLoop
    while(1)
    {
+      // wait for the frame's turn if the frame rate is capped
+      D_PaceFrame();
+
       // frame synchronous IO operations
       I_StartFrame();
 
@@ -1926,9 +1943,16 @@ void D_DoomMain()
       // Update display, next frame, with current state.
       D_Display();
 
+      // Capture the frame for -renderdemo; this also advances its clock.
+      if(vidcapactive)
+         M_VidCapFrame();
+
       // Sound mixing for the buffer is synchronous.
       I_UpdateSound();
 
+      // Start any music that has finished loading in the background.
+      I_UpdateMusic();
+
       // Synchronous sound output is explicitly called.
       // Update sound output.
       I_SubmitSound();
@@ -43,6 +43,7 @@
 #include "g_game.h"
 #include "hal/i_timer.h"
 #include "m_random.h"
+#include "m_vidcap.h"
 #include "mn_engin.h"
 #include "i_net.h"
 #include "i_video.h"
@@ -629,6 +630,7 @@ void D_QuitNetGame()
 // haleyjd 01/04/2010
 bool d_fastrefresh;
 bool d_interpolate;
+bool d_liveturn;     // apply mouse turning to the view every frame
 
 int  frametics[4];
 int  frameon;
@@ -684,7 +686,8 @@ static bool RunGameTics()
       counts = availabletics;
   
    // haleyjd 09/07/10: enhanced d_fastrefresh w/early return when no tics to run
-   if(counts <= 0 && d_fastrefresh && !timingdemo) // 10/03/10: not in timedemos!
+   // -renderdemo draws a frame whether or not a tic has elapsed
+   if(counts <= 0 && (d_fastrefresh || vidcapactive) && !timingdemo) // 10/03/10: not in timedemos!
       return false;
 
    if(counts < 1)
@@ -803,6 +806,22 @@ static bool RunGameTics()
    return true;
 }
 
+//
+// D_PendingLocalTurn
+//
+// Sum of the turning in ticcmds the console player has built but which the
+// game hasn't run yet.
+//
+int D_PendingLocalTurn()
+{
+   int turn = 0;
+
+   for(int tic = gametic/ticdup; tic < maketic; tic++)
+      turn += localcmds[tic%BACKUPTICS].angleturn;
+
+   return turn;
+}
+
 void TryRunTics()
 {
    static int oldentertic;
@@ -838,7 +857,7 @@ void TryRunTics()
       // run the game tickers
       game_advanced = RunGameTics();
    } 
-   while(!d_fastrefresh && realtics <= 0 && !game_advanced);
+   while(!(d_fastrefresh || vidcapactive) && realtics <= 0 && !game_advanced);
 }
 
 /////////////////////////////////////////////////////
@@ -886,6 +905,9 @@ CONSOLE_VARIABLE(d_fastrefresh, d_fastrefresh, 0) {}
 VARIABLE_TOGGLE(d_interpolate, NULL, onoff);
 CONSOLE_VARIABLE(d_interpolate, d_interpolate, 0) {}
 
+VARIABLE_TOGGLE(d_liveturn, NULL, onoff);
+CONSOLE_VARIABLE(d_liveturn, d_liveturn, 0) {}
+
 //----------------------------------------------------------------------------
 //
 // $Log: d_net.c,v $
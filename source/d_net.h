@@ -183,8 +183,11 @@ void D_KickPlayer(int playernum);
 // how many ticks to run?
 void TryRunTics();
 
+int D_PendingLocalTurn();
+
 extern bool d_fastrefresh;
 extern bool d_interpolate;
+extern bool d_liveturn;
 extern bool opensocket;
 
 extern ticcmd_t netcmds[][BACKUPTICS];
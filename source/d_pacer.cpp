@@ -0,0 +1,253 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Frame pacing.
+//
+//   With d_fastrefresh on, the main loop draws a frame as often as it can,
+//   whether or not anything has changed. d_maxfps spaces frames out to a fixed
+//   rate instead. Each wait sleeps through most of the time, which the OS may
+//   overrun by a millisecond or more, then spins for the remainder, so frames
+//   start on time without burning a whole core. Every frame is timed whether
+//   or not it is paced; the framestats command reports on recent ones.
+//
+//-----------------------------------------------------------------------------
+
+#include <chrono>
+#include <thread>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "d_net.h"
+#include "d_pacer.h"
+#include "doomstat.h"
+#include "hal/i_timer.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "m_vidcap.h"
+#include "v_misc.h"
+
+#define PACE_HISTORY   512
+#define PACE_MINSLOP   500   // usecs
+#define PACE_MAXSLOP   4000
+
+int d_maxfps;
+
+struct framestat_t
+{
+   int  interval; // usecs from the start of the previous frame to this one
+   int  busy;     // usecs the previous frame spent working
+   int  late;     // usecs this frame started past its deadline
+   bool paced;    // whether the frame had a deadline
+};
+
+static framestat_t  framestats[PACE_HISTORY];
+static unsigned int numframestats; // frames recorded; may exceed PACE_HISTORY
+
+static int64_t framestart;            // when the current frame started
+static int64_t deadline;              // when the current paced frame was due
+static int64_t sleepslop = 1000;      // how far sleeps tend to overrun
+static int64_t totalsleep, totalspin; // time spent waiting each way
+static int64_t statstart;             // when the totals were last reset
+
+//
+// D_usecs
+//
+static int64_t D_usecs()
+{
+   using namespace std::chrono;
+
+   return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+//
+// D_waitUntil
+//
+// Sleeps until close to the given time, then spins the rest of the way. The
+// spin covers sleepslop, which follows how late sleeps actually wake: it
+// rises at once after a long overrun and eases back down otherwise.
+//
+static void D_waitUntil(int64_t when)
+{
+   int64_t now = D_usecs();
+   int64_t spinstart;
+   int     ms;
+
+   while((ms = (int)((when - now - sleepslop) / 1000)) > 0)
+   {
+      int64_t before = now;
+      int64_t over;
+
+      i_haltimer.Sleep(ms);
+      now = D_usecs();
+      totalsleep += now - before;
+
+      over = now - before - ms * 1000;
+      if(over > sleepslop)
+         sleepslop = over;
+      else
+         sleepslop += (over - sleepslop) / 16;
+      sleepslop = eclamp<int64_t>(sleepslop, PACE_MINSLOP, PACE_MAXSLOP);
+   }
+
+   spinstart = now;
+   while(now < when)
+   {
+      std::this_thread::yield();
+      now = D_usecs();
+   }
+   totalspin += now - spinstart;
+}
+
+//
+// D_PaceFrame
+//
+void D_PaceFrame()
+{
+   int64_t now = D_usecs();
+   int64_t start;
+   bool    paced = false;
+
+   if(!statstart)
+      statstart = now;
+
+   if(d_fastrefresh && d_maxfps > 0 && !timingdemo && !fastdemo && !vidcapactive)
+   {
+      int64_t period = 1000000 / d_maxfps;
+
+      // After a stall, or when pacing has just been turned on, start counting
+      // from now rather than rushing frames out to catch up.
+      deadline += period;
+      if(deadline < now - period)
+         deadline = now;
+      else
+      {
+         D_waitUntil(deadline);
+         paced = true;
+      }
+   }
+
+   start = D_usecs();
+
+   if(framestart)
+   {
+      framestat_t &fs = framestats[numframestats++ % PACE_HISTORY];
+
+      fs.interval = (int)(start - framestart);
+      fs.busy     = (int)(now - framestart);
+      fs.late     = paced ? (int)(start - deadline) : 0;
+      fs.paced    = paced;
+   }
+
+   framestart = start;
+}
+
+//
+// D_cmpInt
+//
+// qsort callback for the framestats percentile.
+//
+static int D_cmpInt(const void *a, const void *b)
+{
+   return *(const int *)a - *(const int *)b;
+}
+
+//=============================================================================
+//
+// Console Commands
+//
+
+VARIABLE_INT(d_maxfps, NULL, 0, 1000, NULL);
+CONSOLE_VARIABLE(d_maxfps, d_maxfps, 0) {}
+
+CONSOLE_COMMAND(framestats, 0)
+{
+   static int intervals[PACE_HISTORY];
+   unsigned int count = emin<unsigned int>(numframestats, PACE_HISTORY);
+   unsigned int numpaced = 0;
+   double  sum = 0.0, sumsq = 0.0, busysum = 0.0, latesum = 0.0;
+   int     busymax = 0, latemax = 0;
+   int64_t elapsed;
+
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      numframestats = 0;
+      totalsleep = totalspin = 0;
+      statstart = D_usecs();
+      return;
+   }
+
+   if(!count)
+   {
+      C_Printf("No frames recorded\n");
+      return;
+   }
+
+   for(unsigned int i = 0; i < count; i++)
+   {
+      const framestat_t &fs = framestats[i];
+
+      intervals[i] = fs.interval;
+      sum     += fs.interval;
+      sumsq   += (double)fs.interval * fs.interval;
+      busysum += fs.busy;
+      busymax  = emax(busymax, fs.busy);
+
+      if(fs.paced)
+      {
+         ++numpaced;
+         latesum += fs.late;
+         latemax  = emax(latemax, fs.late);
+      }
+   }
+
+   qsort(intervals, count, sizeof(int), D_cmpInt);
+
+   double avg    = sum / count;
+   double stddev = sqrt(emax(sumsq / count - avg * avg, 0.0));
+
+   C_Printf(FC_HI "Last %u frames\n", count);
+   C_Printf("Frame time: avg %.2f ms (%.1f fps), min %.2f, 99%% %.2f, max %.2f\n",
+            avg / 1000.0, avg > 0.0 ? 1000000.0 / avg : 0.0,
+            intervals[0] / 1000.0, intervals[count * 99 / 100] / 1000.0,
+            intervals[count - 1] / 1000.0);
+   C_Printf("Jitter: %.3f ms std. dev.\n", stddev / 1000.0);
+   C_Printf("Work: avg %.2f ms, max %.2f ms\n",
+            busysum / count / 1000.0, busymax / 1000.0);
+
+   if(numpaced)
+   {
+      C_Printf("Pacing to %d fps: %u frames, late by avg %.3f ms, max %.3f ms\n",
+               d_maxfps, numpaced, latesum / numpaced / 1000.0, latemax / 1000.0);
+   }
+
+   if((elapsed = D_usecs() - statstart) > 0)
+   {
+      C_Printf("Waiting: %.1f%% asleep, %.1f%% spinning (margin %.2f ms)\n",
+               totalsleep * 100.0 / elapsed, totalspin * 100.0 / elapsed,
+               sleepslop / 1000.0);
+   }
+}
+
+// EOF
+
@@ -0,0 +1,40 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Frame pacing: caps the frame rate when d_fastrefresh is on, and keeps
+//   frame timing statistics.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef D_PACER_H__
+#define D_PACER_H__
+
+extern int d_maxfps; // frame rate cap for d_fastrefresh; 0 = none
+
+// Called at the top of each pass through the main loop. Waits until the next
+// frame is due and records how the last one went.
+void D_PaceFrame();
+
+#endif
+
+// EOF
+
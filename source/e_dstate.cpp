@@ -370,13 +370,21 @@ static void DoTokenStateScan(tkstate_t *tks)
    const char *str = tks->line->constPtr();
    int i           = tks->i;
    qstring *token  = tks->token;
+   const char *close;
 
    // allow A-Za-z0-9, underscore, and leading - for numbers
    if(ectype::isAlnum(str[i]) || str[i] == '_' || str[i] == '-')
    {
       // start a text token - we'll determine the more specific type, if any,
-      // later.
-      *token += str[i];
+      // later. The run of name characters is taken in one go; whatever ends
+      // it is left for TSTATE_TEXT.
+      int end = i + 1;
+
+      while(ectype::isAlnum(str[end]) || str[end] == '_')
+         ++end;
+
+      token->copy(str + i, end - i);
+      tks->i         = end - 1;
       tks->tokentype = TOKEN_TEXT;
       tks->state     = TSTATE_TEXT;
    }
@@ -393,7 +401,15 @@ static void DoTokenStateScan(tkstate_t *tks)
          break;
       case '"':  // quoted string
          tks->tokentype = TOKEN_TEXT;
-         tks->state     = TSTATE_STRING;
+         if((close = strchr(str + i + 1, '"')))
+         {
+            // no escapes in DECORATE, so copy the whole literal
+            token->copy(str + i + 1, close - (str + i + 1));
+            tks->i     = (int)(close - str);
+            tks->state = TSTATE_DONE;
+         }
+         else
+            tks->state = TSTATE_STRING; // unterminated; let it report that
          break;
       case '+':  // plus - used in relative goto statement
          *token += '+';
@@ -1699,20 +1715,15 @@ bool E_GetDSLine(const char **src, pstate_t *ps)
       isdone = true;
    else
    {
-      char c;
+      const char *eol = strchr(srctxt, '\n');
+      size_t      len = eol ? eol - srctxt : strlen(srctxt);
 
-      while((c = *srctxt))
-      {
-         // do not step past the end of the string by doing this in the loop
-         // condition above...
+      // copy the whole line at once, then step past the line break, if any
+      ps->linebuffer->copy(srctxt, len);
+      srctxt += len;
+      if(*srctxt == '\n')
          ++srctxt;
 
-         if(c == '\n')
-            break;
-         
-         *ps->linebuffer += c;
-      }
-
       // track line numbers
       ps->linenum++;
    }
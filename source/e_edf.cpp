@@ -69,6 +69,7 @@
 //
 //----------------------------------------------------------------------------
 
+#include <chrono>
 #include <errno.h>
 
 #define NEED_EDF_DEFINITIONS
@@ -1709,6 +1710,7 @@ static void E_CleanUpEDF(cfg_t *cfg)
 void E_ProcessEDF(const char *filename)
 {
    cfg_t *cfg;
+   std::chrono::steady_clock::time_point starttime, parsetime, endtime;
    
    //
    // Initialization - open log and create a cfg_t
@@ -1721,7 +1723,9 @@ void E_ProcessEDF(const char *filename)
    // haleyjd 03/21/10: All parsing is now streamlined into a single process,
    // using the unified cfg_t object created above.
    //
+   starttime = std::chrono::steady_clock::now();
    E_ParseEDF(cfg, filename);
+   parsetime = std::chrono::steady_clock::now();
 
    //
    // Processing
@@ -1730,6 +1734,13 @@ void E_ProcessEDF(const char *filename)
    //
    E_DoEDFProcessing(cfg, true);
 
+   // The hal timer isn't up yet, so time this with the standard library.
+   // Useful for comparing startup time on large mods.
+   endtime = std::chrono::steady_clock::now();
+   E_EDFLogPrintf("\n\t* Parsing took %d ms, processing took %d ms\n",
+      (int)std::chrono::duration_cast<std::chrono::milliseconds>(parsetime - starttime).count(),
+      (int)std::chrono::duration_cast<std::chrono::milliseconds>(endtime - parsetime).count());
+
    //
    // Shutdown and Cleanup
    //
@@ -156,6 +156,7 @@ MetaTable *E_GetItemEffects()
 #define KEY_BONUS          "bonus"
 #define KEY_CLASS          "class"
 #define KEY_CLASSNAME      "classname"
+#define KEY_COMPATMAXAMT   "compatmaxamount"
 #define KEY_DROPAMOUNT     "dropamount"
 #define KEY_DURATION       "duration"
 #define KEY_FULLAMOUNTONLY "fullamountonly"
@@ -180,17 +181,26 @@ MetaTable *E_GetItemEffects()
 #define KEY_WEAPON         "weapon"
 
 // Interned metatable keys
+static MetaKeyIndex keyAlwaysPickup  (KEY_ALWAYSPICKUP  );
 static MetaKeyIndex keyAmount        (KEY_AMOUNT        );
 static MetaKeyIndex keyArtifactType  (KEY_ARTIFACTTYPE  );
 static MetaKeyIndex keyBackpackAmount(KEY_BACKPACKAMOUNT);
+static MetaKeyIndex keyBonus         (KEY_BONUS         );
 static MetaKeyIndex keyClass         (KEY_CLASS         );
 static MetaKeyIndex keyClassName     (KEY_CLASSNAME     );
+static MetaKeyIndex keyCompatMaxAmt  (KEY_COMPATMAXAMT  );
+static MetaKeyIndex keyDropAmount    (KEY_DROPAMOUNT    );
 static MetaKeyIndex keyFullAmountOnly(KEY_FULLAMOUNTONLY);
 static MetaKeyIndex keyInterHubAmount(KEY_INTERHUBAMOUNT);
 static MetaKeyIndex keyItemID        (KEY_ITEMID        );
 static MetaKeyIndex keyKeepDepleted  (KEY_KEEPDEPLETED  );
 static MetaKeyIndex keyMaxAmount     (KEY_MAXAMOUNT     );
+static MetaKeyIndex keyMaxSaveAmount (KEY_MAXSAVEAMOUNT );
 static MetaKeyIndex keyBackpackMaxAmt(KEY_BACKPACKMAXAMT);
+static MetaKeyIndex keySaveAmount    (KEY_SAVEAMOUNT    );
+static MetaKeyIndex keySaveDivisor   (KEY_SAVEDIVISOR   );
+static MetaKeyIndex keySaveFactor    (KEY_SAVEFACTOR    );
+static MetaKeyIndex keySetHealth     (KEY_SETHEALTH     );
 static MetaKeyIndex keySortOrder     (KEY_SORTORDER     );
 
 // Keys for specially treated artifact types
@@ -357,6 +367,111 @@ static void E_processItemEffects(cfg_t *cfg)
    }
 }
 
+//=============================================================================
+//
+// Compiled Fields
+//
+
+IMPLEMENT_RTTI_TYPE(ItemEffect)
+
+//
+// ItemEffect::clearFields
+//
+// Put the compiled fields into the state of an empty effect.
+//
+void ItemEffect::clearFields()
+{
+   fxclass           = ITEMFX_NONE;
+   itemid            = -1;
+   amount            = 0;
+   maxamount         = 0;
+   compatmaxamount   = 0;
+   hascompatmax      = false;
+   alwayspickup      = false;
+   sethealth         = false;
+   bonus             = false;
+   saveamount        = 0;
+   savefactor        = 1;
+   savedivisor       = 3;
+   maxsaveamount     = 0;
+   ammo              = NULL;
+   dropamount        = 0;
+   artifacttype      = ARTI_NORMAL;
+   sortorder         = 0;
+   interhubamount    = 0;
+   fullamountonly    = false;
+   keepdepleted      = false;
+   backpackamount    = 0;
+   backpackmaxamount = 0;
+}
+
+//
+// ItemEffect::compile
+//
+// Read the frequently used properties out of the table into their fields.
+// Defaults are the same ones the table lookups used before they were
+// compiled.
+//
+void ItemEffect::compile()
+{
+   int defAmount;
+
+   fxclass   = getInt(keyClass,  ITEMFX_NONE);
+   itemid    = getInt(keyItemID, -1);
+   defAmount = (fxclass == ITEMFX_ARTIFACT) ? 1 : 0;
+   amount    = getInt(keyAmount,    defAmount);
+   maxamount = getInt(keyMaxAmount, defAmount);
+
+   // only present if DeHackEd added it
+   if((hascompatmax = hasKey(KEY_COMPATMAXAMT)))
+      compatmaxamount = getInt(keyCompatMaxAmt, 0);
+   else
+      compatmaxamount = 0;
+
+   alwayspickup  = !!getInt(keyAlwaysPickup, 0);
+   sethealth     = !!getInt(keySetHealth,    0);
+   bonus         = !!getInt(keyBonus,        0);
+   saveamount    = getInt(keySaveAmount,    0);
+   savefactor    = getInt(keySaveFactor,    1);
+   savedivisor   = getInt(keySaveDivisor,   3);
+   maxsaveamount = getInt(keyMaxSaveAmount, 0);
+
+   if(fxclass == ITEMFX_AMMO)
+      ammo = E_ItemEffectForName(getString(KEY_AMMO, ""));
+   else
+      ammo = NULL;
+   dropamount = getInt(keyDropAmount, amount);
+
+   artifacttype      = getInt(keyArtifactType,   ARTI_NORMAL);
+   sortorder         = getInt(keySortOrder,      0);
+   interhubamount    = getInt(keyInterHubAmount, 0);
+   fullamountonly    = !!getInt(keyFullAmountOnly, 0);
+   keepdepleted      = !!getInt(keyKeepDepleted,   0);
+   backpackamount    = getInt(keyBackpackAmount, 0);
+   backpackmaxamount = getInt(keyBackpackMaxAmt, 0);
+}
+
+// The backpack is checked whenever ammo is given, so it is cached here rather
+// than looked up by name.
+static itemeffect_t *e_backpackItem;
+
+//
+// E_CompileItemEffects
+//
+// Compile the fields of every item effect. This must run after the item IDs
+// have been allocated.
+//
+void E_CompileItemEffects()
+{
+   itemeffect_t *itr = NULL;
+
+   while((itr = runtime_cast<itemeffect_t *>(e_effectsTable.tableIterator(itr))))
+      itr->compile();
+
+   e_backpackItem =
+      runtime_cast<itemeffect_t *>(e_effectsTable.getObject(keyBackpackItem));
+}
+
 //=============================================================================
 //
 // Ammo Types
@@ -407,7 +522,7 @@ static void E_collectAmmoTypes()
 
    while((itr = runtime_cast<itemeffect_t *>(e_effectsTable.tableIterator(itr))))
    {
-      if(itr->getInt(keyArtifactType, ARTI_NORMAL) == ARTI_AMMO)
+      if(itr->artifacttype == ARTI_AMMO)
          e_ammoTypesLookup.add(itr);
    }
 }
@@ -492,7 +607,7 @@ static void E_collectKeyItems()
 
    while((itr = runtime_cast<itemeffect_t *>(e_effectsTable.tableIterator(itr))))
    {
-      if(itr->getInt(keyArtifactType, ARTI_NORMAL) == ARTI_KEY)
+      if(itr->artifacttype == ARTI_KEY)
          e_keysLookup.add(itr);
    }
 }
@@ -641,7 +756,7 @@ static void E_processKeyList(itemeffect_t **effects, unsigned int numKeys,
       const char   *name = cfg_getnstr(sec, fieldName, i);
       itemeffect_t *fx   = E_ItemEffectForName(name);
 
-      if(!fx || fx->getInt(keyClass, ITEMFX_NONE) != ITEMFX_ARTIFACT)
+      if(!fx || fx->fxclass != ITEMFX_ARTIFACT)
          E_EDFLoggedWarning(2, "Warning: lockdef key '%s' is not an artifact\n", name);
 
       effects[i] = fx;
@@ -1290,7 +1405,7 @@ inventoryslot_t *E_InventorySlotForItem(player_t *player, itemeffect_t *effect)
 {
    inventoryitemid_t id;
 
-   if(effect && (id = effect->getInt(keyItemID, -1)) >= 0)
+   if(effect && (id = effect->itemid) >= 0)
       return E_InventorySlotForItemID(player, id);
    else
       return NULL;
@@ -1343,7 +1458,7 @@ static void E_sortInventory(player_t *player, inventoryindex_t newIndex, int sor
 
       if((effect = E_EffectForInventoryIndex(player, idx)))
       {
-         int thatorder = effect->getInt(keySortOrder, 0);
+         int thatorder = effect->sortorder;
          if(thatorder < sortorder)
             continue;
          else
@@ -1367,8 +1482,7 @@ static void E_sortInventory(player_t *player, inventoryindex_t newIndex, int sor
 //
 bool E_PlayerHasBackpack(player_t *player)
 {
-   auto backpackItem = runtime_cast<itemeffect_t *>(e_effectsTable.getObject(keyBackpackItem));
-   return (E_GetItemOwnedAmount(player, backpackItem) > 0);
+   return (E_GetItemOwnedAmount(player, e_backpackItem) > 0);
 }
 
 //
@@ -1378,9 +1492,7 @@ bool E_PlayerHasBackpack(player_t *player)
 //
 bool E_GiveBackpack(player_t *player)
 {
-   auto backpackItem = runtime_cast<itemeffect_t *>(e_effectsTable.getObject(keyBackpackItem));
-
-   return E_GiveInventoryItem(player, backpackItem);
+   return E_GiveInventoryItem(player, e_backpackItem);
 }
 
 //
@@ -1390,11 +1502,10 @@ bool E_GiveBackpack(player_t *player)
 //
 bool E_RemoveBackpack(player_t *player)
 {
-   auto backpackItem = runtime_cast<itemeffect_t *>(e_effectsTable.getObject(keyBackpackItem));
    bool removed = false;
    itemremoved_e code;
 
-   if((code = E_RemoveInventoryItem(player, backpackItem, -1)) != INV_NOTREMOVED)
+   if((code = E_RemoveInventoryItem(player, e_backpackItem, -1)) != INV_NOTREMOVED)
    {
       removed = true;
 
@@ -1404,7 +1515,7 @@ bool E_RemoveBackpack(player_t *player)
       for(size_t i = 0; i < numAmmo; i++)
       {
          auto ammo      = E_AmmoTypeForIndex(i);
-         int  maxamount = ammo->getInt(keyMaxAmount, 0);         
+         int  maxamount = ammo->maxamount;
          auto slot      = E_InventorySlotForItem(player, ammo);
 
          if(slot && slot->amount > maxamount)
@@ -1426,21 +1537,19 @@ int E_GetMaxAmountForArtifact(player_t *player, itemeffect_t *artifact)
    if(!artifact)
       return 0;
 
-   int subType = artifact->getInt(keyArtifactType, ARTI_NORMAL);
-
-   switch(subType)
+   switch(artifact->artifacttype)
    {
    case ARTI_AMMO:
       // ammo may increase the max amount if the player is carrying a backpack
       if(E_PlayerHasBackpack(player))
-         return artifact->getInt(keyBackpackMaxAmt, 0);
+         return artifact->backpackmaxamount;
       break;
    default:
       break;
    }
 
    // The default case is to return the ordinary max amount.
-   return artifact->getInt(keyMaxAmount, 1);
+   return artifact->maxamount;
 }
 
 //
@@ -1479,15 +1588,15 @@ bool E_GiveInventoryItem(player_t *player, itemeffect_t *artifact, int amount)
    if(!artifact)
       return false;
 
-   itemeffecttype_t  fxtype = artifact->getInt(keyClass, ITEMFX_NONE);
-   inventoryitemid_t itemid = artifact->getInt(keyItemID, -1);
+   itemeffecttype_t  fxtype = artifact->fxclass;
+   inventoryitemid_t itemid = artifact->itemid;
 
    // Not an artifact??
    if(fxtype != ITEMFX_ARTIFACT || itemid < 0)
       return false;
    
    inventoryindex_t newSlot = -1;
-   int amountToGive = artifact->getInt(keyAmount, 1);
+   int amountToGive = artifact->amount;
    int maxAmount    = E_GetMaxAmountForArtifact(player, artifact);
 
    // may override amount to give via parameter "amount", if > 0
@@ -1506,7 +1615,7 @@ bool E_GiveInventoryItem(player_t *player, itemeffect_t *artifact, int amount)
    }
    
    // If must collect full amount, but it won't fit, return now.
-   if(artifact->getInt(keyFullAmountOnly, 0) && 
+   if(artifact->fullamountonly && 
       slot->amount + amountToGive > maxAmount)
       return false;
 
@@ -1519,7 +1628,7 @@ bool E_GiveInventoryItem(player_t *player, itemeffect_t *artifact, int amount)
 
    // sort if needed
    if(newSlot > 0)
-      E_sortInventory(player, newSlot, artifact->getInt(keySortOrder, 0));
+      E_sortInventory(player, newSlot, artifact->sortorder);
 
    return true;
 }
@@ -1582,7 +1691,7 @@ itemremoved_e E_RemoveInventoryItem(player_t *player, itemeffect_t *artifact, in
    {
       // check for "keep depleted" flag to see if item stays even when we have
       // a zero amount of it.
-      if(!artifact->getInt(keyKeepDepleted, 0))
+      if(!artifact->keepdepleted)
       {
          // otherwise, we need to remove that item and collapse the player's 
          // inventory
@@ -1610,7 +1719,7 @@ void E_InventoryEndHub(player_t *player)
 
       if(item)
       {
-         int interHubAmount = item->getInt(keyInterHubAmount, 0);
+         int interHubAmount = item->interhubamount;
          
          // an interhubamount less than zero means no stripping occurs
          if(interHubAmount >= 0 && amount > interHubAmount)
@@ -1666,6 +1775,9 @@ void E_ProcessInventory(cfg_t *cfg)
    // allocate inventory item IDs
    E_allocateInventoryItemIDs();
 
+   // compile the frequently used effect properties
+   E_CompileItemEffects();
+
    // allocate player inventories
    E_allocatePlayerInventories();
 
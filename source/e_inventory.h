@@ -32,8 +32,7 @@
 // Basic inventory definitions are now in d_player.h, so that the entire engine
 // doesn't rebuild if you modify this header.
 #include "d_player.h"
-
-class MetaTable;
+#include "metaapi.h"
 
 // Effect Types
 enum
@@ -96,7 +95,60 @@ typedef int artitype_t;
 // An item effect is a MetaTable. The properties in the table depend on the type
 // of section that instantiated the effect (and therefore what its purpose is).
 //
-typedef MetaTable itemeffect_t;
+// The properties read every time an item is picked up, given, or checked are
+// also compiled into plain fields once EDF processing is finished, so that the
+// inventory and pickup code does not need to hash a key for each of them. The
+// MetaTable remains authoritative; anything which alters those keys afterward
+// (DeHackEd, for instance) must call compile() again.
+//
+class ItemEffect : public MetaTable
+{
+   DECLARE_RTTI_TYPE(ItemEffect, MetaTable)
+
+public:
+   ItemEffect() : Super() { clearFields(); }
+   ItemEffect(const char *name) : Super(name) { clearFields(); }
+
+   // MetaObject overrides
+   virtual MetaObject *clone() const { return new ItemEffect(*this); }
+
+   void compile();
+
+   // Compiled fields
+   int         fxclass;           // itemeffecttype_t of the defining section
+   int         itemid;            // inventory item ID, or -1
+   int         amount;            // amount given
+   int         maxamount;         // maximum amount
+   int         compatmaxamount;   // DeHackEd max health, for old demos
+   bool        hascompatmax;      // compatmaxamount key is present
+
+   // Health and armor
+   bool        alwayspickup;      // picked up even if not needed
+   bool        sethealth;         // health sets rather than adds
+   bool        bonus;             // armor adds to current armor
+   int         saveamount;        // armor points given
+   int         savefactor;        // armor absorption numerator
+   int         savedivisor;       // armor absorption denominator
+   int         maxsaveamount;     // max armor points for bonuses
+
+   // Ammo givers
+   ItemEffect *ammo;              // ammo type artifact given
+   int         dropamount;        // amount given when dropped
+
+   // Artifacts
+   int         artifacttype;      // artitype_t sub-type
+   int         sortorder;         // relative ordering within inventory
+   int         interhubamount;    // amount kept between hubs
+   bool        fullamountonly;    // picked up for full amount only
+   bool        keepdepleted;      // stays in inventory at zero amount
+   int         backpackamount;    // ammo given by backpacks
+   int         backpackmaxamount; // max ammo while carrying a backpack
+
+private:
+   void clearFields();
+};
+
+typedef ItemEffect itemeffect_t;
 
 //
 // Effect Bindings
@@ -133,6 +185,9 @@ itemeffecttype_t E_EffectTypeForName(const char *name);
 // Find an item effect by name
 itemeffect_t *E_ItemEffectForName(const char *name);
 
+// Recompile all item effects' fields after their tables are altered
+void E_CompileItemEffects();
+
 // Get the item effects table
 MetaTable *E_GetItemEffects();
 
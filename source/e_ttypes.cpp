@@ -799,9 +799,10 @@ void E_PtclTerrainHit(particle_t *p)
    if(!(splash = terrain->splash))
       return;
 
-   x = p->x;
-   y = p->y;
-   z = p->z;
+   const int n = P_ParticleNum(p);
+   x = ParticleMotion.x[n];
+   y = ParticleMotion.y[n];
+   z = ParticleMotion.z[n];
 
    // low mass splash -- always when possible.
    if(splash->smallclass != -1)
@@ -62,6 +62,7 @@
 #include "m_misc.h"
 #include "m_random.h"
 #include "m_shots.h"
+#include "m_vidcap.h"
 #include "metaapi.h"
 #include "mn_engin.h"
 #include "mn_menus.h"
@@ -187,6 +188,9 @@ bool *mousebuttons = &mousearray[1];    // allow [-1]
 // mouse values are used once
 double  mousex;
 double  mousey;
+static double oldmousex; // previous values, for smooth_turning
+static double oldmousey;
+static int    mouseturns[BACKUPTICS]; // mouse part of each local ticcmd's turn
 int     dclicktime;
 bool    dclickstate;
 int     dclicks;
@@ -486,8 +490,7 @@ void G_BuildTiccmd(ticcmd_t *cmd)
    // this is most important in smoothing movement
    if(smooth_turning)
    {
-      static double oldmousex=0.0, mousex2;
-      static double oldmousey=0.0, mousey2;
+      double mousex2, mousey2;
 
       mousex2 = tmousex; mousey2 = tmousey;
       tmousex = (tmousex + oldmousex) / 2.0;        // average
@@ -557,10 +560,15 @@ void G_BuildTiccmd(ticcmd_t *cmd)
    }
 
 
+   mouseturns[maketic%BACKUPTICS] = 0;
+
    if(gameactions[ka_strafe])
       side += (int)(tmousex * 2.0);
    else
+   {
       cmd->angleturn -= (int)(tmousex * 8.0);
+      mouseturns[maketic%BACKUPTICS] = -(int)(tmousex * 8.0);
+   }
 
    if(forward > MAXPLMOVE)
       forward = MAXPLMOVE;
@@ -1379,6 +1387,54 @@ static void G_WriteDemoTiccmd(ticcmd_t *cmd)
    G_ReadDemoTiccmd(cmd); // make SURE it is exactly the same
 }
 
+//
+// G_LocalViewTurn
+//
+// Supports applying mouse turning to the view every frame rather than once
+// per gametic. Returns false if that doesn't apply right now. Otherwise,
+// pending is set to how far the console player is going to turn once the
+// ticcmds already built and the mouse motion gathered since then have been
+// run, and lastmouse to the mouse turning in the most recently run tic,
+// which has already been shown and so shouldn't be interpolated. This must
+// predict exactly what G_BuildTiccmd and P_MovePlayer will do, or the view
+// would jump when the tic runs. Ticcmds are not affected, so demos and
+// netgames stay in sync.
+//
+bool G_LocalViewTurn(angle_t &pending, angle_t &lastmouse)
+{
+   player_t *player = &players[consoleplayer];
+   double    tmousex;
+   int       turn;
+
+   if(!d_liveturn || demoplayback || paused || gamestate != GS_LEVEL)
+      return false;
+
+   // old demo format only keeps the high byte of each turn, and duplicated
+   // tics repeat it
+   if((demorecording && !longtics_demo) || ticdup > 1)
+      return false;
+
+   // turning is ignored while dead or just after teleporting
+   if(!player->mo || player->playerstate != PST_LIVE || player->mo->reactiontime)
+      return false;
+
+   turn = D_PendingLocalTurn();
+
+   if(!gameactions[ka_strafe])
+   {
+      tmousex = mousex;
+      if(smooth_turning)
+         tmousex = (tmousex + oldmousex) / 2.0;
+      turn -= (int)(tmousex * 8.0);
+   }
+
+   pending   = (angle_t)turn << 16;
+   // nothing has been run yet on the first tic
+   lastmouse = gametic ? (angle_t)mouseturns[(gametic - 1) % BACKUPTICS] << 16 : 0;
+
+   return true;
+}
+
 static bool secretexit;
 
 // haleyjd: true if a script called exitsecret()
@@ -1493,6 +1549,46 @@ static bool G_doFinale()
 }
 
 
+//
+// G_nextLevel
+//
+// Works out the map number and name to go to once the intermission ends.
+//
+static const char *G_nextLevel(int &map)
+{
+   map = wminfo.next+1;
+
+   // haleyjd: handle heretic hidden levels via missioninfo samelevel rules
+   if(!wminfo.nextexplicit && GameModeInfo->missionInfo->sameLevels)
+   {
+      samelevel_t *sameLevel = GameModeInfo->missionInfo->sameLevels;
+      while(sameLevel->episode != -1)
+      {
+         if(gameepisode == sameLevel->episode && map == sameLevel->map)
+         {
+            --map; // return to same level by default
+            break;
+         }
+         ++sameLevel;
+      }
+   }
+   
+   // haleyjd: customizable secret exits
+   if(secretexit)
+   {
+      if(!wminfo.nextexplicit && *LevelInfo.nextSecret)
+         return LevelInfo.nextSecret;
+   }
+   else
+   {
+      // haleyjd 12/14/01: don't use nextlevel for secret exits here either!
+      if(!wminfo.nextexplicit && *LevelInfo.nextLevel)
+         return LevelInfo.nextLevel;
+   }
+
+   return G_GetNameForMap(gameepisode, map);
+}
+
 //
 // G_DoCompleted
 //
@@ -1604,45 +1700,18 @@ static void G_DoCompleted()
       memcpy(statcopy, &wminfo, sizeof(wminfo));
    
    IN_Start(&wminfo);
+
+   // start loading the next level's music while the intermission runs
+   int nextmap;
+   const char *nextname = G_nextLevel(nextmap);
+   S_PrefetchLevelMusic(nextname, gameepisode, nextmap);
 }
 
 static void G_DoWorldDone()
 {
    idmusnum = -1; //jff 3/17/98 allow new level's music to be loaded
    gamestate = GS_LOADING;
-   gamemap = wminfo.next+1;
-
-   // haleyjd: handle heretic hidden levels via missioninfo samelevel rules
-   if(!wminfo.nextexplicit && GameModeInfo->missionInfo->sameLevels)
-   {
-      samelevel_t *sameLevel = GameModeInfo->missionInfo->sameLevels;
-      while(sameLevel->episode != -1)
-      {
-         if(gameepisode == sameLevel->episode && gamemap == sameLevel->map)
-         {
-            --gamemap; // return to same level by default
-            break;
-         }
-         ++sameLevel;
-      }
-   }
-   
-   // haleyjd: customizable secret exits
-   if(secretexit)
-   {
-      if(!wminfo.nextexplicit && *LevelInfo.nextSecret)
-         G_SetGameMapName(LevelInfo.nextSecret);
-      else
-         G_SetGameMapName(G_GetNameForMap(gameepisode, gamemap));
-   }
-   else
-   {
-      // haleyjd 12/14/01: don't use nextlevel for secret exits here either!
-      if(!wminfo.nextexplicit && *LevelInfo.nextLevel)
-         G_SetGameMapName(LevelInfo.nextLevel);
-      else
-         G_SetGameMapName(G_GetNameForMap(gameepisode, gamemap));
-   }
+   G_SetGameMapName(G_nextLevel(gamemap));
 
    // haleyjd 10/24/10: if in Master Levels mode, see if the next map exists
    // in the wad directory, and if so, use it. Otherwise, return to the Master
@@ -1930,6 +1999,9 @@ void G_Ticker()
       }
    }
 
+   // report on screenshots written in the background
+   M_ScreenShotTicker();
+
    if(animscreenshot)    // animated screen shots
    {
       if(gametic % 16 == 0)
@@ -3436,6 +3508,10 @@ bool G_CheckDemoStatus()
       return false;  // killough
    }
 
+   // the demo was being rendered to files; finish them up and exit
+   if(demoplayback && vidcapactive)
+      M_FinishVidCap();
+
    if(timingdemo)
    {
       int endtime = i_haltimer.GetRealTime();
@@ -61,6 +61,7 @@ void G_WorldDone();
 void G_ForceFinale();
 void G_Ticker();
 void G_ScreenShot();
+bool G_LocalViewTurn(angle_t &pending, angle_t &lastmouse);
 void G_ReloadDefaults();                // killough 3/01/98: loads game defaults
 void G_SaveGameName(char *,size_t,int); // killough 3/22/98: sets savegame filename
 void G_SetFastParms(int);               // killough 4/10/98: sets -fast parameters
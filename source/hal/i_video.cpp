@@ -197,15 +197,37 @@ void I_ReadScreen(byte *scr)
    i_video_driver->ReadScreen(scr);
 }
 
+// Copy of the last palette given to I_SetPalette, for video capture
+static byte i_curpalette[768];
+static bool i_havepalette;
+
 //
 // I_SetPalette
 //
 void I_SetPalette(byte *palette)
 {
+   // a NULL palette only reapplies gamma to the current one
+   if(palette)
+   {
+      memcpy(i_curpalette, palette, sizeof(i_curpalette));
+      i_havepalette = true;
+   }
+
    if(in_graphics_mode)             // killough 8/11/98
       i_video_driver->SetPalette(palette);
 }
 
+//
+// I_GetPalette
+//
+// Returns the palette most recently set, before gamma correction, or NULL if
+// none has been set yet.
+//
+byte *I_GetPalette()
+{
+   return i_havepalette ? i_curpalette : NULL;
+}
+
 void I_ShutdownGraphics()
 {
    if(in_graphics_mode)
@@ -41,6 +41,8 @@ typedef struct i_sounddriver_s
    int  (*SoundIsPlaying)(int);
    void (*UpdateSoundParams)(int, int, int, int);
    void (*UpdateEQParams)(void);
+   int  (*StartOfflineMix)(void);
+   void (*MixOffline)(short *, int);
 } i_sounddriver_t;
 
 // Init at program start...
@@ -56,6 +58,13 @@ void I_ShutdownSound();
 // Cache sound data
 void I_CacheSound(sfxinfo_t *sound);
 
+// Stop feeding the audio device and return the sample rate of sound mixed
+// with I_MixSoundOffline, or 0 if the driver can't mix offline.
+int I_StartOfflineMix();
+
+// Mix the given number of stereo 16-bit sample frames into dest.
+void I_MixSoundOffline(short *dest, int frames);
+
 //
 //  SFX I/O
 //
@@ -95,6 +104,8 @@ typedef struct i_musicdriver_s
    void (*StopSong)(int);
    void (*UnRegisterSong)(int);
    int  (*QrySongPlaying)(int);
+   void (*UpdateMusic)(void);
+   int  (*PrefetchSong)(void *, int);
 } i_musicdriver_t;
 
 void I_InitMusic();
@@ -123,6 +134,13 @@ void I_StopSong(int handle);
 // See above (register), then think backwards
 void I_UnRegisterSong(int handle);
 
+// Starts loading song data that is expected to be registered soon, so that
+// registering it later doesn't stall. Returns 0 if the driver can't.
+int I_PrefetchSong(void *data, int length);
+
+// Called once per frame; starts songs whose data has finished loading.
+void I_UpdateMusic();
+
 // Allegro card support jff 1/18/98
 extern  int snd_card;
 extern  int mus_card;
@@ -58,6 +58,7 @@ void I_ShutdownGraphics();
 
 // Takes full 8 bit values.
 void I_SetPalette(byte *palette);
+byte *I_GetPalette();
 
 void I_FinishUpdate();
 
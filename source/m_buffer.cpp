@@ -43,10 +43,41 @@
 //
 void BufferedFileBase::InitBuffer(size_t pLen, int pEndian)
 {
-   buffer = ecalloc(byte *, pLen, sizeof(byte));
-   len    = pLen;
-   idx    = 0;
-   endian = pEndian;
+   buffer    = ecalloc(byte *, pLen, sizeof(byte));
+   len       = pLen;
+   idx       = 0;
+   endian    = pEndian;
+   ownBuffer = true;
+}
+
+//
+// BufferedFileBase::InitBuffer
+//
+// Sets up the buffer to use memory provided by the caller, which must stay
+// valid until the file is closed. As this never touches the zone heap, such
+// a buffer may be used from a thread other than the main one.
+//
+void BufferedFileBase::InitBuffer(byte *pBuffer, size_t pLen, int pEndian)
+{
+   buffer    = pBuffer;
+   len       = pLen;
+   idx       = 0;
+   endian    = pEndian;
+   ownBuffer = false;
+}
+
+//
+// BufferedFileBase::FreeBuffer
+//
+// Releases the buffer, if it is owned by this object.
+//
+void BufferedFileBase::FreeBuffer()
+{
+   if(buffer && ownBuffer)
+      efree(buffer);
+
+   buffer    = NULL;
+   ownBuffer = false;
 }
 
 //
@@ -76,11 +107,7 @@ void BufferedFileBase::Close()
    idx = 0;
    len = 0;
 
-   if(buffer)
-   {
-      efree(buffer);
-      buffer = NULL;
-   }
+   FreeBuffer();
 
    ownFile = false;
 }
@@ -190,6 +217,24 @@ bool OutBuffer::CreateFile(const char *filename, size_t pLen, int pEndian)
    return true;
 }
 
+//
+// OutBuffer::CreateFile
+//
+// As above, but writes through a buffer supplied by the caller.
+//
+bool OutBuffer::CreateFile(const char *filename, byte *pBuffer, size_t pLen,
+                           int pEndian)
+{
+   if(!(f = fopen(filename, "wb")))
+      return false;
+
+   InitBuffer(pBuffer, pLen, pEndian);
+
+   ownFile = true;
+
+   return true;
+}
+
 //
 // OutBuffer::Flush
 //
@@ -62,13 +62,16 @@ protected:
    int endian;    // endianness indicator
    bool throwing; // throws exceptions on IO errors
    bool ownFile;  // buffer owns the file
+   bool ownBuffer; // buffer memory was allocated by this object
    
    void InitBuffer(size_t pLen, int pEndian);
+   void InitBuffer(byte *pBuffer, size_t pLen, int pEndian);
+   void FreeBuffer();
 
 public:
    BufferedFileBase() 
       : f(NULL), buffer(NULL), len(0), idx(0), endian(0), throwing(false),
-        ownFile(false)
+        ownFile(false), ownBuffer(false)
    {
    }
 
@@ -77,11 +80,7 @@ public:
       if(ownFile && f)
          fclose(f);
 
-      if(buffer)
-      {
-         efree(buffer);
-         buffer = NULL;
-      }
+      FreeBuffer();
    }
 
    long Tell();
@@ -113,6 +112,7 @@ class OutBuffer : public BufferedFileBase
 {
 public:
    bool CreateFile(const char *filename, size_t pLen, int pEndian);
+   bool CreateFile(const char *filename, byte *pBuffer, size_t pLen, int pEndian);
    bool Flush();
    void Close();
 
@@ -0,0 +1,574 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Job system: a pool of worker threads running small units of work.
+//
+//   Each worker owns a queue. Jobs submitted from inside a job go onto the
+//   submitting worker's own queue and are taken from the back, so related
+//   work stays on one thread; idle workers steal from the front of the other
+//   queues. The main thread has a queue of its own and helps run jobs while
+//   it waits for one to finish, so everything still works with no workers.
+//
+//   Jobs must not touch the zone heap, the WAD directory, or the console.
+//   Each thread has a scratch arena, allocated here on the main thread, for
+//   temporary memory; plain new and delete are also safe. Only the main
+//   thread and the workers may use the job system.
+//
+//-----------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "doomtype.h"
+#include "i_system.h"
+#include "m_argv.h"
+#include "m_compare.h"
+#include "m_jobs.h"
+#include "v_misc.h"
+
+#define JOB_MAXWORKERS   32
+#define JOB_QUEUESIZE    1024
+#define JOB_SCRATCHSIZE  (256*1024)
+#define JOB_MAXSTATS     64
+
+// timing totals, kept per job name
+struct jobstat_t
+{
+   const char *name;
+   std::atomic<unsigned int>       count;
+   std::atomic<unsigned long long> nanosecs;
+};
+
+// a job that must wait for another
+struct jobedge_t
+{
+   job_t     *job;
+   jobedge_t *next;
+};
+
+struct job_t
+{
+   jobfunc_t         func;
+   void             *data;
+   jobstat_t        *stat;
+   std::atomic<int>  waiting;    // unfinished prerequisites, plus one until submitted
+   std::atomic<bool> done;       // set last; the job may be freed right after
+   std::mutex        lock;       // guards finished and dependents
+   bool              finished;
+   jobedge_t        *dependents;
+};
+
+// one per worker, and one for the main thread
+struct jobqueue_t
+{
+   std::mutex lock;
+   job_t     *jobs[JOB_QUEUESIZE];
+   int        head;  // index of the oldest job
+   int        count;
+};
+
+struct jobarena_t
+{
+   byte  *base;
+   size_t used;
+};
+
+static int                      numjobworkers;
+static int                      numjobslots;
+static std::thread::id          jobmainthread;
+static jobqueue_t              *jobqueues;
+static jobarena_t              *jobarenas;
+static std::atomic<int>         jobsqueued;
+static std::mutex              *joblock;     // for sleeping on jobcv
+static std::condition_variable *jobcv;       // something was queued or finished
+
+static std::mutex               jobstatlock;
+static jobstat_t                jobstats[JOB_MAXSTATS];
+static int                      numjobstats;
+
+// index of the worker running on this thread; -1 on any other thread
+static thread_local int         jobworkerindex = -1;
+
+//
+// M_jobSlot
+//
+// Returns the queue and arena index for the calling thread. The main
+// thread's come after the workers'. Any other thread is an error.
+//
+static int M_jobSlot()
+{
+   if(jobworkerindex >= 0)
+      return jobworkerindex;
+
+   if(std::this_thread::get_id() != jobmainthread)
+      I_Error("M_jobSlot: job system used from an unknown thread\n");
+
+   return numjobworkers;
+}
+
+//
+// M_jobStat
+//
+// Finds or adds the timing entry for a job name.
+//
+static jobstat_t *M_jobStat(const char *name)
+{
+   std::lock_guard<std::mutex> lock(jobstatlock);
+
+   for(int i = 0; i < numjobstats; i++)
+   {
+      if(jobstats[i].name == name || !strcmp(jobstats[i].name, name))
+         return &jobstats[i];
+   }
+
+   if(numjobstats == JOB_MAXSTATS)
+      return NULL;
+
+   jobstats[numjobstats].name = name;
+   return &jobstats[numjobstats++];
+}
+
+//
+// M_wakeJobThreads
+//
+// Wakes anything sleeping on jobcv. Taking the lock first means a thread
+// that has just checked its condition can't miss the notification.
+//
+static void M_wakeJobThreads()
+{
+   {
+      std::lock_guard<std::mutex> lock(*joblock);
+   }
+   jobcv->notify_all();
+}
+
+static void M_runJob(job_t *job, int slot);
+
+//
+// M_pushJob
+//
+// Queues a job whose prerequisites have all finished. If the queue is full
+// the job is simply run now.
+//
+static void M_pushJob(job_t *job, int slot)
+{
+   jobqueue_t &queue = jobqueues[slot];
+
+   queue.lock.lock();
+   if(queue.count == JOB_QUEUESIZE)
+   {
+      queue.lock.unlock();
+      M_runJob(job, slot);
+      return;
+   }
+   queue.jobs[(queue.head + queue.count) % JOB_QUEUESIZE] = job;
+   queue.count++;
+   jobsqueued++;
+   queue.lock.unlock();
+
+   M_wakeJobThreads();
+}
+
+//
+// M_takeJob
+//
+// Takes the newest job from the thread's own queue, or failing that, the
+// oldest job from another queue.
+//
+static job_t *M_takeJob(int slot)
+{
+   job_t *job = NULL;
+
+   if(!jobsqueued)
+      return NULL;
+
+   for(int i = 0; i < numjobslots && !job; i++)
+   {
+      jobqueue_t &queue = jobqueues[(slot + i) % numjobslots];
+      std::lock_guard<std::mutex> lock(queue.lock);
+
+      if(!queue.count)
+         continue;
+
+      if(!i)
+         job = queue.jobs[(queue.head + queue.count - 1) % JOB_QUEUESIZE];
+      else
+      {
+         job = queue.jobs[queue.head];
+         queue.head = (queue.head + 1) % JOB_QUEUESIZE;
+      }
+      queue.count--;
+      jobsqueued--;
+   }
+
+   return job;
+}
+
+//
+// M_runJob
+//
+// Runs a job, then releases anything that was waiting on it.
+//
+static void M_runJob(job_t *job, int slot)
+{
+   jobarena_t &arena = jobarenas[slot];
+   size_t      mark  = arena.used; // a waiting job may be helping; keep its memory
+   auto        start = std::chrono::steady_clock::now();
+
+   job->func(job->data);
+
+   arena.used = mark;
+
+   if(job->stat)
+   {
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      job->stat->count++;
+      job->stat->nanosecs +=
+         std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+   }
+
+   job->lock.lock();
+   job->finished = true;
+   jobedge_t *edge = job->dependents;
+   job->dependents = NULL;
+   job->lock.unlock();
+
+   while(edge)
+   {
+      jobedge_t *next = edge->next;
+      if(--edge->job->waiting == 0)
+         M_pushJob(edge->job, slot);
+      delete edge;
+      edge = next;
+   }
+
+   job->done = true;
+   M_wakeJobThreads();
+}
+
+//
+// M_jobWorker
+//
+// Worker thread main loop. Workers are never stopped; they sleep when there
+// is nothing to do.
+//
+static void M_jobWorker(int slot)
+{
+   jobworkerindex = slot;
+
+   for(;;)
+   {
+      job_t *job;
+
+      if((job = M_takeJob(slot)))
+      {
+         M_runJob(job, slot);
+         continue;
+      }
+
+      std::unique_lock<std::mutex> lock(*joblock);
+      jobcv->wait(lock, [] { return jobsqueued > 0; });
+   }
+}
+
+//
+// M_jobCPUCount
+//
+// Returns the number of CPUs the process may run on. With -affinity, that is
+// the number of bits set in the mask I_SetAffinityMask applies.
+//
+static int M_jobCPUCount()
+{
+   int p;
+
+   if((p = M_CheckParm("-affinity")) && p < myargc - 1)
+   {
+      unsigned int mask  = (unsigned int)atoi(myargv[p + 1]);
+      int          count = 0;
+
+      for(; mask; mask &= mask - 1)
+         count++;
+
+      if(count)
+         return count;
+   }
+
+   return (int)std::thread::hardware_concurrency();
+}
+
+//=============================================================================
+//
+// Global Interface
+//
+
+//
+// M_InitJobs
+//
+// Called once at startup. -jobthreads <n> sets the number of worker threads;
+// the default is one fewer than the number of CPUs the process may use, and
+// 0 runs every job on the main thread.
+//
+void M_InitJobs()
+{
+   int p;
+
+   numjobworkers = M_jobCPUCount() - 1;
+   if((p = M_CheckParm("-jobthreads")) && p < myargc - 1)
+      numjobworkers = atoi(myargv[p + 1]);
+   numjobworkers = eclamp(numjobworkers, 0, JOB_MAXWORKERS);
+   numjobslots   = numjobworkers + 1;
+
+   jobmainthread = std::this_thread::get_id();
+   jobqueues     = new jobqueue_t[numjobslots];
+   jobarenas     = estructalloc(jobarena_t, numjobslots);
+
+   for(int i = 0; i < numjobslots; i++)
+   {
+      jobqueues[i].head  = 0;
+      jobqueues[i].count = 0;
+      jobarenas[i].base  = emalloc(byte *, JOB_SCRATCHSIZE);
+   }
+
+   joblock = new std::mutex;
+   jobcv   = new std::condition_variable;
+
+   for(int i = 0; i < numjobworkers; i++)
+      std::thread(M_jobWorker, i).detach();
+}
+
+//
+// M_NumJobWorkers
+//
+// Returns the number of worker threads, not counting the main thread.
+//
+int M_NumJobWorkers()
+{
+   return numjobworkers;
+}
+
+//
+// M_JobWorkerIndex
+//
+// Returns the index of the calling worker thread, below M_NumJobWorkers(),
+// or -1 for any other thread. Cheap enough for hot paths.
+//
+int M_JobWorkerIndex()
+{
+   return jobworkerindex;
+}
+
+//
+// M_NewJob
+//
+// Creates a job. It won't run until it has been submitted. The name is used
+// for timing statistics and must remain valid; a string literal is best.
+//
+job_t *M_NewJob(const char *name, jobfunc_t func, void *data)
+{
+   job_t *job = new job_t;
+
+   job->func       = func;
+   job->data       = data;
+   job->stat       = M_jobStat(name);
+   job->waiting    = 1;
+   job->done       = false;
+   job->finished   = false;
+   job->dependents = NULL;
+
+   return job;
+}
+
+//
+// M_JobDepends
+//
+// Makes job wait for prereq to finish. job must not have been submitted yet,
+// and prereq must not have been waited on yet.
+//
+void M_JobDepends(job_t *job, job_t *prereq)
+{
+   job->waiting++;
+
+   prereq->lock.lock();
+   if(prereq->finished)
+   {
+      prereq->lock.unlock();
+      job->waiting--;
+      return;
+   }
+
+   jobedge_t *edge = new jobedge_t;
+   edge->job  = job;
+   edge->next = prereq->dependents;
+   prereq->dependents = edge;
+   prereq->lock.unlock();
+}
+
+//
+// M_SubmitJob
+//
+// Lets a job run once its prerequisites are done.
+//
+void M_SubmitJob(job_t *job)
+{
+   if(--job->waiting == 0)
+      M_pushJob(job, M_jobSlot());
+}
+
+//
+// M_JobDone
+//
+// Returns true once a submitted job has finished, so that waiting on it
+// won't block. Without any workers, jobs only run while something waits.
+//
+bool M_JobDone(const job_t *job)
+{
+   return job->done;
+}
+
+//
+// M_WaitJob
+//
+// Runs other jobs until the given one has finished, then frees it.
+//
+void M_WaitJob(job_t *job)
+{
+   int slot = M_jobSlot();
+
+   while(!job->done)
+   {
+      job_t *other;
+
+      if((other = M_takeJob(slot)))
+      {
+         M_runJob(other, slot);
+         continue;
+      }
+
+      std::unique_lock<std::mutex> lock(*joblock);
+      jobcv->wait(lock, [job] { return job->done || jobsqueued > 0; });
+   }
+
+   delete job;
+}
+
+struct jobrange_t
+{
+   jobrangefunc_t func;
+   void          *data;
+   int            start;
+   int            stop;
+};
+
+static void M_rangeJob(void *data)
+{
+   jobrange_t *range = static_cast<jobrange_t *>(data);
+   range->func(range->start, range->stop, range->data);
+}
+
+//
+// M_ParallelFor
+//
+// Calls func on consecutive pieces of [0, count) spread over the workers and
+// returns when all of them are done.
+//
+void M_ParallelFor(const char *name, int count, int grain,
+                   jobrangefunc_t func, void *data)
+{
+   if(count <= 0)
+      return;
+
+   if(grain <= 0)
+      grain = emax(count / (numjobslots * 4), 1);
+
+   int         numranges = (count + grain - 1) / grain;
+   jobrange_t *ranges    = new jobrange_t[numranges];
+   job_t     **jobs      = new job_t *[numranges];
+
+   for(int i = 0; i < numranges; i++)
+   {
+      ranges[i].func  = func;
+      ranges[i].data  = data;
+      ranges[i].start = i * grain;
+      ranges[i].stop  = emin(count, (i + 1) * grain);
+      jobs[i] = M_NewJob(name, M_rangeJob, &ranges[i]);
+   }
+
+   for(int i = 0; i < numranges; i++)
+      M_SubmitJob(jobs[i]);
+
+   for(int i = 0; i < numranges; i++)
+      M_WaitJob(jobs[i]);
+
+   delete [] jobs;
+   delete [] ranges;
+}
+
+//
+// M_JobScratch
+//
+// Allocates from the calling thread's scratch arena.
+//
+void *M_JobScratch(size_t size)
+{
+   jobarena_t &arena = jobarenas[M_jobSlot()];
+
+   size = (size + 15) & ~15;
+   if(size > JOB_SCRATCHSIZE - arena.used)
+      return NULL;
+
+   void *ptr = arena.base + arena.used;
+   arena.used += size;
+
+   return ptr;
+}
+
+//=============================================================================
+//
+// Console Commands
+//
+
+CONSOLE_COMMAND(jobstats, 0)
+{
+   C_Printf(FC_HI "%d worker threads\n", numjobworkers);
+
+   std::lock_guard<std::mutex> lock(jobstatlock);
+
+   for(int i = 0; i < numjobstats; i++)
+   {
+      unsigned int       count = jobstats[i].count;
+      unsigned long long nsecs = jobstats[i].nanosecs;
+
+      C_Printf("%s: %u jobs, %.2f ms total, %.3f ms avg\n",
+               jobstats[i].name, count, nsecs / 1000000.0,
+               count ? nsecs / 1000000.0 / count : 0.0);
+   }
+}
+
+// EOF
+
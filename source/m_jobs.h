@@ -0,0 +1,59 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Job system: a pool of worker threads running small units of work.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef M_JOBS_H__
+#define M_JOBS_H__
+
+struct job_t;
+
+typedef void (*jobfunc_t)(void *data);
+typedef void (*jobrangefunc_t)(int start, int stop, void *data);
+
+void   M_InitJobs();
+int    M_NumJobWorkers();
+int    M_JobWorkerIndex();
+
+// Task graph. A job runs once it has been submitted and every job it depends
+// on has finished. Each job must be waited on exactly once; that frees it.
+job_t *M_NewJob(const char *name, jobfunc_t func, void *data);
+void   M_JobDepends(job_t *job, job_t *prereq);
+void   M_SubmitJob(job_t *job);
+bool   M_JobDone(const job_t *job);
+void   M_WaitJob(job_t *job);
+
+// Split [0, count) into pieces of about grain items and run them in parallel.
+// A grain of 0 picks one based on the number of workers.
+void   M_ParallelFor(const char *name, int count, int grain,
+                     jobrangefunc_t func, void *data);
+
+// Temporary memory for the job currently running on this thread. It is
+// released when the job returns. Returns NULL if the arena is exhausted.
+void  *M_JobScratch(size_t size);
+
+#endif
+
+// EOF
+
@@ -31,6 +31,7 @@
 #include "d_io.h"
 #include "doomstat.h"
 #include "m_buffer.h"
+#include "m_jobs.h"
 #include "m_misc.h"
 #include "p_skin.h"
 #include "s_sound.h"
@@ -427,6 +428,26 @@ static void PNG_dataFlush(png_structp png_ptr)
    // No-op. We don't want to flush and override the buffering semantics.
 }
 
+// Where libpng's messages go for the screenshot being written on this thread.
+// PNG files are written by jobs, which can't use the console, so messages are
+// kept for M_ScreenShotTicker to print. NULL when nobody will report them, as
+// for video capture frames.
+static thread_local char  *pngmessages;
+static thread_local size_t pngmessagesize;
+
+//
+// PNG_addMessage
+//
+static void PNG_addMessage(const char *fmt, png_const_charp msg)
+{
+   if(!pngmessages)
+      return;
+
+   size_t len = strlen(pngmessages);
+   if(len + 1 < pngmessagesize)
+      psnprintf(pngmessages + len, pngmessagesize - len, fmt, msg);
+}
+
 // 
 // PNG_handleError
 //
@@ -434,7 +455,7 @@ static void PNG_dataFlush(png_structp png_ptr)
 //
 static void PNG_handleError(png_structp png_ptr, png_const_charp error_msg)
 {
-   C_Printf(FC_ERROR "libpng error: %s\a", error_msg);
+   PNG_addMessage(FC_ERROR "libpng error: %s\a\n", error_msg);
 
    throw 0;
 }
@@ -446,7 +467,7 @@ static void PNG_handleError(png_structp png_ptr, png_const_charp error_msg)
 //
 static void PNG_handleWarning(png_structp png_ptr, png_const_charp error_msg)
 {
-   C_Printf(FC_ERROR "libpng warning: %s", error_msg);
+   PNG_addMessage(FC_ERROR "libpng warning: %s\n", error_msg);
 }
 
 //
@@ -457,19 +478,20 @@ static void PNG_handleWarning(png_structp png_ptr, png_const_charp error_msg)
 // Some code derived from WadGen, copyright 2011 Samuel 'Kaiser' Villarreal
 // Used under GPLv2.0 or later.
 //
+// This does not allocate from the zone heap, so it is safe to call from a
+// thread other than the main one as long as the OutBuffer is as well.
+//
 static bool png_Writer(OutBuffer *ob, byte *data, 
                        uint32_t width, uint32_t height, byte *palette)
 {
    png_structp pngStruct;
    png_infop   pngInfo;
-   png_colorp  pngPalette;
+   png_color   pngPalette[256];
    pngiodata_t pngIoData;
 
    pngIoData.ob      = ob;
    pngIoData.writeOK = true;
 
-   byte **row_pointers;
-
    // setup png structure pointer
    if(!(pngStruct = png_create_write_struct(PNG_LIBPNG_VER_STRING, &pngIoData, 
                                             PNG_handleError, PNG_handleWarning)))
@@ -483,9 +505,6 @@ static bool png_Writer(OutBuffer *ob, byte *data,
       png_destroy_write_struct(&pngStruct, NULL);
       return false;
    }
-   
-   row_pointers = ecalloc(byte **, height, sizeof(byte *));
-   pngPalette   = ecalloc(png_colorp, 256, png_sizeof(png_color));
 
    try
    {
@@ -528,9 +547,7 @@ static bool png_Writer(OutBuffer *ob, byte *data,
 
       // copy data over
       for(uint32_t i = 0; i < height; i++)
-         row_pointers[i] = &data[i*width];
-
-      png_write_image(pngStruct, row_pointers);
+         png_write_row(pngStruct, &data[i*width]);
 
       // end
       png_write_end(pngStruct, pngInfo);
@@ -542,12 +559,21 @@ static bool png_Writer(OutBuffer *ob, byte *data,
    
    // cleanup
    png_destroy_write_struct(&pngStruct, &pngInfo);
-   efree(row_pointers);
-   efree(pngPalette);
 
    return pngIoData.writeOK;
 }
 
+//
+// M_WritePNG
+//
+// Write an 8-bit paletted image to a PNG file, as is done for screenshots.
+//
+bool M_WritePNG(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, 
+                byte *palette)
+{
+   return png_Writer(ob, data, width, height, palette);
+}
+
 //=============================================================================
 //
 // Shared Code
@@ -579,6 +605,174 @@ static shotformat_t shotFormats[SHOT_NUMSHOTFORMATS] =
    { "png", OutBuffer::NENDIAN, png_Writer }, // Portable Network Graphics
 };
 
+//=============================================================================
+//
+// Background Writing
+//
+// Encoding a large screen and writing it to disk takes long enough
+// to drop frames, so M_ScreenShot only copies the screen and leaves the rest
+// to a job. A handful of shots can be pending at once; beyond that new shots
+// are refused rather than stalling the game. The job must not touch the zone
+// heap or the console, so everything it needs is allocated here beforehand
+// and its results are reported by M_ScreenShotTicker.
+//
+
+#define SHOT_MAXPENDING 4
+#define SHOT_BUFSIZE    (512*1024)
+
+struct shotjob_t
+{
+   bool          busy;                   // queued, or not yet reported
+   job_t        *job;                    // writing job, until waited on
+   shotformat_t *format;
+   byte         *pixels;                 // copy of the screen
+   size_t        pixelsize;              // allocated size of pixels
+   uint32_t      width;
+   uint32_t      height;
+   byte          palette[768];
+   byte         *buffer;                 // OutBuffer memory
+   char          filename[PATH_MAX + 1];
+   char          messages[256];          // from libpng, printed when reported
+   bool          success;
+   int           error;                  // errno from the writer on failure
+};
+
+static shotjob_t shotjobs[SHOT_MAXPENDING];
+
+//
+// M_writeShotJob
+//
+// Job function that writes out a screenshot.
+//
+static void M_writeShotJob(void *data)
+{
+   shotjob_t *shot = static_cast<shotjob_t *>(data);
+   OutBuffer  ob;
+   
+   errno = 0;
+   shot->success = false;
+   shot->messages[0] = '\0';
+
+   pngmessages    = shot->messages;
+   pngmessagesize = sizeof(shot->messages);
+
+   if(ob.CreateFile(shot->filename, shot->buffer, SHOT_BUFSIZE, shot->format->endian))
+   {
+      // killough 10/98: detect failure and remove file if error
+      shot->success = shot->format->writer(&ob, shot->pixels, shot->width, 
+                                           shot->height, shot->palette);
+
+      // haleyjd: close the buffer
+      ob.Close();
+
+      // if not successful, remove the file now
+      if(!shot->success)
+      {
+         int t = errno;
+         remove(shot->filename);
+         errno = t;
+      }
+   }
+
+   pngmessages = NULL;
+
+   shot->error = shot->success ? 0 : errno;
+}
+
+//
+// M_ScreenShotTicker
+//
+// Called from G_Ticker. Reports screenshots that have been written and frees
+// their slots for reuse.
+//
+void M_ScreenShotTicker()
+{
+   for(shotjob_t &shot : shotjobs)
+   {
+      if(!shot.busy)
+         continue;
+
+      if(shot.job)
+      {
+         if(!M_JobDone(shot.job))
+            continue;
+
+         M_WaitJob(shot.job);
+         shot.job = NULL;
+      }
+
+      if(shot.messages[0])
+         C_Printf("%s", shot.messages);
+
+      // killough 10/98: print error message and change sound effect if error
+      if(!shot.success)
+      {
+         doom_printf("%s",
+            shot.error ? strerror(shot.error) : FC_ERROR "Could not take screenshot");
+         S_StartInterfaceSound(GameModeInfo->playerSounds[sk_oof]);
+      }
+      shot.busy = false;
+   }
+}
+
+//
+// M_queueScreenShot
+//
+// Copy the screen into a free slot and hand it to a job. Returns false if
+// too many shots are already pending. Without job workers the shot is
+// written here and reported by the next M_ScreenShotTicker.
+//
+static bool M_queueScreenShot(const char *filename, shotformat_t *format)
+{
+   shotjob_t *shot = NULL;
+   size_t     size = (size_t)vbscreen.width * vbscreen.height;
+
+   for(shotjob_t &s : shotjobs)
+   {
+      if(!s.busy)
+      {
+         shot = &s;
+         break;
+      }
+   }
+   if(!shot)
+      return false;
+
+   if(!shot->buffer)
+      shot->buffer = emalloc(byte *, SHOT_BUFSIZE);
+   if(shot->pixelsize < size)
+   {
+      shot->pixels    = erealloc(byte *, shot->pixels, size);
+      shot->pixelsize = size;
+   }
+
+   // get screen graphics
+   for(int y = 0; y < vbscreen.height; y++)
+   {
+      memcpy(shot->pixels + y * vbscreen.width, vbscreen.data + y * vbscreen.pitch,
+             vbscreen.width);
+   }
+
+   AutoPalette pal(wGlobalDir);
+   memcpy(shot->palette, pal.get(), sizeof(shot->palette));
+
+   shot->format = format;
+   shot->width  = (uint32_t)(vbscreen.width);
+   shot->height = (uint32_t)(vbscreen.height);
+   strncpy(shot->filename, filename, sizeof(shot->filename) - 1);
+   shot->busy   = true;
+
+   if(M_NumJobWorkers() > 0)
+   {
+      shot->job = M_NewJob("M_ScreenShot", M_writeShotJob, shot);
+      M_SubmitJob(shot->job);
+   }
+   else
+      M_writeShotJob(shot);
+
+   return true;
+}
+
 //
 // M_ScreenShot
 //
@@ -587,12 +781,14 @@ static shotformat_t shotFormats[SHOT_NUMSHOTFORMATS] =
 //
 // killough 10/98: improved error-handling
 //
+// The shot is written in the background; failures to write it are
+// reported later by M_ScreenShotTicker.
+//
 void M_ScreenShot(void)
 {
    bool success = false;
    char   *path = NULL;
    size_t  len;
-   OutBuffer ob;
    shotformat_t *format = &shotFormats[screenshot_pcx];
    
    errno = 0;
@@ -622,36 +818,11 @@ void M_ScreenShot(void)
       }
       while(!access(lbmname, F_OK) && --tries);
 
-      if(tries && ob.CreateFile(lbmname, 512*1024, format->endian))
+      if(tries && !(success = M_queueScreenShot(lbmname, format)))
       {
-         // killough 4/18/98: make palette stay around
-         // (PU_CACHE could cause crash)         
-         //byte *pal = (byte *)wGlobalDir.cacheLumpName("PLAYPAL", PU_STATIC);
-         AutoPalette pal(wGlobalDir);
-
-         // get screen graphics
-         V_BlitVBuffer(&backscreen2, 0, 0, &vbscreen, 0, 0, 
-                       vbscreen.width, vbscreen.height);
-         
-         // killough 10/98: detect failure and remove file if error
-         success = format->writer(&ob, backscreen2.data, 
-                                  (uint32_t)(backscreen2.width), 
-                                  (uint32_t)(backscreen2.height),
-                                  pal.get());
-
-         // haleyjd: close the buffer
-         ob.Close();
-
-         // if not successful, remove the file now
-         if(!success)
-         {
-            int t = errno;
-            remove(lbmname);
-            errno = t;
-         }
-
-         // killough 4/18/98: now you can mark it PU_CACHE
-         // Z_ChangeTag(pal, PU_CACHE); - haleyjd 9/30/12: not needed now.
+         doom_printf(FC_ERROR "Too many screenshots pending");
+         S_StartInterfaceSound(GameModeInfo->playerSounds[sk_oof]);
+         return;
       }
    }
 
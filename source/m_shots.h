@@ -29,7 +29,13 @@
 extern int screenshot_pcx;                                   // killough 10/98
 extern int screenshot_gamma;                                 // haleyjd  03/06
 
+class OutBuffer;
+
 void M_ScreenShot(void);
+void M_ScreenShotTicker();
+
+bool M_WritePNG(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, 
+                byte *palette);
 
 #endif
 
@@ -31,6 +31,7 @@
 #include "d_iwad.h"
 #include "d_main.h"
 #include "d_net.h"
+#include "d_pacer.h"
 #include "d_gi.h"
 #include "gl/gl_vars.h"
 #include "hal/i_gamepads.h"
@@ -244,6 +245,12 @@ static default_t sysdefaults[] =
    DEFAULT_BOOL("d_interpolate", &d_interpolate, NULL, true, default_t::wad_no,
                 "1 to activate frame interpolation (smooth rendering)"),
 
+   DEFAULT_INT("d_maxfps", &d_maxfps, NULL, 0, 0, 1000, default_t::wad_no,
+               "Frame rate cap when d_fastrefresh is on (0 = no cap)"),
+
+   DEFAULT_BOOL("d_liveturn", &d_liveturn, NULL, true, default_t::wad_no,
+                "1 to apply mouse turning to the view every frame"),
+
    DEFAULT_BOOL("i_forcefeedback", &i_forcefeedback, NULL, true, default_t::wad_no,
                 "1 to enable force feedback through gamepads where supported"),
 
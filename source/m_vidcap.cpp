@@ -0,0 +1,517 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Video capture: offline rendering of demos to image sequences and WAV.
+//
+//   With -renderdemo, the game clock is driven by the number of frames
+//   drawn rather than by real time, so the demo runs as fast as frames can
+//   be produced while every frame lands at an exact point in time for the
+//   chosen output framerate. Interpolation fills in the frames between tics.
+//   Each frame is copied off the screen and encoded by a job; sound is mixed
+//   for exactly one frame's worth of time after each one and appended to a
+//   WAV file.
+//
+//   The encoding jobs must not touch the zone heap, so all buffers they use
+//   are allocated here on the main thread and recycled.
+//
+//-----------------------------------------------------------------------------
+
+#include "z_zone.h"
+#include "hal/i_timer.h"
+
+#include "autopalette.h"
+#include "d_main.h"
+#include "doomstat.h"
+#include "i_sound.h"
+#include "i_system.h"
+#include "i_video.h"
+#include "m_argv.h"
+#include "m_buffer.h"
+#include "m_compare.h"
+#include "m_jobs.h"
+#include "m_misc.h"
+#include "m_shots.h"
+#include "m_swap.h"
+#include "m_vidcap.h"
+#include "psnprntf.h"
+#include "v_video.h"
+#include "w_wad.h"
+
+#define VIDCAP_DEFAULTFPS  60
+#define VIDCAP_MAXFPS      1000
+#define VIDCAP_OUTBUFSIZE  (512*1024)
+
+// output formats
+enum
+{
+   VIDCAP_PNG, // one paletted PNG file per frame
+   VIDCAP_RAW  // one stream of 24-bit RGB frames, for piping into an encoder
+};
+
+struct vidcapframe_t
+{
+   job_t *job;                    // encoding job, until waited on
+   bool   ok;                     // set by the job
+   int    number;                 // frame number, from 0
+   byte  *pixels;                 // copy of the screen, width * height
+   byte  *scratch;                // file buffer, or RGB pixels for raw output
+   byte   palette[768];           // palette in effect when the frame was drawn
+   char   filename[PATH_MAX + 1]; // destination for PNG output
+};
+
+bool vidcapactive;
+
+static int   vidcapfps;      // output framerate
+static int   vidcapformat;   // VIDCAP_PNG or VIDCAP_RAW
+static int   vidcapframe;    // number of frames drawn; this is the game clock
+static char *vidcapbase;     // output path and filename prefix
+static int   vidcapwidth;    // size of captured frames
+static int   vidcapheight;
+
+//=============================================================================
+//
+// Clock
+//
+// Replaces the timer HAL functions for the duration of the capture.
+//
+
+//
+// M_vidCapGetTime
+//
+// Time in gametics at the current frame.
+//
+static int M_vidCapGetTime()
+{
+   return (int)((int64_t)vidcapframe * TICRATE / vidcapfps);
+}
+
+//
+// M_vidCapGetTicks
+//
+// Time in milliseconds at the current frame.
+//
+static unsigned int M_vidCapGetTicks()
+{
+   return (unsigned int)((int64_t)vidcapframe * 1000 / vidcapfps);
+}
+
+//
+// M_vidCapGetFrac
+//
+// Position of the current frame between two gametics.
+//
+static fixed_t M_vidCapGetFrac()
+{
+   int64_t rem = ((int64_t)vidcapframe * TICRATE) % vidcapfps;
+
+   return (fixed_t)(rem * FRACUNIT / vidcapfps);
+}
+
+static void M_vidCapSleep(int) {}
+static void M_vidCapNoOp() {}
+
+//
+// M_vidCapStartClock
+//
+static void M_vidCapStartClock()
+{
+   i_haltimer.GetTime      = M_vidCapGetTime;
+   i_haltimer.GetRealTime  = M_vidCapGetTime;
+   i_haltimer.GetTicks     = M_vidCapGetTicks;
+   i_haltimer.Sleep        = M_vidCapSleep;
+   i_haltimer.StartDisplay = M_vidCapNoOp;
+   i_haltimer.EndDisplay   = M_vidCapNoOp;
+   i_haltimer.GetFrac      = M_vidCapGetFrac;
+   i_haltimer.SaveMS       = M_vidCapNoOp;
+}
+
+//=============================================================================
+//
+// Sound
+//
+
+static FILE    *vidcapwav;       // WAV output, if sound is captured
+static int      vidcaprate;      // sample rate of the mixed sound
+static int64_t  vidcapsamples;   // stereo sample frames written so far
+static short   *vidcapmixbuf;    // mixing buffer
+static int      vidcapmixframes; // size of the mixing buffer in sample frames
+
+//
+// M_vidCapWriteWAVHeader
+//
+// Write a 16-bit stereo PCM WAV header for the given amount of sample data.
+//
+static bool M_vidCapWriteWAVHeader(FILE *f, uint32_t datasize)
+{
+   byte header[44];
+   uint32_t fields[] =
+   {
+      36 + datasize,          // RIFF chunk size
+      16,                     // fmt chunk size
+      (uint32_t)vidcaprate,   // sample rate
+      (uint32_t)vidcaprate*4, // byte rate
+      datasize                // data chunk size
+   };
+   int offsets[] = { 4, 16, 24, 28, 40 };
+
+   memcpy(header,      "RIFF", 4);
+   memcpy(header +  8, "WAVEfmt ", 8);
+   header[20] = 1;  header[21] = 0;  // PCM
+   header[22] = 2;  header[23] = 0;  // stereo
+   header[32] = 4;  header[33] = 0;  // bytes per sample frame
+   header[34] = 16; header[35] = 0;  // bits per sample
+   memcpy(header + 36, "data", 4);
+
+   for(size_t i = 0; i < earrlen(offsets); i++)
+   {
+      byte *b = header + offsets[i];
+      b[0] = (byte)(fields[i]      );
+      b[1] = (byte)(fields[i] >>  8);
+      b[2] = (byte)(fields[i] >> 16);
+      b[3] = (byte)(fields[i] >> 24);
+   }
+
+   return fwrite(header, sizeof(header), 1, f) == 1;
+}
+
+//
+// M_vidCapMixSound
+//
+// Mix the sound that plays during the current frame and append it to the
+// WAV file. Frame boundaries are computed from the total so that rounding
+// never accumulates.
+//
+static void M_vidCapMixSound()
+{
+   if(!vidcapwav)
+      return;
+
+   int64_t end   = (int64_t)(vidcapframe + 1) * vidcaprate / vidcapfps;
+   int     count = (int)(end - vidcapsamples);
+
+   if(count <= 0)
+      return;
+
+   if(count > vidcapmixframes)
+   {
+      vidcapmixbuf    = erealloc(short *, vidcapmixbuf, count * 2 * sizeof(short));
+      vidcapmixframes = count;
+   }
+
+   I_MixSoundOffline(vidcapmixbuf, count);
+
+   // WAV data is little-endian
+   for(int i = 0; i < count * 2; i++)
+      vidcapmixbuf[i] = SwapShort(vidcapmixbuf[i]);
+
+   if(fwrite(vidcapmixbuf, 2 * sizeof(short), count, vidcapwav) != (size_t)count)
+      I_Error("M_VidCapFrame: error writing sound: %s\n", strerror(errno));
+
+   vidcapsamples = end;
+}
+
+//=============================================================================
+//
+// Encoding
+//
+// Frames are used in turn. Before a frame is reused, the main thread waits
+// for its previous encoding job, which bounds memory use when encoding can't
+// keep up with rendering. Raw frames are converted by the jobs and appended
+// to the stream by the main thread at that point, so they stay in order.
+//
+
+static vidcapframe_t *vidcapframes;   // all frames
+static int            numvidcapframes;
+static FILE          *vidcapraw;      // raw stream output
+
+//
+// M_vidCapConvertRGB
+//
+// Expand a frame to 24-bit RGB in its scratch buffer. Gamma correction
+// follows the screenshot setting.
+//
+static void M_vidCapConvertRGB(vidcapframe_t *frame)
+{
+   byte  rgb[768];
+   byte *src = frame->pixels;
+   byte *end = src + vidcapwidth * vidcapheight;
+   byte *dst = frame->scratch;
+
+   for(int i = 0; i < 768; i++)
+      rgb[i] = screenshot_gamma ? gammatable[usegamma][frame->palette[i]] : frame->palette[i];
+
+   while(src != end)
+   {
+      const byte *c = &rgb[*src++ * 3];
+      *dst++ = c[0];
+      *dst++ = c[1];
+      *dst++ = c[2];
+   }
+}
+
+//
+// M_vidCapWritePNG
+//
+static bool M_vidCapWritePNG(vidcapframe_t *frame)
+{
+   OutBuffer ob;
+   bool      ok;
+
+   if(!ob.CreateFile(frame->filename, frame->scratch, VIDCAP_OUTBUFSIZE,
+                     OutBuffer::NENDIAN))
+      return false;
+
+   ok = M_WritePNG(&ob, frame->pixels, vidcapwidth, vidcapheight, frame->palette);
+   ok = ob.Flush() && ok;
+   ob.Close();
+
+   return ok;
+}
+
+//
+// M_vidCapEncodeJob
+//
+// Job function that encodes one frame.
+//
+static void M_vidCapEncodeJob(void *data)
+{
+   vidcapframe_t *frame = static_cast<vidcapframe_t *>(data);
+
+   if(vidcapformat == VIDCAP_PNG)
+      frame->ok = M_vidCapWritePNG(frame);
+   else
+   {
+      M_vidCapConvertRGB(frame);
+      frame->ok = true;
+   }
+}
+
+//
+// M_vidCapFinishFrame
+//
+// Waits for a frame's encoding job, if it has one, and appends it to the raw
+// stream.
+//
+static void M_vidCapFinishFrame(vidcapframe_t *frame)
+{
+   if(!frame->job)
+      return;
+
+   M_WaitJob(frame->job);
+   frame->job = NULL;
+
+   if(frame->ok && vidcapformat == VIDCAP_RAW)
+   {
+      size_t size = (size_t)vidcapwidth * vidcapheight * 3;
+      frame->ok = (fwrite(frame->scratch, 1, size, vidcapraw) == size);
+   }
+
+   if(!frame->ok)
+      I_Error("M_VidCapFrame: could not write frame %d\n", frame->number);
+}
+
+//
+// M_vidCapAllocFrames
+//
+// Allocate the frames once the screen size is known. Two frames per job
+// worker keeps every worker busy while the next frame is being drawn.
+//
+static void M_vidCapAllocFrames()
+{
+   vidcapwidth     = vbscreen.width;
+   vidcapheight    = vbscreen.height;
+   numvidcapframes = emax(M_NumJobWorkers(), 1) * 2;
+
+   size_t scratchsize = (size_t)vidcapwidth * vidcapheight * 3;
+   if(vidcapformat == VIDCAP_PNG)
+      scratchsize = VIDCAP_OUTBUFSIZE;
+
+   vidcapframes = estructalloc(vidcapframe_t, numvidcapframes);
+
+   for(int i = 0; i < numvidcapframes; i++)
+   {
+      vidcapframes[i].pixels  = emalloc(byte *, vidcapwidth * vidcapheight);
+      vidcapframes[i].scratch = emalloc(byte *, scratchsize);
+   }
+}
+
+//=============================================================================
+//
+// Global Interface
+//
+
+//
+// M_StartVidCap
+//
+// Called from D_DoomMain when -renderdemo is given. Optional parameters:
+//   -vidcapfps <n>      output framerate (default 60)
+//   -vidcappath <dir>   output directory (default the shots directory)
+//   -vidcapraw          write one raw RGB24 stream instead of PNG files
+//   -vidcapnosound      don't write a WAV file
+//
+void M_StartVidCap(const char *demoname)
+{
+   char        name[9];
+   const char *path;
+   int         p;
+   size_t      len;
+
+   vidcapfps = VIDCAP_DEFAULTFPS;
+   if((p = M_CheckParm("-vidcapfps")) && p < myargc - 1)
+      vidcapfps = eclamp(atoi(myargv[p + 1]), 1, VIDCAP_MAXFPS);
+
+   vidcapformat = M_CheckParm("-vidcapraw") ? VIDCAP_RAW : VIDCAP_PNG;
+
+   // build the output path and filename prefix
+   M_ExtractFileBase(demoname, name);
+   M_Strlwr(name);
+
+   if((p = M_CheckParm("-vidcappath")) && p < myargc - 1)
+      path = myargv[p + 1];
+   else
+   {
+      char *shots = NULL;
+      len = M_StringAlloca(&shots, 1, 7, userpath);
+      psnprintf(shots, len, "%s/shots", userpath);
+      path = shots;
+   }
+
+   len = strlen(path) + strlen(name) + 3;
+   vidcapbase = emalloc(char *, len);
+   psnprintf(vidcapbase, len, "%s/%s_", path, name);
+
+   if(vidcapformat == VIDCAP_RAW)
+   {
+      char *fn = NULL;
+      len = M_StringAlloca(&fn, 1, 4, vidcapbase);
+      psnprintf(fn, len, "%s.rgb", vidcapbase);
+      if(!(vidcapraw = fopen(fn, "wb")))
+         I_Error("M_StartVidCap: could not open %s: %s\n", fn, strerror(errno));
+   }
+
+   if(!M_CheckParm("-vidcapnosound") && (vidcaprate = I_StartOfflineMix()))
+   {
+      char *fn = NULL;
+      len = M_StringAlloca(&fn, 1, 4, vidcapbase);
+      psnprintf(fn, len, "%s.wav", vidcapbase);
+      if(!(vidcapwav = fopen(fn, "wb")) || !M_vidCapWriteWAVHeader(vidcapwav, 0))
+         I_Error("M_StartVidCap: could not open %s: %s\n", fn, strerror(errno));
+   }
+
+   // nothing is shown on screen while rendering
+   noblit = true;
+
+   M_vidCapStartClock();
+   vidcapactive = true;
+
+   usermsg("M_StartVidCap: rendering at %d fps to %s*", vidcapfps, vidcapbase);
+}
+
+//
+// M_VidCapFrame
+//
+// Called from the main loop after each frame has been drawn. The screen is
+// copied into a free frame and queued for encoding, the sound for the frame
+// is mixed, and the clock advances to the next frame.
+//
+void M_VidCapFrame()
+{
+   vidcapframe_t *frame;
+   byte          *palette;
+
+   if(!vidcapframes)
+      M_vidCapAllocFrames();
+
+   if(vbscreen.width != vidcapwidth || vbscreen.height != vidcapheight)
+      I_Error("M_VidCapFrame: screen size changed during capture\n");
+
+   // take the next frame in turn, waiting on its last job if necessary
+   frame = &vidcapframes[vidcapframe % numvidcapframes];
+   M_vidCapFinishFrame(frame);
+
+   for(int y = 0; y < vidcapheight; y++)
+   {
+      memcpy(frame->pixels + y * vidcapwidth, vbscreen.data + y * vbscreen.pitch,
+             vidcapwidth);
+   }
+
+   if((palette = I_GetPalette()))
+      memcpy(frame->palette, palette, sizeof(frame->palette));
+   else
+   {
+      AutoPalette pal(wGlobalDir);
+      memcpy(frame->palette, pal.get(), sizeof(frame->palette));
+   }
+
+   frame->number = vidcapframe;
+   psnprintf(frame->filename, sizeof(frame->filename), "%s%06d.png",
+             vidcapbase, vidcapframe);
+
+   // hand it to a job
+   frame->job = M_NewJob("M_VidCapFrame", M_vidCapEncodeJob, frame);
+   M_SubmitJob(frame->job);
+
+   M_vidCapMixSound();
+
+   ++vidcapframe;
+}
+
+//
+// M_FinishVidCap
+//
+// Called when the demo ends. Waits for the jobs to write every frame,
+// finishes the WAV file, and exits.
+//
+void M_FinishVidCap()
+{
+   vidcapactive = false;
+
+   // oldest first, so raw frames are appended in order
+   for(int i = 0; vidcapframes && i < numvidcapframes; i++)
+      M_vidCapFinishFrame(&vidcapframes[(vidcapframe + i) % numvidcapframes]);
+
+   if(vidcapraw)
+   {
+      fclose(vidcapraw);
+      vidcapraw = NULL;
+   }
+
+   if(vidcapwav)
+   {
+      uint32_t datasize = (uint32_t)(vidcapsamples * 2 * sizeof(short));
+      bool     ok;
+
+      ok = !fseek(vidcapwav, 0, SEEK_SET) && M_vidCapWriteWAVHeader(vidcapwav, datasize);
+      fclose(vidcapwav);
+      vidcapwav = NULL;
+
+      if(!ok)
+         I_Error("M_FinishVidCap: error finishing WAV file\n");
+   }
+
+   I_ExitWithMessage("Rendered %d frames at %d fps (%dx%d) to %s*\n",
+                     vidcapframe, vidcapfps, vidcapwidth, vidcapheight,
+                     vidcapbase);
+}
+
+// EOF
+
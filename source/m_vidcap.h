@@ -0,0 +1,44 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Video capture: offline rendering of demos to image sequences and WAV.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef M_VIDCAP_H__
+#define M_VIDCAP_H__
+
+extern bool vidcapactive; // true while a demo is being rendered to files
+
+// Set up -renderdemo: fixed-rate clock, output files, and offline sound.
+void M_StartVidCap(const char *demoname);
+
+// Capture the frame that was just drawn along with its sound.
+void M_VidCapFrame();
+
+// Wait for all frames to be written, close the output, and exit.
+void M_FinishVidCap();
+
+#endif
+
+// EOF
+
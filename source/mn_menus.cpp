@@ -2097,7 +2097,9 @@ static menuitem_t mn_sysvideo_items[] =
    { it_gap },
    { it_info,   "Framerate"   },
    { it_toggle, "Uncapped framerate",       "d_fastrefresh" },
+   { it_variable, "Framerate cap",          "d_maxfps"      },
    { it_toggle, "Interpolation",            "d_interpolate" },
+   { it_toggle, "Per-frame mouse turning",  "d_liveturn"    },
    { it_gap },
    { it_info,   "Screenshots"},
    { it_toggle, "Screenshot format",        "shot_type"     },
@@ -476,6 +476,7 @@ void P_LocateFollowCam(Mobj *target, fixed_t &destX, fixed_t &destY)
       camparams.cheight  = 41 * FRACUNIT;
       camparams.cgroupid = sec->groupid;
       camparams.prev     = NULL;
+      camparams.sectormask = NULL;
       camparams.setTargetMobj(target);
 
       if(CAM_CheckSight(camparams))
@@ -568,6 +569,7 @@ bool P_FollowCamTicker()
    // still visible?
    camsightparams_t camparams;
    camparams.prev = NULL;
+   camparams.sectormask = NULL;
    camparams.setCamera(followcam, 41 * FRACUNIT);
    camparams.setTargetMobj(followtarget);
 
@@ -47,6 +47,7 @@
 #include "e_ttypes.h"
 #include "g_game.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "m_random.h"
 #include "metaapi.h"
 #include "p_anim.h"      // haleyjd
@@ -61,6 +62,7 @@
 #include "p_setup.h"
 #include "p_spec.h"
 #include "p_tick.h"
+#include "p_valid.h"
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_pcheck.h"
@@ -83,95 +85,241 @@ static Mobj *current_actor;
 //
 
 //
-// P_RecursiveSound
+// SOUND PROPAGATION
 //
-// Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
-// sound blocking lines cut off traversal.
+// Monsters are alerted by flooding outward from the noise through sectors
+// that are connected by open two-sided lines. Which lines connect which
+// sectors never changes during a level, so it is worked out once, the first
+// time a noise is made. Whether each line is open is cached as well, and
+// forgotten whenever a sector on either side of it changes height.
 //
-// killough 5/5/98: reformatted, cleaned up
+
+struct soundedge_t
+{
+   line_t   *line;  // connecting line
+   sector_t *other; // sector on the far side, or NULL if one-sided
+};
+
+enum
+{
+   SOUNDLINE_UNKNOWN, // must be checked
+   SOUNDLINE_OPEN,
+   SOUNDLINE_CLOSED
+};
+
+// sector i's lines are soundedges[soundedgestart[i]] up to but not
+// including soundedges[soundedgestart[i + 1]]
+static int         *soundedgestart;
+static soundedge_t *soundedges;
+static byte        *soundlinestate; // SOUNDLINE_* for each line
+static int         *soundgen;       // for each sector, last flood it was in
+static int          soundgeneration;
+
+struct soundvisit_t
+{
+   sector_t *sec;
+   int       soundblocks;
+};
+
+static soundvisit_t *soundstack;
+
+//
+// P_buildSoundGraph
+//
+// Collect, for each sector, the lines sound can pass through: two-sided
+// lines, and lines that are sound-passing portals. All tables are PU_LEVEL
+// and have their pointers cleared when the level ends.
 //
-static void P_RecursiveSound(sector_t *sec, int soundblocks,
-                             Mobj *soundtarget)
+static void P_buildSoundGraph()
 {
-   int i;
-   
-   // wake up all monsters in this sector
-   if(sec->validcount == validcount &&
-      sec->soundtraversed <= soundblocks+1)
-      return;             // already flooded
+   int numedges = 0;
 
-   sec->validcount = validcount;
-   sec->soundtraversed = soundblocks+1;
-   P_SetTarget<Mobj>(&sec->soundtarget, soundtarget);    // killough 11/98
+   soundedgestart = ecalloctag(int *, numsectors + 1, sizeof(int), PU_LEVEL, 
+                               (void **)&soundedgestart);
 
-#ifdef R_LINKEDPORTALS
-   if(sec->f_pflags & PS_PASSSOUND)
+   for(int i = 0; i < numsectors; i++)
    {
-      // Ok, because the same portal can be used on many sectors and even
-      // lines, the portal structure won't tell you what sector is on the
-      // other side of the portal. SO
-      sector_t *other;
-      line_t *check = sec->lines[0];
-
-      other = 
-         R_PointInSubsector(((check->v1->x + check->v2->x) / 2) 
-                             + R_FPLink(sec)->deltax,
-                            ((check->v1->y + check->v2->y) / 2) 
-                             + R_FPLink(sec)->deltay)->sector;
-
-      P_RecursiveSound(other, soundblocks, soundtarget);
+      const sector_t *sec = &sectors[i];
+
+      soundedgestart[i] = numedges;
+      for(int j = 0; j < sec->linecount; j++)
+      {
+         if(sec->lines[j]->flags & ML_TWOSIDED || sec->lines[j]->portal)
+            ++numedges;
+      }
    }
-   
-   if(sec->c_pflags & PS_PASSSOUND)
+   soundedgestart[numsectors] = numedges;
+
+   soundedges = ecalloctag(soundedge_t *, emax(numedges, 1), sizeof(soundedge_t),
+                           PU_LEVEL, (void **)&soundedges);
+
+   for(int i = 0; i < numsectors; i++)
    {
-      // Ok, because the same portal can be used on many sectors and even 
-      // lines, the portal structure won't tell you what sector is on the 
-      // other side of the portal. SO
-      sector_t *other;
-      line_t *check = sec->lines[0];
-
-      other = 
-         R_PointInSubsector(((check->v1->x + check->v2->x) / 2) 
-                             + R_CPLink(sec)->deltax,
-                            ((check->v1->y + check->v2->y) / 2) 
-                             + R_CPLink(sec)->deltay)->sector;
-
-      P_RecursiveSound(other, soundblocks, soundtarget);
+      sector_t    *sec  = &sectors[i];
+      soundedge_t *edge = &soundedges[soundedgestart[i]];
+
+      for(int j = 0; j < sec->linecount; j++)
+      {
+         line_t *check = sec->lines[j];
+
+         if(!(check->flags & ML_TWOSIDED || check->portal))
+            continue;
+
+         edge->line  = check;
+         edge->other = NULL;
+         if(check->sidenum[1] != -1)
+            edge->other = sides[check->sidenum[sides[check->sidenum[0]].sector == sec]].sector;
+         ++edge;
+      }
    }
-#endif
 
-   for(i=0; i<sec->linecount; i++)
+   soundlinestate = ecalloctag(byte *, numlines, sizeof(byte), PU_LEVEL, 
+                               (void **)&soundlinestate);
+   soundgen       = ecalloctag(int *, numsectors, sizeof(int), PU_LEVEL,
+                               (void **)&soundgen);
+   soundstack     = ecalloctag(soundvisit_t *, 2 * numsectors + 1, 
+                               sizeof(soundvisit_t), PU_LEVEL, 
+                               (void **)&soundstack);
+   soundgeneration = 0;
+}
+
+//
+// P_SoundSectorMoved
+//
+// Called when a sector's floor or ceiling height changes; the open or closed
+// state of its lines must be checked again.
+//
+void P_SoundSectorMoved(const sector_t *sec)
+{
+   if(!soundlinestate)
+      return;
+
+   for(int i = 0; i < sec->linecount; i++)
+      soundlinestate[sec->lines[i] - lines] = SOUNDLINE_UNKNOWN;
+}
+
+//
+// P_soundLineOpen
+//
+// Same result as P_LineOpening with no thing: the line is closed if the
+// lower ceiling is at or below the higher floor.
+//
+static bool P_soundLineOpen(const line_t *line)
+{
+   byte &state = soundlinestate[line - lines];
+
+   if(state == SOUNDLINE_UNKNOWN)
    {
-      sector_t *other;
-      line_t *check = sec->lines[i];
-      
+      const sector_t *front = line->frontsector;
+      const sector_t *back  = line->backsector;
+      fixed_t top    = emin(front->ceilingheight, back->ceilingheight);
+      fixed_t bottom = emax(front->floorheight,   back->floorheight);
+
+      state = (top - bottom > 0) ? SOUNDLINE_OPEN : SOUNDLINE_CLOSED;
+   }
+
+   return (state == SOUNDLINE_OPEN);
+}
+
 #ifdef R_LINKEDPORTALS
-      if(check->pflags & PS_PASSSOUND)
-      {
-         sector_t *iother;
+//
+// P_soundPortalSector
+//
+// Because the same portal can be used on many sectors and even lines, the
+// portal structure won't tell you what sector is on the other side of the
+// portal, so find it from the middle of a line and the portal's offset.
+//
+static sector_t *P_soundPortalSector(const line_t *check, const linkdata_t *link)
+{
+   return R_PointInSubsector(((check->v1->x + check->v2->x) / 2) + link->deltax,
+                             ((check->v1->y + check->v2->y) / 2) + link->deltay)->sector;
+}
+#endif
 
-         iother = 
-         R_PointInSubsector(((check->v1->x + check->v2->x) / 2) + check->portal->data.link.deltax,
-                            ((check->v1->y + check->v2->y) / 2) + check->portal->data.link.deltay)->sector;
+//
+// P_FloodSound
+//
+// Called by P_NoiseAlert.
+// Traverse adjacent sectors, sound blocking lines cut off traversal.
+// A sector may be reached a second time with fewer sound blocking lines
+// crossed, and is then flooded again from there; the sectors reached and the
+// final soundtraversed of each are the same as the original recursive
+// flood, whatever the order of traversal.
+//
+// killough 5/5/98: reformatted, cleaned up
+//
+static void P_FloodSound(sector_t *start, Mobj *soundtarget)
+{
+   int top = 0;
 
-         P_RecursiveSound(iother, soundblocks, soundtarget);
-      }
+   if(!soundedges)
+      P_buildSoundGraph();
+
+   // new flood; on wraparound, forget every sector's old one
+   if(++soundgeneration == D_MAXINT)
+   {
+      memset(soundgen, 0, numsectors * sizeof(int));
+      soundgeneration = 1;
+   }
+
+   // visit a sector unless it's already been flooded with as few or fewer
+   // sound blocking lines crossed; wake up all monsters in it
+   auto visit = [&top, soundtarget] (sector_t *sec, int soundblocks)
+   {
+      int secnum = int(sec - sectors);
+
+      if(soundgen[secnum] == soundgeneration &&
+         sec->soundtraversed <= soundblocks+1)
+         return; // already flooded
+
+      soundgen[secnum]    = soundgeneration;
+      sec->soundtraversed = soundblocks+1;
+      P_SetTarget<Mobj>(&sec->soundtarget, soundtarget); // killough 11/98
+
+      soundstack[top].sec         = sec;
+      soundstack[top].soundblocks = soundblocks;
+      ++top;
+   };
+
+   visit(start, 0);
+
+   while(top)
+   {
+      --top;
+
+      sector_t *sec         = soundstack[top].sec;
+      int       soundblocks = soundstack[top].soundblocks;
+
+#ifdef R_LINKEDPORTALS
+      if(sec->f_pflags & PS_PASSSOUND)
+         visit(P_soundPortalSector(sec->lines[0], R_FPLink(sec)), soundblocks);
+   
+      if(sec->c_pflags & PS_PASSSOUND)
+         visit(P_soundPortalSector(sec->lines[0], R_CPLink(sec)), soundblocks);
 #endif
-      if(!(check->flags & ML_TWOSIDED))
-         continue;
 
-      P_LineOpening(check, NULL);
-      
-      if(clip.openrange <= 0)
-         continue;       // closed door
+      const soundedge_t *edge = &soundedges[soundedgestart[sec - sectors]];
+      const soundedge_t *end  = &soundedges[soundedgestart[sec - sectors + 1]];
 
-      other=sides[check->sidenum[sides[check->sidenum[0]].sector==sec]].sector;
+      for(; edge != end; edge++)
+      {
+         line_t *check = edge->line;
       
-      if(!(check->flags & ML_SOUNDBLOCK))
-         P_RecursiveSound(other, soundblocks, soundtarget);
-      else if(!soundblocks)
-         P_RecursiveSound(other, 1, soundtarget);
+#ifdef R_LINKEDPORTALS
+         if(check->pflags & PS_PASSSOUND)
+            visit(P_soundPortalSector(check, &check->portal->data.link), soundblocks);
+#endif
+         if(!(check->flags & ML_TWOSIDED) || !edge->other)
+            continue;
+
+         if(!P_soundLineOpen(check))
+            continue;       // closed door
+
+         if(!(check->flags & ML_SOUNDBLOCK))
+            visit(edge->other, soundblocks);
+         else if(!soundblocks)
+            visit(edge->other, 1);
+      }
    }
 }
 
@@ -183,8 +331,7 @@ static void P_RecursiveSound(sector_t *sec, int soundblocks,
 //
 void P_NoiseAlert(Mobj *target, Mobj *emitter)
 {
-   validcount++;
-   P_RecursiveSound(emitter->subsector->sector, 0, target);
+   P_FloodSound(emitter->subsector->sector, target);
 }
 
 //
@@ -824,7 +971,7 @@ static fixed_t P_AvoidDropoff(Mobj *actor)
 
    // check lines
 
-   validcount++;
+   ValidContext::Global().newQuery();
    for(bx = xl; bx <= xh; ++bx)
    {
       // all contacted lines
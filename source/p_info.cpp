@@ -1932,6 +1932,44 @@ void P_LoadLevelInfo(WadDirectory *dir, int lumpnum, const char *lvname)
    P_InitWeapons();
 }
 
+//
+// P_LevelMusicName
+//
+// Works out the music P_LoadLevelInfo would give a map without loading it, so
+// that it can be fetched early. Level headers inside the wad aren't read, so
+// this is a good guess rather than a promise. Returns an empty string when
+// the gamemode's music for the map number would be used.
+//
+const char *P_LevelMusicName(const char *mapname, int mapnum)
+{
+   const char *name = "";
+   const char *s;
+   metainfo_t *mi;
+   MetaTable  *info;
+
+   if((mi = P_GetMetaInfoForLevel(mapnum)))
+      name = mi->musname;
+
+   if((s = P_GetSndInfoMusic(mapnum)))
+      name = s;
+
+   if(GameModeInfo->id == commercial && isExMy(mapname))
+      name = mapname;
+
+   if((info = XL_EMapInfoForMapName(mapname)))
+   {
+      if((s = info->getString("music", NULL)))
+         name = s;
+   }
+   else if((info = XL_MapInfoForMapName(mapname)))
+   {
+      if((s = info->getString("music", NULL)))
+         name = s;
+   }
+
+   return name;
+}
+
 //
 // P_LevelIsVanillaHexen
 //
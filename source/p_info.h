@@ -27,6 +27,7 @@
 class WadDirectory;
 
 void P_LoadLevelInfo(WadDirectory *dir, int lumpnum, const char *lvname);
+const char *P_LevelMusicName(const char *mapname, int mapnum);
 
 void P_CreateMetaInfo(int map, const char *levelname, int par, const char *mus, 
                       int next, int secr, bool finale, const char *intertext,
@@ -156,8 +156,7 @@ bool P_GiveAmmoPickup(player_t *player, itemeffect_t *pickup, bool dropped, int
    if(!pickup)
       return false;
 
-   itemeffect_t *give = E_ItemEffectForName(pickup->getString("ammo", ""));
-   int giveamount     = pickup->getInt("amount", 0);
+   int giveamount = pickup->amount;
 
    if(dropped)
    {
@@ -165,10 +164,10 @@ bool P_GiveAmmoPickup(player_t *player, itemeffect_t *pickup, bool dropped, int
       if(dropamount)
          giveamount = dropamount;
       else
-         giveamount = pickup->getInt("dropamount", giveamount);
+         giveamount = pickup->dropamount;
    }
 
-   return P_GiveAmmo(player, give, giveamount);
+   return P_GiveAmmo(player, pickup->ammo, giveamount);
 }
 
 //
@@ -180,14 +179,11 @@ bool P_GiveAmmoPickup(player_t *player, itemeffect_t *pickup, bool dropped, int
 //
 static void P_giveBackpackAmmo(player_t *player)
 {
-   static MetaKeyIndex keyBackpackAmount("ammo.backpackamount");
-
    size_t numAmmo = E_GetNumAmmoTypes();
    for(size_t i = 0; i < numAmmo; ++i)
    {
       auto ammoType = E_AmmoTypeForIndex(i);
-      int giveamount = ammoType->getInt(keyBackpackAmount, 0);
-      P_GiveAmmo(player, ammoType, giveamount);
+      P_GiveAmmo(player, ammoType, ammoType->backpackamount);
    }
 }
 
@@ -241,8 +237,8 @@ bool P_GiveBody(player_t *player, itemeffect_t *effect)
    if(!effect)
       return false;
 
-   int amount    = effect->getInt("amount",       0);
-   int maxamount = effect->getInt("maxamount",    0);
+   int amount    = effect->amount;
+   int maxamount = effect->maxamount;
 
    // haleyjd 11/14/09: compatibility fix - the DeHackEd maxhealth setting was
    // only supposed to affect health potions, but when Ty replaced the MAXHEALTH
@@ -252,16 +248,16 @@ bool P_GiveBody(player_t *player, itemeffect_t *effect)
    {
       // only applies to items that actually have this key added to them by
       // DeHackEd; otherwise, the behavior defined through EDF prevails
-      if(effect->hasKey("compatmaxamount"))
-         maxamount = effect->getInt("compatmaxamount", 0);
+      if(effect->hascompatmax)
+         maxamount = effect->compatmaxamount;
    }
 
    // if not alwayspickup, and have more health than the max, don't pick it up
-   if(!effect->getInt("alwayspickup", 0) && player->health >= maxamount)
+   if(!effect->alwayspickup && player->health >= maxamount)
       return false;
 
    // give the health
-   if(effect->getInt("sethealth", 0))
+   if(effect->sethealth)
       player->health = amount;  // some items set health directly
    else
       player->health += amount; // most items add to health
@@ -311,23 +307,23 @@ bool P_GiveArmor(player_t *player, itemeffect_t *effect)
    if(!effect)
       return false;
 
-   int hits        = effect->getInt("saveamount",  0);
-   int savefactor  = effect->getInt("savefactor",  1);
-   int savedivisor = effect->getInt("savedivisor", 3);
+   int hits        = effect->saveamount;
+   int savefactor  = effect->savefactor;
+   int savedivisor = effect->savedivisor;
 
    // check for validity
    if(!hits || !savefactor || !savedivisor)
       return false;
 
    // check if needed
-   if(!(effect->getInt("alwayspickup", 0)) && player->armorpoints >= hits)
+   if(!effect->alwayspickup && player->armorpoints >= hits)
       return false; // don't pick up
 
    // bonuses add to your armor and preserve your current absorption qualities;
    // normal pickups set your armor and override any existing qualities
-   if(effect->getInt("bonus", 0))
+   if(effect->bonus)
    {
-      int maxsaveamount = effect->getInt("maxsaveamount", 0);
+      int maxsaveamount = effect->maxsaveamount;
       player->armorpoints += hits;
       if(player->armorpoints > maxsaveamount)
          player->armorpoints = maxsaveamount;
@@ -524,11 +520,11 @@ void P_TouchSpecialThingNew(Mobj *special, Mobj *toucher)
    sound   = pickup->sound;
    dropped = ((special->flags & MF_DROPPED) == MF_DROPPED);
 
-   switch(effect->getInt("class", ITEMFX_NONE))
+   switch(effect->fxclass)
    {
    case ITEMFX_HEALTH:   // Health - heal up the player automatically
       pickedup = P_GiveBody(player, effect);
-      if(pickedup && player->health < effect->getInt("amount", 0) * 2)
+      if(pickedup && player->health < effect->amount * 2)
          message = effect->getString("lowmessage", message);
       break;
    case ITEMFX_ARMOR:    // Armor - give the player some armor
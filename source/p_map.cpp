@@ -48,8 +48,10 @@
 #include "p_setup.h"
 #include "p_skin.h"
 #include "p_spec.h"
+#include "polyobj.h"
 #include "p_tick.h"
 #include "p_user.h"
+#include "p_valid.h"
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_portal.h"
@@ -376,6 +378,7 @@ bool P_TeleportMove(Mobj *thing, fixed_t x, fixed_t y, bool boss)
    int xl, xh, yl, yh, bx, by;
    subsector_t *newsubsec;
    bool (*func)(Mobj *);
+   unsigned int stompflags = 0;
    
    // killough 8/9/98: make telefragging more consistent, preserve compatibility
    // haleyjd 03/25/03: TELESTOMP flag handling moved here (was thing->player)
@@ -437,13 +440,16 @@ bool P_TeleportMove(Mobj *thing, fixed_t x, fixed_t y, bool boss)
    // SoM 09/07/02: 3dsides monster fix
    clip.touch3dside = 0;
    
-   validcount++;
+   ValidContext::Global().newQuery();
    clip.numspechit = 0;
    
    // stomp on any things contacted
 #ifdef R_LINKEDPORTALS
    if(stomp3d)
+   {
       func = PIT_StompThing3D;
+      stompflags = MF_SHOOTABLE;
+   }
    else
 #endif
       func = PIT_StompThing;
@@ -457,7 +463,8 @@ bool P_TeleportMove(Mobj *thing, fixed_t x, fixed_t y, bool boss)
    {
       for(by = yl; by <= yh; by++)
       {
-         if(!P_BlockThingsIterator(bx, by, func))
+         if(!P_BlockThingsIteratorFilter(bx, by, R_NOGROUP, stompflags, true,
+                                         func))
             return false;
       }
    }
@@ -1120,7 +1127,7 @@ bool Check_Sides(Mobj *actor, int x, int y)
 
    // xl->xh, yl->yh determine the mapblock set to search
 
-   validcount++; // prevents checking same line twice
+   ValidContext::Global().newQuery(); // prevents checking same line twice
    for(bx = xl ; bx <= xh ; bx++)
       for (by = yl ; by <= yh ; by++)
          if(!P_BlockLinesIterator(bx,by,PIT_CrossLine))
@@ -1198,7 +1205,7 @@ bool P_CheckPosition(Mobj *thing, fixed_t x, fixed_t y)
    clip.floorpic = newsubsec->sector->floorpic;
    // SoM: 09/07/02: 3dsides monster fix
    clip.touch3dside = 0;
-   validcount++;
+   ValidContext::Global().newQuery();
    clip.numspechit = 0;
 
    if(clip.thing->flags & MF_NOCLIP)
@@ -1221,7 +1228,8 @@ bool P_CheckPosition(Mobj *thing, fixed_t x, fixed_t y)
    {
       for(by = yl; by <= yh; by++)
       {
-         if(!P_BlockThingsIterator(bx, by, PIT_CheckThing))
+         if(!P_BlockThingsIteratorFilter(bx, by, R_NOGROUP,
+               MF_SOLID|MF_SPECIAL|MF_SHOOTABLE|MF_TOUCHY, true, PIT_CheckThing))
             return false;
       }
    }
@@ -1239,7 +1247,7 @@ bool P_CheckPosition(Mobj *thing, fixed_t x, fixed_t y)
    {
       for(by = yl; by <= yh; by++)
       {
-         if(!P_BlockLinesIterator(bx, by, PIT_CheckLine))
+         if(!P_BlockLinesIteratorBox(bx, by, clip.bbox, PIT_CheckLine))
             return false; // doesn't fit
       }
    }
@@ -1834,7 +1842,7 @@ void P_ApplyTorque(Mobj *mo)
    int flags = mo->intflags; //Remember the current state, for gear-change
 
    clip.thing = mo;
-   validcount++; // prevents checking same line twice
+   ValidContext::Global().newQuery(); // prevents checking same line twice
 
    P_TransPortalBlockWalker(clip.bbox, mo->groupid, true, nullptr, 
       [](int x, int y, int groupid, void *data) -> bool
@@ -2395,7 +2403,8 @@ void P_RadiusAttack(Mobj *spot, Mobj *source, int damage, int distance,
    P_TransPortalBlockWalker(bbox, spot->groupid, false, nullptr, 
       [](int x, int y, int groupid, void *data) -> bool
    {
-      P_BlockThingsIterator(x, y, groupid, PIT_RadiusAttack);
+      P_BlockThingsIteratorFilter(x, y, groupid, MF_SHOOTABLE|MF_BOUNCES, false,
+                                  PIT_RadiusAttack);
       return true;
    });
 
@@ -2544,22 +2553,35 @@ bool P_CheckSector(sector_t *sector, int crunch, int amt, int floorOrCeil)
    // Mark all things invalid
    for(n = sector->touching_thinglist; n; n = n->m_snext)
       n->visited = false;
+   ++secnodegen;
+
+   // Every node before the one just processed has been visited. If nothing
+   // was linked, unlinked or unmarked meanwhile, starting over would skip
+   // straight back to it, so carry on from the next one instead. Not when
+   // portals filter the list, as whether a node is skipped can then change.
+   bool portalaware = 
+      useportalgroups && full_demo_version >= make_full_version(340, 48);
+   msecnode_t *start = sector->touching_thinglist;
    
    do
    {
-      for(n = sector->touching_thinglist; n; n = n->m_snext) // go through list
+      for(n = start; n; n = n->m_snext) // go through list
       {
          // ioanch 20160115: portal aware
-         if(useportalgroups && full_demo_version >= make_full_version(340, 48) &&
-            !P_SectorTouchesThingVertically(sector, n->m_thing))
-         {
+         if(portalaware && !P_SectorTouchesThingVertically(sector, n->m_thing))
             continue;
-         }
          if(!n->visited)                     // unprocessed thing found
          {
+            unsigned int gen = secnodegen;
+
             n->visited  = true;              // mark thing as processed
             if(!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
                PIT_ChangeSector(n->m_thing); // process it
+
+            if(!portalaware && gen == secnodegen)
+               start = n->m_snext;
+            else
+               start = sector->touching_thinglist;
             break;                           // exit and start over
          }
       }
@@ -2575,6 +2597,11 @@ bool P_CheckSector(sector_t *sector, int crunch, int amt, int floorOrCeil)
 
 msecnode_t *headsecnode = NULL;
 
+// Bumped whenever a node is added to or taken off a sector's thing list, or
+// a list's visited marks are cleared. Lets P_CheckSector tell whether it can
+// carry on scanning from where it left off.
+unsigned int secnodegen;
+
 // sf: fix annoying crash on restarting levels
 //
 //      This crash occurred because the msecnode_t's are allocated as
@@ -2660,6 +2687,7 @@ static msecnode_t *P_AddSecnode(sector_t *s, Mobj *thing, msecnode_t *nextnode)
    // of the list.
    
    node = P_GetSecnode();
+   ++secnodegen;
    
    node->visited = 0;  // killough 4/4/98, 4/7/98: mark new nodes unvisited.
 
@@ -2723,6 +2751,7 @@ static msecnode_t *P_DelSecnode(msecnode_t *node)
       // Return this node to the freelist
       
       P_PutSecnode(node);
+      ++secnodegen;
       
       node = tn;
    }
@@ -2834,6 +2863,66 @@ static bool PIT_GetSectors(line_t *ld, polyobj_s *po)
    return true;
 }
 
+//
+// P_sameLineCells
+//
+// True if the two boxes cover the same blockmap cells.
+//
+static bool P_sameLineCells(const fixed_t *a, const fixed_t *b)
+{
+   return
+      (a[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT == (b[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT &&
+      (a[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT == (b[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT &&
+      (a[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT == (b[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT &&
+      (a[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT == (b[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT;
+}
+
+//
+// P_reuseSecNodeList
+//
+// A thing that touched no line when its list was last built, and has since
+// stayed within the same blockmap cells without moving as far as the nearest
+// line's box, still touches nothing but the sector it is in. Its old list,
+// which holds just that sector, is then the list P_CreateSecNodeList would
+// come up with, down to the order of the nodes.
+//
+static bool P_reuseSecNodeList(const Mobj *thing, const fixed_t *bbox)
+{
+   const msecnode_t *list = thing->old_sectorlist;
+
+   if(useportalgroups || thing->secnodeclear < 0 || !list || list->m_tnext ||
+      list->m_sector != thing->subsector->sector)
+      return false;
+
+   if(!P_sameLineCells(thing->secnodebox, bbox))
+      return false;
+
+   for(int i = 0; i < 4; i++)
+   {
+      int64_t moved = int64_t(bbox[i]) - thing->secnodebox[i];
+
+      if(moved > thing->secnodeclear || -moved > thing->secnodeclear)
+         return false;
+   }
+
+   // a polyobject may have come in since
+   int xl = (bbox[BOXLEFT  ] - bmaporgx) >> MAPBLOCKSHIFT;
+   int xh = (bbox[BOXRIGHT ] - bmaporgx) >> MAPBLOCKSHIFT;
+   int yl = (bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+   int yh = (bbox[BOXTOP   ] - bmaporgy) >> MAPBLOCKSHIFT;
+
+   for(int by = emax(yl, 0); by <= yh && by < bmapheight; by++)
+   {
+      for(int bx = emax(xl, 0); bx <= xh && bx < bmapwidth; bx++)
+      {
+         if(polyblocklinks[by * bmapwidth + bx])
+            return false;
+      }
+   }
+
+   return true;
+}
+
 //
 // P_CreateSecNodeList 
 //
@@ -2849,6 +2938,7 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
 {
    int xl, xh, yl, yh, bx, by;
    msecnode_t *node, *list;
+   bool clearcheck = false;
 
    if(demo_version < 200 || demo_version >= 329)
       P_PushClipStack();
@@ -2871,14 +2961,20 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
    pClip->bbox[BOXRIGHT]  = x + thing->radius;
    pClip->bbox[BOXLEFT]   = x - thing->radius;
 
-   validcount++; // used to make sure we only process a line once
+   // used to make sure we only process a line once
+   ValidContext::Global().newQuery();
 
    pClip->sector_list = thing->old_sectorlist;
 
+   if(P_reuseSecNodeList(thing, pClip->bbox))
+   {
+      list = pClip->sector_list;
+      list->m_thing = thing;
+   }
    // ioanch 20160115: use portal-aware gathering if there are portals. Sectors
    // may be touched both horizontally (like in Doom) or vertically (thing
    // touching portals
-   if(useportalgroups && full_demo_version >= make_full_version(340, 48))
+   else if(useportalgroups && full_demo_version >= make_full_version(340, 48))
    {
       // FIXME: unfortunately all sectors need to be added, because this function
       // is only called on XY coordinate change.
@@ -2928,14 +3024,18 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
       yl = (pClip->bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
       yh = (pClip->bbox[BOXTOP   ] - bmaporgy) >> MAPBLOCKSHIFT;
 
+      // without portal groups every line is tested against the plain box
+      const fixed_t *bbox = useportalgroups ? nullptr : pClip->bbox;
+
       for(bx = xl; bx <= xh; bx++)
       {
          for(by = yl; by <= yh; by++)
-            P_BlockLinesIterator(bx, by, PIT_GetSectors);
+            P_BlockLinesIteratorBox(bx, by, bbox, PIT_GetSectors);
       }
 
       // Add the sector of the (x,y) point to sector_list.
       list = P_AddSecnode(thing->subsector->sector, thing, pClip->sector_list);
+      clearcheck = !useportalgroups;
    }
 
    // Now delete any nodes that won't be used. These are the ones where
@@ -2953,6 +3053,26 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
          node = node->m_tnext;
    }
 
+   // If the thing is only in the sector of its center, remember how far it
+   // can go before it needs to look at lines again.
+   if(clearcheck)
+   {
+      fixed_t clear = -1;
+
+      if(list && !list->m_tnext)
+      {
+         clear = D_MAXINT;
+         for(bx = xl; bx <= xh && clear >= 0; bx++)
+         {
+            for(by = yl; by <= yh && clear >= 0; by++)
+               clear = emin(clear, P_BlockLinesClearance(bx, by, pClip->bbox));
+         }
+      }
+
+      memcpy(thing->secnodebox, pClip->bbox, sizeof(thing->secnodebox));
+      thing->secnodeclear = clear;
+   }
+
   /* cph -
    * This is the strife we get into for using global variables. 
    *  clip.thing is being used by several different functions calling
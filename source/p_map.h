@@ -97,6 +97,11 @@ bool P_PortalTeleportMove(Mobj *thing, fixed_t x, fixed_t y);
 //
 
 bool P_CheckSight(Mobj *t1, Mobj *t2);
+void P_SightWorldChanged();
+void P_SightSectorChanged(const sector_t *sec);
+
+// Bit standing for a sector in a sight check's sector mask
+#define P_SightSectorBit(sec) ((uint64_t)1 << (((sec) - sectors) & 63))
 void P_UseLines(player_t *player);
 
 // killough 8/2/98: add 'mask' argument to prevent friends autoaiming at others
@@ -145,6 +150,8 @@ void P_ApplyTorque(Mobj *mo);                       // killough 9/12/98
 // Secnode List Maintenance Routines
 //
 
+extern unsigned int secnodegen; // changes whenever nodes or their marks do
+
 void P_DelSeclist(msecnode_t *); // phares 3/16/98
 void P_FreeSecNodeList();        // sf
 msecnode_t *P_CreateSecNodeList(Mobj *, fixed_t, fixed_t);  // phares 3/14/98
@@ -55,6 +55,7 @@
 #include "p_portal.h"
 #include "p_portalclip.h"  // ioanch 20160115
 #include "p_setup.h"
+#include "p_valid.h"
 #include "r_main.h"
 #include "r_pcheck.h"
 
@@ -629,7 +630,7 @@ bool P_CheckPosition3D(Mobj *thing, fixed_t x, fixed_t y)
    clip.floorpic = bottomsector->floorpic;
    // SoM: 09/07/02: 3dsides monster fix
    clip.touch3dside = 0;
-   validcount++;
+   ValidContext::Global().newQuery();
    
    clip.numspechit = 0;
 
@@ -745,8 +746,29 @@ bool P_CheckPosition3D(Mobj *thing, fixed_t x, fixed_t y)
    if(!P_TransPortalBlockWalker(bbox, thing->groupid, true, nullptr, 
       [](int x, int y, int groupid, void *data) -> bool
    {
+      // The lines of a group are tested against the box moved by the group's
+      // offset; see PIT_CheckLine3D.
+      fixed_t groupbox[4];
+      const fixed_t *bbox = clip.bbox;
+
+      if(useportalgroups && full_demo_version >= make_full_version(340, 48))
+      {
+         if(groupid == R_NOGROUP)
+            bbox = nullptr;
+         else
+         {
+            const linkoffset_t *link = P_GetLinkOffset(clip.thing->groupid,
+                                                       groupid);
+            groupbox[BOXLEFT]   = clip.bbox[BOXLEFT]   + link->x;
+            groupbox[BOXBOTTOM] = clip.bbox[BOXBOTTOM] + link->y;
+            groupbox[BOXRIGHT]  = clip.bbox[BOXRIGHT]  + link->x;
+            groupbox[BOXTOP]    = clip.bbox[BOXTOP]    + link->y;
+            bbox = groupbox;
+         }
+      }
+
       // ioanch 20160112: try 3D portal check-line
-      if(!P_BlockLinesIterator(x, y, PIT_CheckLine3D, groupid))
+      if(!P_BlockLinesIteratorBox(x, y, bbox, PIT_CheckLine3D, groupid))
          return false; // doesn't fit
       return true;
    }))
@@ -1332,19 +1354,25 @@ bool P_ChangeSector3D(sector_t *sector, int crunch, int amt, int floorOrCeil)
 
    for (n = sector->touching_thinglist; n; n = n->m_snext)
       n->visited = false;
+   ++secnodegen;
+
+   // As in P_CheckSector, resume after the last thing processed when the
+   // lists haven't changed under us.
+   bool portalaware = 
+      useportalgroups && full_demo_version >= make_full_version(340, 48);
+   msecnode_t *start = sector->touching_thinglist;
 
    do
    {
-      for(n = sector->touching_thinglist; n; n = n->m_snext) // go through list
+      for(n = start; n; n = n->m_snext) // go through list
       {
          // ioanch 20160115: portal aware
-         if(useportalgroups && full_demo_version >= make_full_version(340, 48) &&
-            !P_SectorTouchesThingVertically(sector, n->m_thing))
-         {
+         if(portalaware && !P_SectorTouchesThingVertically(sector, n->m_thing))
             continue;
-         }
          if(!n->visited) // unprocessed thing found
          {
+            unsigned int gen = secnodegen;
+
             n->visited = true;                       // mark thing as processed
             if(!(n->m_thing->flags & MF_NOBLOCKMAP)) // jff 4/7/98 don't do these
             {
@@ -1352,6 +1380,11 @@ bool P_ChangeSector3D(sector_t *sector, int crunch, int amt, int floorOrCeil)
                if(iterator2)
                   iterator2(n->m_thing);
             }
+
+            if(!portalaware && gen == secnodegen)
+               start = n->m_snext;
+            else
+               start = sector->touching_thinglist;
             break;                                   // exit and start over
          }
       }
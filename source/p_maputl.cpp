@@ -31,17 +31,25 @@
 #include "doomstat.h"
 #include "e_exdata.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "p_map.h"
 #include "p_map3d.h"
 #include "p_maputl.h"
 #include "p_portalclip.h"
 #include "p_setup.h"
+#include "p_valid.h"
 #include "polyobj.h"
 #include "r_data.h"
 #include "r_main.h"
 #include "r_portal.h"
 #include "r_state.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EE_LINEBOX_SSE2
+#endif
+
 
 //
 // P_AproxDistance
@@ -430,6 +438,74 @@ void P_LogThingPosition(Mobj *mo, const char *caller)
 #define P_LogThingPosition(a, b)
 #endif
 
+//
+// Dense thing lists
+//
+// Every blockmap cell keeps an array of the things linked into it, in the
+// reverse order of the blocklinks chain, so that P_BlockThingsIterator can
+// fetch the next thing without first loading the current one. The chain is
+// still the authority: the iterator checks each step against bnext and
+// falls back to walking the chain as soon as the two disagree, so the order
+// in which things are visited is exactly what it always was.
+//
+struct blockthings_t
+{
+   Mobj **things;    // oldest first; the chain runs from the end
+   int    numthings;
+   int    numalloc;
+};
+
+static blockthings_t *blockthings;
+
+//
+// P_InitBlockThings
+//
+// Called once blocklinks has been allocated for a new level.
+//
+void P_InitBlockThings()
+{
+   blockthings = estructalloctag(blockthings_t, bmapwidth * bmapheight, PU_LEVEL);
+}
+
+//
+// P_addBlockThing
+//
+static void P_addBlockThing(Mobj *thing, int cell)
+{
+   blockthings_t *bt = &blockthings[cell];
+
+   if(bt->numthings == bt->numalloc)
+   {
+      bt->numalloc = bt->numalloc ? bt->numalloc * 2 : 4;
+      bt->things = (Mobj **)Z_Realloc(bt->things, bt->numalloc * sizeof(Mobj *),
+                                      PU_LEVEL, NULL);
+   }
+   bt->things[bt->numthings++] = thing;
+   thing->bthings = bt;
+}
+
+//
+// P_removeBlockThing
+//
+// Keeps the order of the remaining things, as unlinking does.
+//
+static void P_removeBlockThing(Mobj *thing)
+{
+   blockthings_t *bt = thing->bthings;
+
+   for(int i = bt->numthings - 1; i >= 0; i--)
+   {
+      if(bt->things[i] == thing)
+      {
+         memmove(bt->things + i, bt->things + i + 1,
+                 (bt->numthings - i - 1) * sizeof(Mobj *));
+         bt->numthings--;
+         break;
+      }
+   }
+   thing->bthings = NULL;
+}
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -485,6 +561,9 @@ void P_UnsetThingPosition(Mobj *thing)
       Mobj *bnext, **bprev = thing->bprev;
       if(bprev && (*bprev = bnext = thing->bnext))  // unlink from block map
          bnext->bprev = bprev;
+
+      if(thing->bthings)
+         P_removeBlockThing(thing);
    }
 }
 
@@ -544,6 +623,10 @@ void P_SetThingPosition(Mobj *thing)
       // inert things don't need to be in blockmap
       int blockx = (thing->x - bmaporgx) >> MAPBLOCKSHIFT;
       int blocky = (thing->y - bmaporgy) >> MAPBLOCKSHIFT;
+
+      // still in a cell if its flags changed since it was last linked
+      if(thing->bthings)
+         P_removeBlockThing(thing);
       
       if(blockx >= 0 && blockx < bmapwidth && blocky >= 0 && blocky < bmapheight)
       {
@@ -556,6 +639,8 @@ void P_SetThingPosition(Mobj *thing)
             bnext->bprev = &thing->bnext;
          thing->bprev = link;
          *link = thing;
+
+         P_addBlockThing(thing, blocky*bmapwidth+blockx);
       }
       else        // thing is off the map
          thing->bnext = NULL, thing->bprev = NULL;
@@ -610,6 +695,129 @@ bool ThingIsOnLine(const Mobj *t, const line_t *l)
 // exit with false without checking anything else.
 //
 
+//=============================================================================
+//
+// Line Box Broadphase
+//
+// Most lines in the cells a moving thing overlaps are nowhere near it, and
+// the clipping callbacks throw those out with a bounding box test as the very
+// first thing they do. To make that cheaper, each entry of blockmaplump gets a
+// copy of its line's bounding box, stored as four parallel arrays, so that the
+// boxes of four entries at a time can be tested with a few vector compares
+// without touching the line_t's at all. Only lines that pass are handed to the
+// callback, in their original order.
+//
+// The copies are made once the level is set up. Polyobject lines move, so
+// their entries always pass and the callback makes the call. Entries that are
+// not valid line numbers never pass.
+//
+
+static byte    *lineboxblock; // single allocation, freed with the level
+static fixed_t *lineboxleft;
+static fixed_t *lineboxright;
+static fixed_t *lineboxbottom;
+static fixed_t *lineboxtop;
+static int     *lineboxcount; // per cell, entries before the -1; -1 if unsafe
+
+//
+// P_InitLineBoxes
+//
+// Builds the box arrays. Called from P_SetupLevel once polyobjects exist.
+//
+void P_InitLineBoxes()
+{
+   int numcells = bmapwidth * bmapheight;
+   int numboxes = bmaplumpsize + 3; // slack for reading four at a time
+   size_t boxsize = numboxes * sizeof(fixed_t);
+
+   lineboxblock = (byte *)(Z_Malloc(4 * boxsize + numcells * sizeof(int),
+                                    PU_LEVEL, (void **)&lineboxblock));
+
+   lineboxleft   = (fixed_t *)(lineboxblock);
+   lineboxright  = (fixed_t *)(lineboxblock +     boxsize);
+   lineboxbottom = (fixed_t *)(lineboxblock + 2 * boxsize);
+   lineboxtop    = (fixed_t *)(lineboxblock + 3 * boxsize);
+   lineboxcount  = (int     *)(lineboxblock + 4 * boxsize);
+
+   for(int i = 0; i < numboxes; i++)
+   {
+      int num = i < bmaplumpsize ? blockmaplump[i] : -1;
+
+      if(num < 0 || num >= numlines)
+      {
+         // never overlaps anything
+         lineboxleft[i]   = lineboxbottom[i] = D_MAXINT;
+         lineboxright[i]  = lineboxtop[i]    = D_MININT;
+      }
+      else if(lines[num].intflags & MLI_DYNASEGLINE)
+      {
+         // polyobject line; always let the callback decide
+         lineboxleft[i]   = lineboxbottom[i] = D_MININT;
+         lineboxright[i]  = lineboxtop[i]    = D_MAXINT;
+      }
+      else
+      {
+         const line_t *ld = &lines[num];
+
+         lineboxleft[i]   = ld->bbox[BOXLEFT];
+         lineboxright[i]  = ld->bbox[BOXRIGHT];
+         lineboxbottom[i] = ld->bbox[BOXBOTTOM];
+         lineboxtop[i]    = ld->bbox[BOXTOP];
+      }
+   }
+
+   // Count each cell's entries up to its terminator. Cells of malformed
+   // blockmaps whose lists run off the end keep using the plain iterator.
+   for(int cell = 0; cell < numcells; cell++)
+   {
+      int offset = blockmap[cell];
+      int end    = offset;
+
+      while(end >= 0 && end < bmaplumpsize && blockmaplump[end] != -1)
+         ++end;
+
+      lineboxcount[cell] = 
+         (offset >= 0 && end < bmaplumpsize) ? end - offset : -1;
+   }
+}
+
+//
+// P_lineBoxMask
+//
+// Returns a bit for each of the four entries starting at index whose box
+// overlaps the given one, using the same open comparisons as PIT_CheckLine.
+//
+static inline unsigned int P_lineBoxMask(int index, const fixed_t *bbox)
+{
+#ifdef EE_LINEBOX_SSE2
+   __m128i left   = _mm_loadu_si128((const __m128i *)(lineboxleft   + index));
+   __m128i right  = _mm_loadu_si128((const __m128i *)(lineboxright  + index));
+   __m128i bottom = _mm_loadu_si128((const __m128i *)(lineboxbottom + index));
+   __m128i top    = _mm_loadu_si128((const __m128i *)(lineboxtop    + index));
+
+   __m128i hit = _mm_and_si128(
+      _mm_and_si128(_mm_cmpgt_epi32(_mm_set1_epi32(bbox[BOXRIGHT]), left),
+                    _mm_cmpgt_epi32(right, _mm_set1_epi32(bbox[BOXLEFT]))),
+      _mm_and_si128(_mm_cmpgt_epi32(_mm_set1_epi32(bbox[BOXTOP]), bottom),
+                    _mm_cmpgt_epi32(top, _mm_set1_epi32(bbox[BOXBOTTOM]))));
+
+   return (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(hit));
+#else
+   unsigned int mask = 0;
+
+   for(int i = 0; i < 4; i++)
+   {
+      if(bbox[BOXRIGHT]  > lineboxleft[index + i]   &&
+         bbox[BOXLEFT]   < lineboxright[index + i]  &&
+         bbox[BOXTOP]    > lineboxbottom[index + i] &&
+         bbox[BOXBOTTOM] < lineboxtop[index + i])
+         mask |= 1 << i;
+   }
+
+   return mask;
+#endif
+}
+
 //
 // P_BlockLinesIterator
 // The validcount flags are used to avoid checking lines
@@ -622,15 +830,35 @@ bool ThingIsOnLine(const Mobj *t, const line_t *l)
 // ioanch 20160111: added groupid
 // ioanch 20160114: enhanced the callback
 //
-bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*), int groupid)
+bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*), int groupid,
+                          ValidContext *vc)
 {
+   return P_BlockLinesIteratorBox(x, y, nullptr, func, groupid, vc);
+}
+
+//
+// P_BlockLinesIteratorBox
+//
+// As P_BlockLinesIterator, but skips blockmap lines whose bounding boxes
+// don't overlap bbox, for callbacks that would reject them anyway. Skipped
+// lines are not marked with validcount. Polyobject lines are not filtered.
+// A NULL bbox filters nothing.
+//
+// Lines are marked in vc, or with the global validcount if it is NULL.
+//
+bool P_BlockLinesIteratorBox(int x, int y, const fixed_t *bbox,
+                             bool func(line_t *, polyobj_t *), int groupid,
+                             ValidContext *vc)
+{
+   ValidContext &valid = vc ? *vc : ValidContext::Global();
    int        offset;
+   int        cell;
    const int  *list;     // killough 3/1/98: for removal of blockmap limit
    DLListItem<polymaplink_t> *plink; // haleyjd 02/22/06
    
    if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
       return true;
-   offset = y * bmapwidth + x;
+   offset = cell = y * bmapwidth + x;
 
    // haleyjd 02/22/06: consider polyobject lines
    plink = polyblocklinks[offset];
@@ -639,16 +867,14 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*), int grou
    {
       polyobj_t *po = (*plink)->po;
 
-      if(po->validcount != validcount) // if polyobj hasn't been checked
+      if(valid.markPolyobj(po)) // if polyobj hasn't been checked
       {
          int i;
-         po->validcount = validcount;
          
          for(i = 0; i < po->numLines; ++i)
          {
-            if(po->lines[i]->validcount == validcount) // line has been checked
+            if(!valid.markLine(po->lines[i])) // line has been checked
                continue;
-            po->lines[i]->validcount = validcount;
             if(!func(po->lines[i], po))
                return false;
          }
@@ -666,6 +892,38 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*), int grou
 
    // killough 2/22/98: demo_compatibility check
    // skip 0 starting delimiter -- phares
+   if(bbox && lineboxblock && lineboxcount[cell] >= 0)
+   {
+      int start = demo_compatibility ? 0 : 1;
+      int count = lineboxcount[cell];
+
+      for(int i = start; i < count; i += 4)
+      {
+         unsigned int mask = P_lineBoxMask(offset + i, bbox);
+
+         if(count - i < 4)
+            mask &= (1u << (count - i)) - 1;
+
+         for(int bit = 0; mask; bit++, mask >>= 1)
+         {
+            line_t *ld;
+
+            if(!(mask & 1))
+               continue;
+
+            ld = &lines[list[i + bit]];
+            if(groupid != R_NOGROUP && groupid != ld->frontsector->groupid)
+               continue;
+            if(!valid.markLine(ld))
+               continue;       // line has already been checked
+            if(!func(ld, nullptr))
+               return false;
+         }
+      }
+
+      return true;
+   }
+
    if(!demo_compatibility)
       list++;     
    for( ; *list != -1; list++)
@@ -681,9 +939,8 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*), int grou
       // ioanch 20160111: check groupid
       if(groupid != R_NOGROUP && groupid != ld->frontsector->groupid)
          continue;
-      if(ld->validcount == validcount)
+      if(!valid.markLine(ld))
          continue;       // line has already been checked
-      ld->validcount = validcount;
       if(!func(ld, nullptr))
          return false;
    }
@@ -691,32 +948,131 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*), int grou
 }
 
 //
-// P_BlockThingsIterator
+// P_BlockLinesClearance
 //
-// killough 5/3/98: reformatted, cleaned up
-// ioanch 20160108: variant with groupid
+// Returns how far bbox can move in any direction without overlapping the
+// box of a line listed in the given blockmap cell, or -1 if it already does
+// or the cell can't be judged from the box arrays (polyobjects, bad lists).
 //
-bool P_BlockThingsIterator(int x, int y, int groupid, bool (*func)(Mobj *))
+fixed_t P_BlockLinesClearance(int x, int y, const fixed_t *bbox)
 {
-   if(!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
+   if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+      return D_MAXINT; // never iterated
+
+   int cell = y * bmapwidth + x;
+
+   if(!lineboxblock || lineboxcount[cell] < 0 || polyblocklinks[cell])
+      return -1;
+
+   int     offset = blockmap[cell];
+   int64_t clear  = D_MAXINT;
+
+   // include the leading 0 for demo_compatibility's sake
+   for(int i = offset; i < offset + lineboxcount[cell]; i++)
    {
-      Mobj *mobj = blocklinks[y * bmapwidth + x];
+      int64_t gap = int64_t(lineboxleft[i]) - bbox[BOXRIGHT];
+
+      gap = emax(gap, int64_t(bbox[BOXLEFT])   - lineboxright[i]);
+      gap = emax(gap, int64_t(lineboxbottom[i]) - bbox[BOXTOP]);
+      gap = emax(gap, int64_t(bbox[BOXBOTTOM]) - lineboxtop[i]);
+
+      if(gap < 0)
+         return -1;
+      clear = emin(clear, gap);
+   }
 
-      for(; mobj; mobj = mobj->bnext)
+   return fixed_t(clear);
+}
+
+//
+// P_skipBlockThing
+//
+// Tests that callers would otherwise make first thing in their callback and
+// return true on. None of them have side effects, so skipping is the same as
+// calling.
+//
+static inline bool P_skipBlockThing(const Mobj *mobj, int groupid,
+                                    unsigned int flags, bool clipdist)
+{
+   // ioanch: if mismatching group id (in case it's declared), skip
+   if(groupid != R_NOGROUP && mobj->groupid != R_NOGROUP && 
+      groupid != mobj->groupid)
+   {
+      return true;   // ignore objects from wrong groupid
+   }
+
+   if(flags && !(mobj->flags & flags))
+      return true;
+
+   if(clipdist)
+   {
+      fixed_t blockdist = mobj->radius + clip.thing->radius;
+
+      if(D_abs(mobj->x - clip.x) >= blockdist ||
+         D_abs(mobj->y - clip.y) >= blockdist)
+         return true;
+   }
+
+   return false;
+}
+
+//
+// P_BlockThingsIteratorFilter
+//
+// As P_BlockThingsIterator, but only calls func for things that have one of
+// the given flags (any thing if flags is 0) and, if clipdist is set, whose
+// box touches that of clip.thing at clip.x, clip.y. Everything is read
+// afresh for each thing, since func may move things or change the clip.
+//
+bool P_BlockThingsIteratorFilter(int x, int y, int groupid, unsigned int flags,
+                                 bool clipdist, bool (*func)(Mobj *))
+{
+   if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+      return true;
+
+   int cell = y * bmapwidth + x;
+   const blockthings_t *bt = &blockthings[cell];
+   Mobj *mobj = blocklinks[cell];
+   int i = bt->numthings - 1;
+
+   if(i >= 0 && bt->things[i] == mobj)
+   {
+      // walk the array for as long as it matches the chain
+      for(;;)
       {
-         // ioanch: if mismatching group id (in case it's declared), skip
-         if(groupid != R_NOGROUP && mobj->groupid != R_NOGROUP && 
-            groupid != mobj->groupid)
-         {
-            continue;   // ignore objects from wrong groupid
-         }
-         if(!func(mobj))
+         mobj = bt->things[i];
+
+         if(!P_skipBlockThing(mobj, groupid, flags, clipdist) && !func(mobj))
             return false;
+
+         // func may have (re)linked things here; re-read everything
+         if(i > bt->numthings || mobj->bnext != (i ? bt->things[i - 1] : NULL))
+            break;
+         if(!i--)
+            return true;
       }
+      mobj = mobj->bnext;
+   }
+
+   for(; mobj; mobj = mobj->bnext)
+   {
+      if(!P_skipBlockThing(mobj, groupid, flags, clipdist) && !func(mobj))
+         return false;
    }
    return true;
 }
 
+//
+// P_BlockThingsIterator
+//
+// killough 5/3/98: reformatted, cleaned up
+// ioanch 20160108: variant with groupid
+//
+bool P_BlockThingsIterator(int x, int y, int groupid, bool (*func)(Mobj *))
+{
+   return P_BlockThingsIteratorFilter(x, y, groupid, 0, false, func);
+}
+
 //
 // P_PointToAngle
 //
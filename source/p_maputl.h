@@ -34,6 +34,7 @@ struct line_t;
 class  Mobj;
 struct mobjinfo_t;
 struct polyobj_s; // ioanch 20160114
+class  ValidContext;
 
 // mapblocks are used to check movement against lines and things
 #define MAPBLOCKUNITS   128
@@ -106,7 +107,16 @@ void    P_LineOpening (const line_t *linedef, const Mobj *mo,
 void P_UnsetThingPosition(Mobj *thing);
 void P_SetThingPosition(Mobj *thing);
 bool P_BlockLinesIterator (int x, int y, bool func(line_t *, polyobj_s *),
-                           int groupid = R_NOGROUP);
+                           int groupid = R_NOGROUP, ValidContext *vc = nullptr);
+bool P_BlockLinesIteratorBox(int x, int y, const fixed_t *bbox,
+                             bool func(line_t *, polyobj_s *),
+                             int groupid = R_NOGROUP,
+                             ValidContext *vc = nullptr);
+void P_InitLineBoxes();
+fixed_t P_BlockLinesClearance(int x, int y, const fixed_t *bbox);
+void P_InitBlockThings();
+bool P_BlockThingsIteratorFilter(int x, int y, int groupid, unsigned int flags,
+                                 bool clipdist, bool (*func)(Mobj *));
 bool P_BlockThingsIterator(int x, int y, int groupid, bool (*func)(Mobj *));
 inline static bool P_BlockThingsIterator(int x, int y, bool func(Mobj *))
 {
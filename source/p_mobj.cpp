@@ -153,112 +153,93 @@ void PointThinker::removeThinker()
 //
 
 // haleyjd 03/27/10: new solution for state cycle detection
+//
+// Each call to P_SetMobjState takes a new generation number and stamps every
+// state it passes through with it, so a state has been seen by the current
+// call exactly when its stamp matches. Action functions may call back into
+// P_SetMobjState, so any stamp overwritten by a call is saved on an undo stack
+// and put back when that call returns.
+//
 struct seenstate_t
 {
-   DLListItem<seenstate_t> link;
-   int statenum;
+   int          statenum;
+   unsigned int stamp;
 };
 
-// haleyjd 03/27/10: freelist of seenstate objects
-static DLListItem<seenstate_t> *seenstate_freelist;
+static unsigned int *seenstamps;     // generation stamp for each state
+static int           numseenstamps;  // number of states stamps are allocated for
+static unsigned int  seengeneration; // last generation number handed out
 
-//
-// P_InitSeenStates
-//
-// haleyjd 03/27/10: creates an initial pool of seenstate objects.
-//
-static void P_InitSeenStates(void)
-{
-   seenstate_t *newss;
-   int i;
-
-   newss = ecalloc(seenstate_t *, 32, sizeof(seenstate_t));
-
-   for(i = 0; i < 32; ++i)
-      newss[i].link.insert(&newss[i], &seenstate_freelist);
-}
+static PODCollection<seenstate_t> seenundo; // stamps to restore
 
 //
-// P_FreeSeenStates
+// P_NewSeenGeneration
 //
-// haleyjd 03/27/10: puts a set of seenstates back onto the freelist
+// Start a new set of seen states and return its generation number. The stamp
+// array is grown if EDF has added states since it was allocated.
 //
-static void P_FreeSeenStates(DLListItem<seenstate_t> *list)
+static unsigned int P_NewSeenGeneration()
 {
-   DLListItem<seenstate_t> *oldhead = seenstate_freelist;
-   DLListItem<seenstate_t> *newtail = list;
-
-   // find tail of list of objects to free
-   while(newtail->dllNext)
-      newtail = newtail->dllNext;
+   if(numseenstamps < NUMSTATES)
+   {
+      seenstamps = erealloc(unsigned int *, seenstamps, NUMSTATES * sizeof(unsigned int));
+      memset(seenstamps + numseenstamps, 0,
+             (NUMSTATES - numseenstamps) * sizeof(unsigned int));
+      numseenstamps = NUMSTATES;
+   }
 
-   // attach current freelist to tail
-   newtail->dllNext = oldhead;
-   if(oldhead)
-      oldhead->dllPrev = &newtail->dllNext;
+   // on wraparound, clear out stamps that could collide with new generations
+   if(++seengeneration == 0)
+   {
+      memset(seenstamps, 0, numseenstamps * sizeof(unsigned int));
+      seengeneration = 1;
+   }
 
-   // attach new list to seenstate_freelist
-   seenstate_freelist = list;
-   list->dllPrev = &seenstate_freelist;
+   return seengeneration;
 }
 
 //
-// P_GetSeenState
+// P_AddSeenState
 //
-// Gets a seenstate from the free list if one is available, or creates a
-// new one.
+// Marks a new state as having been seen in the given generation.
 //
-static seenstate_t *P_GetSeenState()
+static void P_AddSeenState(int statenum, unsigned int generation)
 {
-   seenstate_t *ret;
+   unsigned int &stamp = seenstamps[statenum];
 
-   if(seenstate_freelist)
+   if(stamp != generation)
    {
-      DLListItem<seenstate_t> *item = seenstate_freelist;
-
-      item->remove();
-
-      ret = *item;
-      memset(ret, 0, sizeof(seenstate_t));
+      seenstate_t &undo = seenundo.addNew();
+      undo.statenum = statenum;
+      undo.stamp    = stamp;
+      stamp = generation;
    }
-   else
-      ret = ecalloc(seenstate_t *, 1, sizeof(seenstate_t));
-
-   return ret;
 }
 
 //
-// P_AddSeenState
+// P_CheckSeenState
 //
-// Marks a new state as having been seen.
+// Checks if the given state has been seen in the given generation.
 //
-static void P_AddSeenState(int statenum, DLListItem<seenstate_t> **list)
+static bool P_CheckSeenState(int statenum, unsigned int generation)
 {
-   seenstate_t *newss = P_GetSeenState();
-
-   newss->statenum = statenum;
-
-   newss->link.insert(newss, list);
+   return seenstamps[statenum] == generation;
 }
 
 //
-// P_CheckSeenState
+// P_FreeSeenStates
 //
-// Checks if the given state has been seen
+// Restores the stamps overwritten since the undo stack was at the given depth,
+// most recent first, so that any P_SetMobjState call in progress further up
+// the stack finds its own marks intact.
 //
-static bool P_CheckSeenState(int statenum, DLListItem<seenstate_t> *list)
+static void P_FreeSeenStates(size_t undobase)
 {
-   DLListItem<seenstate_t> *link = list;
-
-   while(link)
+   while(seenundo.getLength() > undobase)
    {
-      if(statenum == (*link)->statenum)
-         return true;
-
-      link = link->dllNext;
+      const seenstate_t &undo = seenundo.pop();
+      seenstamps[undo.statenum] = undo.stamp;
    }
-
-   return false;
 }
 
 //
@@ -271,15 +252,9 @@ bool P_SetMobjState(Mobj* mobj, statenum_t state)
    state_t *st;
 
    // haleyjd 03/27/10: new state cycle detection
-   static bool firsttime = true; // for initialization
-   DLListItem<seenstate_t> *seenstates  = NULL; // list of seenstates for this instance
-   bool ret = true;                           // return value
-
-   if(firsttime)
-   {
-      P_InitSeenStates();
-      firsttime = false;
-   }
+   size_t       undobase   = seenundo.getLength(); // undo stack depth on entry
+   unsigned int generation = P_NewSeenGeneration(); // stamp for this instance
+   bool ret = true;                                 // return value
 
    do
    {
@@ -323,18 +298,17 @@ bool P_SetMobjState(Mobj* mobj, statenum_t state)
       if(st->particle_evt)
          P_RunEvent(mobj);
 
-      P_AddSeenState(state, &seenstates);
+      P_AddSeenState(state, generation);
 
       state = st->nextstate;
    }
-   while(!mobj->tics && !P_CheckSeenState(state, seenstates));
+   while(!mobj->tics && !P_CheckSeenState(state, generation));
    
    if(ret && !mobj->tics)  // killough 4/9/98: detect state cycles
       doom_printf(FC_ERROR "Warning: State Cycle Detected");
 
-   // put seenstates onto freelist
-   if(seenstates)
-      P_FreeSeenStates(seenstates);
+   // restore any stamps belonging to callers
+   P_FreeSeenStates(undobase);
 
    return ret;
 }
@@ -1531,6 +1505,7 @@ void Mobj::serialize(SaveArchive &arc)
       }
 
       backupPosition();
+      secnodeclear = -1; // no sector list to reuse yet
       P_SetThingPosition(this);
       P_AddThingTID(this, tid);
 
@@ -1652,6 +1627,7 @@ Mobj *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
    mobj->y       = y;
    mobj->radius  = info->radius;
    mobj->height  = P_ThingInfoHeight(info); // phares
+   mobj->secnodeclear = -1; // no sector list to reuse yet
    mobj->flags   = info->flags;
    mobj->flags2  = info->flags2;     // haleyjd
    mobj->flags3  = info->flags3;     // haleyjd
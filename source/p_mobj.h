@@ -43,6 +43,7 @@
 #include "tables.h"
 #include "linkoffs.h"
 
+struct blockthings_t;
 struct msecnode_t;
 struct player_t;
 struct skin_t;
@@ -236,6 +237,7 @@ public:
    // Links in blocks (if needed).
    Mobj  *bnext;
    Mobj **bprev; // killough 8/11/98: change to ptr-to-ptr
+   blockthings_t *bthings; // dense copy of the cell's links this is in
 
    subsector_t *subsector;
 
@@ -327,6 +329,11 @@ public:
    msecnode_t *touching_sectorlist;                 // phares 3/14/98
    msecnode_t *old_sectorlist;                      // haleyjd 04/16/10
 
+   // Box the touching sector list was last built for, and how far it can
+   // move without coming near a line; negative if the list can't be reused.
+   fixed_t secnodebox[4];
+   fixed_t secnodeclear;
+
    // SEE WARNING ABOVE ABOUT POINTER FIELDS!!!
 
    // New Fields for Eternity -- haleyjd
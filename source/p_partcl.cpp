@@ -84,6 +84,12 @@
 #include "v_video.h"
 #include "w_wad.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EE_PARTICLE_SSE2
+#endif
+
 // static integers to hold particle color values
 static byte grey1, grey2, grey3, grey4, red, green, blue, yellow, black,
             red1, green1, blue1, yellow1, purple, purple1, white,
@@ -366,33 +372,98 @@ static void P_UnsetParticlePosition(particle_t *ptcl)
 // field in the particle_t will be useful in the future,
 // I am sure.
 //
+// Particles are only relinked when they enter a different sector, since
+// the sector lists are all that the renderer walks.
+//
 static void P_SetParticlePosition(particle_t *ptcl)
 {
-   subsector_t *ss = R_PointInSubsector(ptcl->x, ptcl->y);
+   const int    n  = P_ParticleNum(ptcl);
+   subsector_t *ss = R_PointInSubsector(ParticleMotion.x[n], ParticleMotion.y[n]);
 
-   ptcl->seclinks.insert(ptcl, &(ss->sector->ptcllist));
+   if(!ptcl->subsector || ptcl->subsector->sector != ss->sector)
+   {
+      ptcl->seclinks.remove();
+      ptcl->seclinks.insert(ptcl, &(ss->sector->ptcllist));
+   }
    ptcl->subsector = ss;
 }
 
+//
+// P_addParticleMotion
+//
+// dest[i] += src[i] over one of the padded ParticleMotion arrays.
+//
+static void P_addParticleMotion(fixed_t *dest, const fixed_t *src, int count)
+{
+#ifdef EE_PARTICLE_SSE2
+   for(int i = 0; i < count; i += 4)
+   {
+      __m128i d = _mm_loadu_si128((const __m128i *)(dest + i));
+      __m128i s = _mm_loadu_si128((const __m128i *)(src  + i));
+      _mm_storeu_si128((__m128i *)(dest + i), _mm_add_epi32(d, s));
+   }
+#else
+   for(int i = 0; i < count; i++)
+      dest[i] += src[i];
+#endif
+}
+
+//
+// P_integrateParticles
+//
+// Moves every particle by its velocity and then applies its acceleration,
+// one motion array at a time. Free slots are all zero and padding is never
+// used, so the whole store can be swept without consulting the active list.
+//
+static void P_integrateParticles()
+{
+   const int count = ParticleMotion.count;
+
+   P_addParticleMotion(ParticleMotion.x,    ParticleMotion.velx, count);
+   P_addParticleMotion(ParticleMotion.y,    ParticleMotion.vely, count);
+   P_addParticleMotion(ParticleMotion.z,    ParticleMotion.velz, count);
+   P_addParticleMotion(ParticleMotion.velx, ParticleMotion.accx, count);
+   P_addParticleMotion(ParticleMotion.vely, ParticleMotion.accy, count);
+   P_addParticleMotion(ParticleMotion.velz, ParticleMotion.accz, count);
+}
+
+//
+// P_clearParticleMotion
+//
+// Zeroes a dying particle's motion so the integration pass leaves its slot
+// alone until it is reused.
+//
+static void P_clearParticleMotion(int n)
+{
+   ParticleMotion.x[n]    = ParticleMotion.y[n]    = ParticleMotion.z[n]    = 0;
+   ParticleMotion.velx[n] = ParticleMotion.vely[n] = ParticleMotion.velz[n] = 0;
+   ParticleMotion.accx[n] = ParticleMotion.accy[n] = ParticleMotion.accz[n] = 0;
+}
+
 void P_ParticleThinker(void)
 {
    int i;
    particle_t *particle, *prev;
    sector_t *psec;
    fixed_t floorheight;
+
+   if(activeParticles == -1)
+      return;
+
+   // positions and velocities are advanced for the whole store up front;
+   // the walk below only handles death, relinking and floor contact
+   P_integrateParticles();
    
    i = activeParticles;
    prev = NULL;
    while(i != -1) 
    {
       unsigned int oldtrans;
+      const int n = i;
       
-      particle = Particles + i;
+      particle = Particles + n;
       i = particle->next;
 
-      // haleyjd: unlink the particle from the world
-      P_UnsetParticlePosition(particle);
-
       // haleyjd: particles with fall to ground style don't start
       // fading or counting down their TTL until they hit the floor
       if(!(particle->styleflags & PS_FALLTOGROUND))
@@ -404,7 +475,10 @@ void P_ParticleThinker(void)
          // is it time to kill this particle?
          if(oldtrans < particle->trans || --particle->ttl == 0)
          {
+            // haleyjd: unlink the particle from the world
+            P_UnsetParticlePosition(particle);
             memset(particle, 0, sizeof(particle_t));
+            P_clearParticleMotion(n);
             if(prev)
                prev->next = i;
             else
@@ -415,17 +489,9 @@ void P_ParticleThinker(void)
          }
       }
 
-      // update and link to new position
-      particle->x += particle->velx;
-      particle->y += particle->vely;
-      particle->z += particle->velz;
+      // link to the position P_integrateParticles moved it to
       P_SetParticlePosition(particle);
 
-      // apply accelerations
-      particle->velx += particle->accx;
-      particle->vely += particle->accy;
-      particle->velz += particle->accz;
-
       // handle special movement flags (post-position-set)
 
       psec = particle->subsector->sector;
@@ -439,21 +505,21 @@ void P_ParticleThinker(void)
           psec->floorheight; 
 
       // did particle hit ground, but is now no longer on it?
-      if(particle->styleflags & PS_HITGROUND && particle->z != floorheight)
-         particle->z = floorheight;
+      if(particle->styleflags & PS_HITGROUND && ParticleMotion.z[n] != floorheight)
+         ParticleMotion.z[n] = floorheight;
 
       // floor clipping
-      if(particle->z < floorheight && psec->f_pflags & PS_PASSABLE)
+      if(ParticleMotion.z[n] < floorheight && psec->f_pflags & PS_PASSABLE)
       {
          linkdata_t *ldata = R_FPLink(psec);
 
          P_UnsetParticlePosition(particle);
-         particle->x += ldata->deltax;
-         particle->y += ldata->deltay;
-         particle->z += ldata->deltaz;
+         ParticleMotion.x[n] += ldata->deltax;
+         ParticleMotion.y[n] += ldata->deltay;
+         ParticleMotion.z[n] += ldata->deltaz;
          P_SetParticlePosition(particle);
       }
-      else if(particle->z < floorheight)
+      else if(ParticleMotion.z[n] < floorheight)
       {
          // particles with fall to ground style start ticking now
          if(particle->styleflags & PS_FALLTOGROUND)
@@ -462,8 +528,8 @@ void P_ParticleThinker(void)
          // particles with floor clipping may need to stop
          if(particle->styleflags & PS_FLOORCLIP)
          {
-            particle->z = floorheight;
-            particle->accz = particle->velz = 0;
+            ParticleMotion.z[n] = floorheight;
+            ParticleMotion.accz[n] = ParticleMotion.velz[n] = 0;
             particle->styleflags |= PS_HITGROUND;
             
             // some particles make splashes
@@ -524,15 +590,17 @@ static particle_t *JitterParticle(int ttl)
    
    if(particle) 
    {
+      const int n = P_ParticleNum(particle);
+
       // Set initial velocities
-      particle->velx = PARTICLE_VELRND;
-      particle->vely = PARTICLE_VELRND;
-      particle->velz = PARTICLE_VELRND;
+      ParticleMotion.velx[n] = PARTICLE_VELRND;
+      ParticleMotion.vely[n] = PARTICLE_VELRND;
+      ParticleMotion.velz[n] = PARTICLE_VELRND;
       
       // Set initial accelerations
-      particle->accx = PARTICLE_ACCRND;
-      particle->accy = PARTICLE_ACCRND;
-      particle->accz = PARTICLE_ACCRND;
+      ParticleMotion.accx[n] = PARTICLE_ACCRND;
+      ParticleMotion.accy[n] = PARTICLE_ACCRND;
+      ParticleMotion.accz[n] = PARTICLE_ACCRND;
       
       particle->trans = FRACUNIT;	// fully opaque
       particle->ttl = ttl;
@@ -552,20 +620,22 @@ static void MakeFountain(Mobj *actor, byte color1, byte color2)
    
    if(particle)
    {
+      const int n = P_ParticleNum(particle);
+
       angle_t an  = M_Random()<<(24-ANGLETOFINESHIFT);
       fixed_t out = FixedMul(actor->radius, M_Random()<<8);
       
-      particle->x = actor->x + FixedMul(out, finecosine[an]);
-      particle->y = actor->y + FixedMul(out, finesine[an]);
-      particle->z = actor->z + actor->height + FRACUNIT;
+      ParticleMotion.x[n] = actor->x + FixedMul(out, finecosine[an]);
+      ParticleMotion.y[n] = actor->y + FixedMul(out, finesine[an]);
+      ParticleMotion.z[n] = actor->z + actor->height + FRACUNIT;
       P_SetParticlePosition(particle);
       
       if(out < actor->radius/8)
-         particle->velz += FRACUNIT*10/3;
+         ParticleMotion.velz[n] += FRACUNIT*10/3;
       else
-         particle->velz += FRACUNIT*3;
+         ParticleMotion.velz[n] += FRACUNIT*3;
       
-      particle->accz -= FRACUNIT/11;
+      ParticleMotion.accz[n] -= FRACUNIT/11;
       if(M_Random() < 30)
       {
          particle->size = 4;
@@ -615,17 +685,19 @@ static void P_RunEffect(Mobj *actor, unsigned int effects)
       particle = JitterParticle(3 + (M_Random() & 31));
       if(particle)
       {
+         const int n = P_ParticleNum(particle);
+
          fixed_t pathdist = M_Random()<<8;
-         particle->x = backx - FixedMul(actor->momx, pathdist);
-         particle->y = backy - FixedMul(actor->momy, pathdist);
-         particle->z = backz - FixedMul(actor->momz, pathdist);
+         ParticleMotion.x[n] = backx - FixedMul(actor->momx, pathdist);
+         ParticleMotion.y[n] = backy - FixedMul(actor->momy, pathdist);
+         ParticleMotion.z[n] = backz - FixedMul(actor->momz, pathdist);
          P_SetParticlePosition(particle);
 
          speed = (M_Random () - 128) * (FRACUNIT/200);
-         particle->velx += FixedMul(speed, finecosine[an]);
-         particle->vely += FixedMul(speed, finesine[an]);
-         particle->velz -= FRACUNIT/36;
-         particle->accz -= FRACUNIT/20;
+         ParticleMotion.velx[n] += FixedMul(speed, finecosine[an]);
+         ParticleMotion.vely[n] += FixedMul(speed, finesine[an]);
+         ParticleMotion.velz[n] -= FRACUNIT/36;
+         ParticleMotion.accz[n] -= FRACUNIT/20;
          particle->color = yellow;
          particle->size = 2;
          particle->styleflags = PS_FULLBRIGHT;
@@ -636,18 +708,20 @@ static void P_RunEffect(Mobj *actor, unsigned int effects)
          particle_t *iparticle = JitterParticle(3 + (M_Random() & 31));
          if(iparticle)
          {
+            const int n = P_ParticleNum(iparticle);
+
             fixed_t pathdist = M_Random() << 8;
-            iparticle->x = backx - FixedMul(actor->momx, pathdist);
-            iparticle->y = backy - FixedMul(actor->momy, pathdist);
-            iparticle->z = backz - FixedMul(actor->momz, pathdist) + 
+            ParticleMotion.x[n] = backx - FixedMul(actor->momx, pathdist);
+            ParticleMotion.y[n] = backy - FixedMul(actor->momy, pathdist);
+            ParticleMotion.z[n] = backz - FixedMul(actor->momz, pathdist) + 
                              (M_Random() << 10);
             P_SetParticlePosition(iparticle);
 
             speed = (M_Random() - 128) * (FRACUNIT/200);
-            iparticle->velx += FixedMul(speed, finecosine[an]);
-            iparticle->vely += FixedMul(speed, finesine[an]);
-            iparticle->velz += FRACUNIT/80;
-            iparticle->accz += FRACUNIT/40;
+            ParticleMotion.velx[n] += FixedMul(speed, finecosine[an]);
+            ParticleMotion.vely[n] += FixedMul(speed, finesine[an]);
+            ParticleMotion.velz[n] += FRACUNIT/80;
+            ParticleMotion.accz[n] += FRACUNIT/40;
             iparticle->color = (M_Random() & 7) ? grey2 : grey1;            
             iparticle->size = 3;
             iparticle->styleflags = 0;
@@ -717,18 +791,20 @@ void P_DrawSplash(int count, fixed_t x, fixed_t y, fixed_t z,
             
       if(!p)
          break;
+
+      const int n = P_ParticleNum(p);
       
       p->size = 2;
       p->color = M_Random() & 0x80 ? color1 : color2;
       p->styleflags = PS_FULLBRIGHT;
-      p->velz -= M_Random() * 512;
-      p->accz -= FRACUNIT/8;
-      p->accx += (M_Random() - 128) * 8;
-      p->accy += (M_Random() - 128) * 8;
-      p->z = z - M_Random() * 1024;
+      ParticleMotion.velz[n] -= M_Random() * 512;
+      ParticleMotion.accz[n] -= FRACUNIT/8;
+      ParticleMotion.accx[n] += (M_Random() - 128) * 8;
+      ParticleMotion.accy[n] += (M_Random() - 128) * 8;
+      ParticleMotion.z[n] = z - M_Random() * 1024;
       an = (angle + (M_Random() << 21)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 15)*finecosine[an];
-      p->y = y + (M_Random() & 15)*finesine[an];
+      ParticleMotion.x[n] = x + (M_Random() & 15)*finecosine[an];
+      ParticleMotion.y[n] = y + (M_Random() & 15)*finesine[an];
       P_SetParticlePosition(p);
    }
 }
@@ -751,19 +827,21 @@ static void P_BloodDrop(int count, fixed_t x, fixed_t y, fixed_t z,
       
       if(!p)
          break;
+
+      const int n = P_ParticleNum(p);
       
       p->ttl = 96;
       p->fade = FADEFROMTTL(96);
       p->trans = FRACUNIT;
       p->size = 4;
       p->color = M_Random() & 0x80 ? color1 : color2;
-      p->velz = 128 * -3000 + M_Random();
-      p->accz = -(LevelInfo.gravity*100/256);
+      ParticleMotion.velz[n] = 128 * -3000 + M_Random();
+      ParticleMotion.accz[n] = -(LevelInfo.gravity*100/256);
       p->styleflags = PS_FLOORCLIP | PS_FALLTOGROUND;
-      p->z = z + (M_Random() - 128) * -2400;
+      ParticleMotion.z[n] = z + (M_Random() - 128) * -2400;
       an = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 10) * finecosine[an];
-      p->y = y + (M_Random() & 10) * finesine[an];
+      ParticleMotion.x[n] = x + (M_Random() & 10) * finecosine[an];
+      ParticleMotion.y[n] = y + (M_Random() & 10) * finesine[an];
       P_SetParticlePosition(p);
    }
 }
@@ -825,31 +903,33 @@ void P_SmokePuff(int count, fixed_t x, fixed_t y, fixed_t z, angle_t angle,
    {      
       if(!(p = newParticle()))
          break;
+
+      const int n = P_ParticleNum(p);
       
       p->ttl = ttl;
       p->fade = FADEFROMTTL(ttl);
       p->trans = FRACUNIT;
       p->size = 2 + M_Random() % 5;
       p->color = M_Random() & 0x80 ? color1 : color2;      
-      p->velz = M_Random() * 512;
+      ParticleMotion.velz[n] = M_Random() * 512;
       if(updown == 1) // ceiling shot?
-         p->velz = -(p->velz / 4);
-      p->accz = accz;
+         ParticleMotion.velz[n] = -(ParticleMotion.velz[n] / 4);
+      ParticleMotion.accz[n] = accz;
       p->styleflags = 0;
       
       an = (angle + ((M_Random() - 128) << 23)) >> ANGLETOFINESHIFT;
-      p->velx = (M_Random() * finecosine[an]) >> 11;
-      p->vely = (M_Random() * finesine[an]) >> 11;
-      p->accx = p->velx >> 4;
-      p->accy = p->vely >> 4;
+      ParticleMotion.velx[n] = (M_Random() * finecosine[an]) >> 11;
+      ParticleMotion.vely[n] = (M_Random() * finesine[an]) >> 11;
+      ParticleMotion.accx[n] = ParticleMotion.velx[n] >> 4;
+      ParticleMotion.accy[n] = ParticleMotion.vely[n] >> 4;
       
       if(updown == 1) // ceiling shot?
-         p->z = z - (M_Random() + 72) * 2000;
+         ParticleMotion.z[n] = z - (M_Random() + 72) * 2000;
       else
-         p->z = z + (M_Random() + 72) * 2000;
+         ParticleMotion.z[n] = z + (M_Random() + 72) * 2000;
       an = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 14) * finecosine[an];
-      p->y = y + (M_Random() & 14) * finesine[an];
+      ParticleMotion.x[n] = x + (M_Random() & 14) * finecosine[an];
+      ParticleMotion.y[n] = y + (M_Random() & 14) * finesine[an];
       P_SetParticlePosition(p);
    }
 
@@ -864,21 +944,23 @@ void P_SmokePuff(int count, fixed_t x, fixed_t y, fixed_t z, angle_t angle,
          
          if(!(p = JitterParticle(3 + (M_Random() % 24))))
             break;
+
+         const int n = P_ParticleNum(p);
          
-         p->x = x - pathdist;
-         p->y = y - pathdist;
-         p->z = z - pathdist;
+         ParticleMotion.x[n] = x - pathdist;
+         ParticleMotion.y[n] = y - pathdist;
+         ParticleMotion.z[n] = z - pathdist;
          P_SetParticlePosition(p);
          
          speed = (M_Random() - 128) * (FRACUNIT / 200);
          an = angle >> ANGLETOFINESHIFT;
-         p->velx += FixedMul(speed, finecosine[an]);
-         p->vely += FixedMul(speed, finesine[an]);
+         ParticleMotion.velx[n] += FixedMul(speed, finecosine[an]);
+         ParticleMotion.vely[n] += FixedMul(speed, finesine[an]);
          if(updown) // on ceiling or wall, fall fast
-            p->velz -= FRACUNIT/36;
+            ParticleMotion.velz[n] -= FRACUNIT/36;
          else       // on floor, throw it upward a bit
-            p->velz += FRACUNIT/2;
-         p->accz -= FRACUNIT/20;
+            ParticleMotion.velz[n] += FRACUNIT/2;
+         ParticleMotion.accz[n] -= FRACUNIT/20;
          p->color = yellow;
          p->size = 2;
          p->styleflags = PS_FULLBRIGHT;
@@ -944,6 +1026,8 @@ void P_BloodSpray(Mobj *mo, int count, fixed_t x, fixed_t y, fixed_t z,
    {
       if(!(p = newParticle()))
          break;
+
+      const int n = P_ParticleNum(p);
       
       p->ttl = 25 + M_Random() % 6;
       p->fade = FADEFROMTTL(p->ttl);
@@ -959,15 +1043,15 @@ void P_BloodSpray(Mobj *mo, int count, fixed_t x, fixed_t y, fixed_t z,
       p->styleflags = 0;
       
       an      = (angle + ((M_Random() - 128) << 23)) >> ANGLETOFINESHIFT;
-      p->velx = (M_Random() * finecosine[an]) / 768;
-      p->vely = (M_Random() * finesine[an]) / 768;
+      ParticleMotion.velx[n] = (M_Random() * finecosine[an]) / 768;
+      ParticleMotion.vely[n] = (M_Random() * finesine[an]) / 768;
 
       an      = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;      
-      p->x    = x + (M_Random() % 15) * finecosine[an];
-      p->y    = y + (M_Random() % 15) * finesine[an];
-      p->z    = z + (M_Random() - 128) * -3500;
-      p->velz = (M_Random() < 32) ? M_Random() * 140 : M_Random() * -128;
-      p->accz = -FRACUNIT/16;
+      ParticleMotion.x[n]    = x + (M_Random() % 15) * finecosine[an];
+      ParticleMotion.y[n]    = y + (M_Random() % 15) * finesine[an];
+      ParticleMotion.z[n]    = z + (M_Random() - 128) * -3500;
+      ParticleMotion.velz[n] = (M_Random() < 32) ? M_Random() * 140 : M_Random() * -128;
+      ParticleMotion.accz[n] = -FRACUNIT/16;
       
       P_SetParticlePosition(p);
    }
@@ -1000,6 +1084,8 @@ void P_DrawSplash2(int count, fixed_t x, fixed_t y, fixed_t z,
       
       if(!p)
          break;
+
+      const int n = P_ParticleNum(p);
       
       p->ttl = 12;
       p->fade = FADEFROMTTL(12);
@@ -1007,20 +1093,20 @@ void P_DrawSplash2(int count, fixed_t x, fixed_t y, fixed_t z,
       p->styleflags = 0;
       p->size = 2 + M_Random() % 5;
       p->color = M_Random() & 0x80 ? color1 : color2;
-      p->velz = M_Random() * zvel;
-      p->accz = -FRACUNIT/22;
+      ParticleMotion.velz[n] = M_Random() * zvel;
+      ParticleMotion.accz[n] = -FRACUNIT/22;
       if(kind)
       {
          an = (angle + ((M_Random() - 128) << 23)) >> ANGLETOFINESHIFT;
-         p->velx = (M_Random() * finecosine[an]) >> 11;
-         p->vely = (M_Random() * finesine[an]) >> 11;
-         p->accx = p->velx >> 4;
-         p->accy = p->vely >> 4;
+         ParticleMotion.velx[n] = (M_Random() * finecosine[an]) >> 11;
+         ParticleMotion.vely[n] = (M_Random() * finesine[an]) >> 11;
+         ParticleMotion.accx[n] = ParticleMotion.velx[n] >> 4;
+         ParticleMotion.accy[n] = ParticleMotion.vely[n] >> 4;
       }
-      p->z = z + (M_Random() + zadd) * zspread;
+      ParticleMotion.z[n] = z + (M_Random() + zadd) * zspread;
       an = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 31) * finecosine[an];
-      p->y = y + (M_Random() & 31) * finesine[an];
+      ParticleMotion.x[n] = x + (M_Random() & 31) * finecosine[an];
+      ParticleMotion.y[n] = y + (M_Random() & 31) * finesine[an];
       P_SetParticlePosition(p);
    }
 }
@@ -1035,15 +1121,17 @@ void P_DisconnectEffect(Mobj *actor)
       
       if(!p)
          break;
+
+      const int n = P_ParticleNum(p);
       
-      p->x = actor->x + 
+      ParticleMotion.x[n] = actor->x + 
              ((M_Random()-128)<<9) * (actor->radius>>FRACBITS);
-      p->y = actor->y + 
+      ParticleMotion.y[n] = actor->y + 
              ((M_Random()-128)<<9) * (actor->radius>>FRACBITS);
-      p->z = actor->z + (M_Random()<<8) * (actor->height>>FRACBITS);
+      ParticleMotion.z[n] = actor->z + (M_Random()<<8) * (actor->height>>FRACBITS);
       P_SetParticlePosition(p);
 
-      p->accz -= FRACUNIT/4096;
+      ParticleMotion.accz[n] -= FRACUNIT/4096;
       p->color = M_Random() < 128 ? maroon1 : maroon2;
       p->size = 4;
       p->styleflags = PS_FULLBRIGHT;
@@ -1083,6 +1171,8 @@ static void P_FlyEffect(Mobj *actor)
       if(!(p = newParticle()))
          break;
 
+      const int n = P_ParticleNum(p);
+
       angle = ltime * avelocities[i][0];
       sy = (float)sin(angle);
       cy = (float)cos(angle);
@@ -1095,13 +1185,13 @@ static void P_FlyEffect(Mobj *actor)
       forward[2] = -sp;
 
       dist = (float)sin(ltime + i)*64;
-      p->x = actor->x + (int)((bytedirs[i][0]*dist + forward[0]*BEAMLENGTH)*FRACUNIT);
-      p->y = actor->y + (int)((bytedirs[i][1]*dist + forward[1]*BEAMLENGTH)*FRACUNIT);
-      p->z = actor->z + (int)((bytedirs[i][2]*dist + forward[2]*BEAMLENGTH)*FRACUNIT);
+      ParticleMotion.x[n] = actor->x + (int)((bytedirs[i][0]*dist + forward[0]*BEAMLENGTH)*FRACUNIT);
+      ParticleMotion.y[n] = actor->y + (int)((bytedirs[i][1]*dist + forward[1]*BEAMLENGTH)*FRACUNIT);
+      ParticleMotion.z[n] = actor->z + (int)((bytedirs[i][2]*dist + forward[2]*BEAMLENGTH)*FRACUNIT);
       P_SetParticlePosition(p);
 
-      p->velx = p->vely = p->velz = 0;
-      p->accx = p->accy = p->accz = 0;
+      ParticleMotion.velx[n] = ParticleMotion.vely[n] = ParticleMotion.velz[n] = 0;
+      ParticleMotion.accx[n] = ParticleMotion.accy[n] = ParticleMotion.accz[n] = 0;
 
       p->color = black;
 
@@ -1133,6 +1223,8 @@ static void P_BFGEffect(Mobj *actor)
       if(!(p = newParticle()))
          break;
 
+      const int n = P_ParticleNum(p);
+
       angle = ltime * avelocities[i][0];
       sy = (float)sin(angle);
       cy = (float)cos(angle);
@@ -1145,13 +1237,13 @@ static void P_BFGEffect(Mobj *actor)
       forward[2] = -sp;
       
       dist = (float)sin(ltime + i)*64;
-      p->x = actor->x + (int)((bytedirs[i][0]*dist + forward[0]*BEAMLENGTH)*FRACUNIT);
-      p->y = actor->y + (int)((bytedirs[i][1]*dist + forward[1]*BEAMLENGTH)*FRACUNIT);
-      p->z = actor->z + (15*FRACUNIT) + (int)((bytedirs[i][2]*dist + forward[2]*BEAMLENGTH)*FRACUNIT);
+      ParticleMotion.x[n] = actor->x + (int)((bytedirs[i][0]*dist + forward[0]*BEAMLENGTH)*FRACUNIT);
+      ParticleMotion.y[n] = actor->y + (int)((bytedirs[i][1]*dist + forward[1]*BEAMLENGTH)*FRACUNIT);
+      ParticleMotion.z[n] = actor->z + (15*FRACUNIT) + (int)((bytedirs[i][2]*dist + forward[2]*BEAMLENGTH)*FRACUNIT);
       P_SetParticlePosition(p);
 
-      p->velx = p->vely = p->velz = 0;
-      p->accx = p->accy = p->accz = 0;
+      ParticleMotion.velx[n] = ParticleMotion.vely[n] = ParticleMotion.velz[n] = 0;
+      ParticleMotion.accx[n] = ParticleMotion.accy[n] = ParticleMotion.accz[n] = 0;
 
       p->color = green;
 
@@ -1190,6 +1282,8 @@ static void P_DripEffect(Mobj *actor)
 
    if(!(p = newParticle()))
       return;
+
+   const int n = P_ParticleNum(p);
       
    p->ttl   = 18;
    p->trans = 9*FRACUNIT/16;
@@ -1198,16 +1292,16 @@ static void P_DripEffect(Mobj *actor)
    p->color = (byte)(actor->args[0]);
    p->size  = (byte)(actor->args[1]);
    
-   p->velz = 128 * -3000;
-   p->accz = -LevelInfo.gravity;
+   ParticleMotion.velz[n] = 128 * -3000;
+   ParticleMotion.accz[n] = -LevelInfo.gravity;
    p->styleflags = PS_FLOORCLIP | PS_FALLTOGROUND;
    if(makesplash)
       p->styleflags |= PS_SPLASH;
    if(fullbright)
       p->styleflags |= PS_FULLBRIGHT;
-   p->x = actor->x;
-   p->y = actor->y;
-   p->z = actor->subsector->sector->ceilingheight;
+   ParticleMotion.x[n] = actor->x;
+   ParticleMotion.y[n] = actor->y;
+   ParticleMotion.z[n] = actor->subsector->sector->ceilingheight;
    P_SetParticlePosition(p);
 }
 
@@ -1280,14 +1374,16 @@ static void P_ExplosionParticles(fixed_t x, fixed_t y, fixed_t z,
       if(!p)
          break;
 
+      const int n = P_ParticleNum(p);
+
       p->ttl = 26;
       p->fade = FADEFROMTTL(26);
       p->trans = FRACUNIT;
 
       // 2^11 = 2048, 2^12 = 4096
-      p->x = x + (((M_Random() % 32) - 16)*4096);
-      p->y = y + (((M_Random() % 32) - 16)*4096);
-      p->z = z + (((M_Random() % 32) - 16)*4096);
+      ParticleMotion.x[n] = x + (((M_Random() % 32) - 16)*4096);
+      ParticleMotion.y[n] = y + (((M_Random() % 32) - 16)*4096);
+      ParticleMotion.z[n] = z + (((M_Random() % 32) - 16)*4096);
       P_SetParticlePosition(p);
 
       // note: was (rand() % 384) - 192 in Q2, but DOOM's RNG
@@ -1295,13 +1391,13 @@ static void P_ExplosionParticles(fixed_t x, fixed_t y, fixed_t z,
       // corrected to unbias it and get output from approx.
       // -192 to 191
       rnd = M_Random();
-      p->velx = (rnd - 192 + (rnd/2))*2048;
+      ParticleMotion.velx[n] = (rnd - 192 + (rnd/2))*2048;
       rnd = M_Random();
-      p->vely = (rnd - 192 + (rnd/2))*2048;
+      ParticleMotion.vely[n] = (rnd - 192 + (rnd/2))*2048;
       rnd = M_Random();
-      p->velz = (rnd - 192 + (rnd/2))*2048;
+      ParticleMotion.velz[n] = (rnd - 192 + (rnd/2))*2048;
 
-      p->accx = p->accy = p->accz = 0;
+      ParticleMotion.accx[n] = ParticleMotion.accy[n] = ParticleMotion.accz[n] = 0;
 
       p->size = (M_Random() < 48) ? 6 : 4;
 
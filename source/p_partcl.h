@@ -48,9 +48,7 @@ struct particle_t
    DLListItem<particle_t> seclinks;         // sector links
    subsector_t *subsector;
 
-   fixed_t x, y, z;
-   fixed_t velx, vely, velz;
-   fixed_t accx, accy, accz;
+   // position, velocity and acceleration are kept in ParticleMotion
    unsigned int trans;
    unsigned int fade;
    byte	ttl;
@@ -65,6 +63,29 @@ extern int inactiveParticles;
 extern particle_t *Particles;
 extern int particle_trans;
 
+//
+// particlemotion_t
+//
+// Particle motion as parallel arrays indexed by particle number, so that
+// P_ParticleThinker can integrate every particle in one linear pass. Each
+// array holds count entries, the number of particles rounded up to a multiple
+// of four; unused entries are always zero.
+//
+struct particlemotion_t
+{
+   fixed_t *x, *y, *z;
+   fixed_t *velx, *vely, *velz;
+   fixed_t *accx, *accy, *accz;
+   int count;
+};
+
+extern particlemotion_t ParticleMotion;
+
+inline int P_ParticleNum(const particle_t *p)
+{
+   return int(p - Particles);
+}
+
 #define FX_ROCKET		0x00000001
 #define FX_GRENADE		0x00000002
 #define FX_FLIES                0x00000004
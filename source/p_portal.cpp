@@ -33,6 +33,7 @@
 #include "m_bbox.h"        // ioanch 20160107
 #include "m_collection.h"  // ioanch 20160106
 #include "p_chase.h"
+#include "p_enemy.h"
 #include "p_map.h"
 #include "p_maputl.h"   // ioanch
 #include "polyobj.h"
@@ -928,6 +929,9 @@ static int P_GetPortalState(const portal_t *portal, int sflags, bool obscured)
 void P_CheckCPortalState(sector_t *sec)
 {
    bool     obscured;
+
+   // heights or portal state changed; cached sight checks may no longer hold
+   P_SightSectorChanged(sec);
    
    if(!sec->c_portal)
    {
@@ -944,6 +948,9 @@ void P_CheckCPortalState(sector_t *sec)
 void P_CheckFPortalState(sector_t *sec)
 {
    bool     obscured;
+
+   // heights or portal state changed; cached sight checks may no longer hold
+   P_SightSectorChanged(sec);
    
    if(!sec->f_portal)
    {
@@ -959,6 +966,8 @@ void P_CheckFPortalState(sector_t *sec)
 
 void P_CheckLPortalState(line_t *line)
 {
+   P_SightWorldChanged();
+
    if(!line->portal)
    {
       line->pflags = 0;
@@ -982,6 +991,9 @@ void P_SetFloorHeight(sector_t *sec, fixed_t h)
 
    // check floor portal state
    P_CheckFPortalState(sec);
+
+   // lines may have opened or closed to sound
+   P_SoundSectorMoved(sec);
 }
 
 //
@@ -998,6 +1010,9 @@ void P_SetCeilingHeight(sector_t *sec, fixed_t h)
 
    // check ceiling portal state
    P_CheckCPortalState(sec);
+
+   // lines may have opened or closed to sound
+   P_SoundSectorMoved(sec);
 }
 
 void P_SetPortalBehavior(portal_t *portal, int newbehavior)
@@ -64,6 +64,7 @@
 #include "p_slopes.h"
 #include "p_spec.h"
 #include "p_tick.h"
+#include "p_valid.h"
 #include "polyobj.h"
 #include "r_data.h"
 #include "r_defs.h"
@@ -152,6 +153,7 @@ int       *blockmap;              // was short -- killough
 
 // offsets in blockmap are from here
 int       *blockmaplump;          // was short -- killough
+int        bmaplumpsize;
 
 fixed_t   bmaporgx, bmaporgy;     // origin of block map
 
@@ -2189,6 +2191,7 @@ static void P_CreateBlockMap()
          // Allocate blockmap lump with computed count
          blockmaplump = (int *)(Z_Malloc(sizeof(*blockmaplump) * count, 
                                          PU_LEVEL, 0));
+         bmaplumpsize = count;
       }
 
       // Now compress the blockmap.
@@ -2321,6 +2324,7 @@ void P_LoadBlockMap(int lump)
       int16_t *wadblockmaplump = (int16_t *)(setupwad->cacheLumpNum(lump, PU_LEVEL));
       blockmaplump = (int *)(Z_Malloc(sizeof(*blockmaplump) * count,
                                       PU_LEVEL, NULL));
+      bmaplumpsize = count;
 
       // killough 3/1/98: Expand wad blockmap into larger internal one,
       // by treating all offsets except -1 as unsigned and zero-extending
@@ -2359,6 +2363,7 @@ void P_LoadBlockMap(int lump)
    count      = sizeof(*blocklinks) * bmapwidth * bmapheight;
    blocklinks = ecalloctag(Mobj **, 1, count, PU_LEVEL, NULL);
    blockmap   = blockmaplump + 4;
+   P_InitBlockThings();
 
    // haleyjd 2/22/06: setup polyobject blockmap
    count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
@@ -3319,6 +3324,9 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    P_GroupLines();
    P_LoadReject(mgla.reject); // haleyjd 01/26/04
 
+   // nothing about the previous level's sight checks holds here
+   P_SightWorldChanged();
+
    // haleyjd 01/12/14: build sound environment zones
    P_CreateSoundZones();
 
@@ -3368,6 +3376,12 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    // SoM: Deferred specials that need to be spawned after P_SpawnSpecials
    P_SpawnDeferredSpecials();
 
+   // line boxes for the blockmap broadphase; polyobjects are known by now
+   P_InitLineBoxes();
+
+   // visited marks for queries that don't use validcount
+   ValidContext::SetupLevel();
+
    // haleyjd
    P_InitLightning();
 
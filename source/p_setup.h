@@ -79,6 +79,7 @@ extern byte     *rejectmatrix;   // for fast sight rejection
 // killough 3/1/98: change blockmap from "short" to "long" offsets:
 extern int     *blockmaplump;    // offsets in blockmap are from here
 extern int     *blockmap;
+extern int      bmaplumpsize;    // number of entries in blockmaplump
 extern int      bmapwidth;
 extern int      bmapheight;      // in mapblocks
 extern fixed_t  bmaporgx;
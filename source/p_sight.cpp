@@ -30,8 +30,11 @@
 #include "doomstat.h"
 #include "e_exdata.h"
 #include "m_bbox.h"
+#include "m_jobs.h"
+#include "p_map.h"
 #include "p_maputl.h"
 #include "p_setup.h"
+#include "p_valid.h"
 #include "r_dynseg.h"
 #include "r_main.h"
 #include "r_state.h"
@@ -48,6 +51,8 @@ typedef struct los_s
    divline_t strace;                // from t1 to t2
    fixed_t topslope, bottomslope;   // slopes to top and bottom of target
    fixed_t bbox[4];
+   ValidContext *valid;             // lines and polyobjects already checked
+   uint64_t *sectormask;            // if set, gets sectors whose heights matter
 } los_t;
 
 //
@@ -135,10 +140,8 @@ static bool P_CrossSubsecPolyObj(polyobj_t *po, los_t *los)
       const vertex_t *v1,*v2;
       
       // already checked other side?
-      if(line->validcount == validcount)
+      if(!los->valid->markLine(line))
          continue;
-
-      line->validcount = validcount;
       
       // OPTIMIZE: killough 4/20/98: Added quick bounding-box rejection test
       if(line->bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
@@ -198,9 +201,8 @@ static bool P_CrossSubsector(int num, los_t *los)
       {
          polyobj_t *po = (*link)->polyobj;
 
-         if(po->validcount != validcount)
+         if(los->valid->markPolyobj(po))
          {
-            po->validcount = validcount;
             if(!P_CrossSubsecPolyObj(po, los))
                return false;
          }
@@ -218,10 +220,8 @@ static bool P_CrossSubsector(int num, los_t *los)
       fixed_t frac;
       
       // already checked other side?
-      if(line->validcount == validcount)
+      if(!los->valid->markLine(line))
          continue;
-
-      line->validcount = validcount;
       
       // OPTIMIZE: killough 4/20/98: Added quick bounding-box rejection test
       // haleyjd: another demo compatibility fix by cph -- who knows
@@ -260,10 +260,15 @@ static bool P_CrossSubsector(int num, los_t *los)
       if(line->extflags & EX_ML_BLOCKALL)
          return false;
 
+      front = lseg->frontsector;
+      back  = lseg->backsector;
+
+      if(los->sectormask)
+         *los->sectormask |= P_SightSectorBit(front) | P_SightSectorBit(back);
+
       // crosses a two sided line
       // no wall to block sight with?
-      if((front = lseg->frontsector)->floorheight ==
-         (back = lseg->backsector)->floorheight   &&
+      if(front->floorheight == back->floorheight &&
          front->ceilingheight == back->ceilingheight)
          continue;
 
@@ -331,19 +336,23 @@ static bool P_CrossBSPNode(int bspnum, los_t *los)
 }
 
 //
-// P_CheckSight
+// P_checkSightTrace
 // Returns true
 //  if a straight line between t1 and t2 is unobstructed.
 // Uses REJECT.
 //
 // killough 4/20/98: cleaned up, made to use new LOS struct
 //
-bool P_CheckSight(Mobj *t1, Mobj *t2)
+// If sectormask is set, P_SightSectorBit of every sector whose heights the
+// result depends on is added to it.
+//
+static bool P_checkSightTrace(Mobj *t1, Mobj *t2, uint64_t *sectormask)
 {
    if(full_demo_version >= make_full_version(340, 24))
    {
       camsightparams_t camparams;
       camparams.prev = nullptr;
+      camparams.sectormask = sectormask;
       camparams.setLookerMobj(t1);
       camparams.setTargetMobj(t2);
       return CAM_CheckSight(camparams);
@@ -362,6 +371,15 @@ bool P_CheckSight(Mobj *t1, Mobj *t2)
    if(rejectmatrix[pnum>>3] & (1 << (pnum&7)))   // can't possibly be connected
       return false;
 
+   if(sectormask)
+   {
+      *sectormask |= P_SightSectorBit(s1) | P_SightSectorBit(s2);
+      if(s1->heightsec != -1)
+         *sectormask |= P_SightSectorBit(&sectors[s1->heightsec]);
+      if(s2->heightsec != -1)
+         *sectormask |= P_SightSectorBit(&sectors[s2->heightsec]);
+   }
+
    // killough 4/19/98: make fake floors and ceilings block monster view
    if((s1->heightsec != -1 &&
        ((t1->z + t1->height <= sectors[s1->heightsec].floorheight &&
@@ -389,7 +407,9 @@ bool P_CheckSight(Mobj *t1, Mobj *t2)
    // An unobstructed LOS is possible.
    // Now look from eyes of t1 to any part of t2.
    
-   validcount++;
+   los.valid = &P_ThreadValidContext();
+   los.valid->newQuery();
+   los.sectormask = sectormask;
 
    los.topslope = 
       (los.bottomslope = t2->z - (los.sightzstart =
@@ -412,6 +432,177 @@ bool P_CheckSight(Mobj *t1, Mobj *t2)
    return P_CrossBSPNode(numnodes-1, &los);
 }
 
+//
+// Sight Cache
+//
+// Monsters that haven't moved keep asking whether they can see targets that
+// haven't moved either. The answer depends only on where the two things are,
+// how tall they are, and the state of the level's geometry, so it is
+// remembered for the rest of the gametic.
+//
+// Each entry also keeps a mask of the sectors whose heights or portal states
+// the answer depended on, hashed to 64 bits. When a sector changes,
+// P_SightSectorChanged stamps its bit and only entries with that bit set are
+// forgotten. Anything else that can change whether a line blocks sight, such
+// as a polyobject moving, calls P_SightWorldChanged, which forgets everything.
+//
+
+#define SIGHTCACHE_SIZE 1024 // must be a power of two
+
+struct sightpoint_t
+{
+   fixed_t            x, y, z, height;
+   int                groupid;
+   const subsector_t *subsector;
+
+   void set(const Mobj *mo)
+   {
+      x         = mo->x;
+      y         = mo->y;
+      z         = mo->z;
+      height    = mo->height;
+      groupid   = mo->groupid;
+      subsector = mo->subsector;
+   }
+
+   bool operator == (const sightpoint_t &other) const
+   {
+      return x == other.x && y == other.y && z == other.z && 
+             height == other.height && groupid == other.groupid && 
+             subsector == other.subsector;
+   }
+};
+
+struct sightcache_t
+{
+   const Mobj   *t1;
+   const Mobj   *t2;
+   sightpoint_t  p1;
+   sightpoint_t  p2;
+   int           tic;
+   unsigned int  generation;
+   unsigned int  stamp;      // sightstamp when the entry was made
+   uint64_t      sectormask; // P_SightSectorBit of the sectors depended on
+   bool          result;
+};
+
+static sightcache_t sightcache[SIGHTCACHE_SIZE];
+static unsigned int sightgeneration = 1; // entries from older ones are stale
+
+// sector changes: a stamp per bit of the sector mask, and the bits that have
+// changed during sightchangedtic
+static unsigned int sightstamp;
+static unsigned int sightsectorstamps[64];
+static uint64_t     sightchanged;
+static int          sightchangedtic = -1;
+
+//
+// P_SightWorldChanged
+//
+// Called when line portal states, polyobject positions, or line flags that
+// block sight change, and when a level is set up.
+//
+void P_SightWorldChanged()
+{
+   // on wraparound, make sure no entry looks current
+   if(++sightgeneration == 0)
+   {
+      memset(sightcache, 0, sizeof(sightcache));
+      sightgeneration = 1;
+   }
+}
+
+//
+// P_SightSectorChanged
+//
+// Called when a sector's heights or portal states change. Forgets only the
+// sight checks that looked at the sector, or at another sharing its bit.
+//
+void P_SightSectorChanged(const sector_t *sec)
+{
+   uint64_t bit = P_SightSectorBit(sec);
+
+   // stamps only ever grow; on wraparound, start over
+   if(++sightstamp == 0)
+   {
+      P_SightWorldChanged();
+      memset(sightsectorstamps, 0, sizeof(sightsectorstamps));
+      sightstamp = 1;
+   }
+
+   if(sightchangedtic != gametic)
+   {
+      sightchanged    = 0;
+      sightchangedtic = gametic;
+   }
+   sightchanged |= bit;
+
+   sightsectorstamps[(sec - sectors) & 63] = sightstamp;
+}
+
+//
+// P_sightEntryCurrent
+//
+// Returns true if none of the sectors a cache entry depends on has changed
+// since it was made. Entries only live for one gametic, so only bits changed
+// during this one need their stamps checked.
+//
+static bool P_sightEntryCurrent(const sightcache_t &sc)
+{
+   if(sightchangedtic != gametic)
+      return true;
+
+   uint64_t check = sc.sectormask & sightchanged;
+
+   for(int i = 0; check; i++, check >>= 1)
+   {
+      if((check & 1) && sightsectorstamps[i] > sc.stamp)
+         return false;
+   }
+
+   return true;
+}
+
+//
+// P_CheckSight
+//
+// Returns true if a straight line between t1 and t2 is unobstructed. The
+// result is the same as tracing it again every time.
+//
+// Job workers may only use this where the BSP trace applies: CAM_CheckSight,
+// used from version 3.40.24 on, allocates from the zone heap.
+//
+bool P_CheckSight(Mobj *t1, Mobj *t2)
+{
+   // the cache belongs to the main thread
+   if(M_JobWorkerIndex() >= 0)
+      return P_checkSightTrace(t1, t2, NULL);
+
+   uintptr_t     hash = (uintptr_t)t1 * 31 + (uintptr_t)t2;
+   sightcache_t &sc   = sightcache[(hash >> 4) & (SIGHTCACHE_SIZE - 1)];
+   sightpoint_t  p1, p2;
+
+   p1.set(t1);
+   p2.set(t2);
+
+   if(sc.generation == sightgeneration && sc.tic == gametic && 
+      sc.t1 == t1 && sc.t2 == t2 && sc.p1 == p1 && sc.p2 == p2 &&
+      P_sightEntryCurrent(sc))
+      return sc.result;
+
+   sc.t1         = t1;
+   sc.t2         = t2;
+   sc.p1         = p1;
+   sc.p2         = p2;
+   sc.tic        = gametic;
+   sc.generation = sightgeneration;
+   sc.stamp      = sightstamp;
+   sc.sectormask = 0;
+   sc.result     = P_checkSightTrace(t1, t2, &sc.sectormask);
+
+   return sc.result;
+}
+
 //----------------------------------------------------------------------------
 //
 // $Log: p_sight.c,v $
@@ -421,7 +421,7 @@ int EV_HealThing(Mobj *actor, int amount, int maxhealth)
       = E_ItemEffectForName(ITEMNAME_SOULSPHERE);
 
       if(soulsphereeffect)
-         maxhealth = soulsphereeffect->getInt("maxamount", 0);
+         maxhealth = soulsphereeffect->maxamount;
       else
       {
          // FIXME: Handle this with a bit more finesse.
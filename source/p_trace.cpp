@@ -38,6 +38,7 @@
 #include "p_setup.h"
 #include "p_skin.h"
 #include "p_spec.h"
+#include "p_valid.h"
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_sky.h"
@@ -865,7 +866,7 @@ bool P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
    int     mapxstep, mapystep;
    int     count;
 
-   validcount++;
+   ValidContext::Global().newQuery();
    intercept_p = intercepts;
    
    if(!((x1-bmaporgx)&(MAPBLOCKSIZE-1)))
@@ -0,0 +1,207 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Visited marks for map queries.
+//
+//   Contexts other than the global one stamp lines and polyobjects in arrays
+//   of their own, sized for the current level. There is one for each job
+//   worker, made ahead of time so that workers can run BSP sight traces side
+//   by side without allocating. The pool that reentrant traversals take from
+//   instead of clearing visited sets every time is for the main thread only.
+//
+//-----------------------------------------------------------------------------
+
+#include "z_zone.h"
+
+#include "i_system.h"
+#include "m_compare.h"
+#include "m_jobs.h"
+#include "p_valid.h"
+
+ValidContext  ValidContext::global(true);
+ValidContext *ValidContext::contexts;
+ValidContext *ValidContext::freecontexts;
+
+static ValidContext *workercontexts; // one per job worker
+static int           numworkercontexts;
+
+//
+// ValidContext::ValidContext
+//
+ValidContext::ValidContext()
+   : count(0), linestamps(NULL), polystamps(NULL), 
+     numlinestamps(0), numpolystamps(0), isglobal(false), nextfree(NULL)
+{
+   next = contexts;
+   contexts = this;
+   setup();
+}
+
+//
+// ValidContext::ValidContext
+//
+// For the global context, which uses the map's own validcount fields.
+//
+ValidContext::ValidContext(bool inglobal)
+   : count(0), linestamps(NULL), polystamps(NULL), 
+     numlinestamps(0), numpolystamps(0), isglobal(inglobal), next(NULL),
+     nextfree(NULL)
+{
+}
+
+//
+// ValidContext::setup
+//
+// Sizes the stamps for the current level and clears them. The arrays are
+// never left NULL, as that would make the context act as the global one.
+//
+void ValidContext::setup()
+{
+   if(isglobal)
+      return;
+
+   if(numlinestamps != numlines || !linestamps)
+   {
+      if(linestamps)
+         efree(linestamps);
+      numlinestamps = numlines;
+      linestamps = ecalloc(int *, emax(numlines, 1), sizeof(int));
+   }
+   else
+      memset(linestamps, 0, numlinestamps * sizeof(int));
+
+   if(numpolystamps != numPolyObjects || !polystamps)
+   {
+      if(polystamps)
+         efree(polystamps);
+      numpolystamps = numPolyObjects;
+      polystamps = ecalloc(int *, emax(numPolyObjects, 1), sizeof(int));
+   }
+   else
+      memset(polystamps, 0, numpolystamps * sizeof(int));
+
+   count = 0;
+}
+
+//
+// ValidContext::newQuery
+//
+// Starts a new query, forgetting all marks. For the global context this is
+// the same as validcount++.
+//
+void ValidContext::newQuery()
+{
+   if(isglobal)
+   {
+      ++validcount;
+      return;
+   }
+
+   if(count == D_MAXINT)
+   {
+      memset(linestamps, 0, numlinestamps * sizeof(int));
+      memset(polystamps, 0, numpolystamps * sizeof(int));
+      count = 0;
+   }
+   ++count;
+}
+
+//
+// ValidContext::SetupLevel
+//
+// Called once a level's lines and polyobjects exist. Makes the worker
+// contexts the first time.
+//
+void ValidContext::SetupLevel()
+{
+   if(!workercontexts && M_NumJobWorkers() > 0)
+   {
+      numworkercontexts = M_NumJobWorkers();
+      workercontexts = new ValidContext [numworkercontexts];
+   }
+
+   for(ValidContext *vc = contexts; vc; vc = vc->next)
+      vc->setup();
+}
+
+//
+// ValidContext::Acquire
+//
+// Takes a context from the pool, or makes one. Give it back with Release.
+// Neither the pool nor the zone heap may be used by job workers.
+//
+ValidContext *ValidContext::Acquire()
+{
+   ValidContext *vc;
+
+   if(M_JobWorkerIndex() >= 0)
+      I_Error("ValidContext::Acquire: called from a job worker\n");
+
+   if((vc = freecontexts))
+   {
+      freecontexts = vc->nextfree;
+
+      // polyobjects are spawned after the lines are loaded
+      if(vc->numlinestamps != numlines || vc->numpolystamps != numPolyObjects)
+         vc->setup();
+   }
+   else
+      vc = new ValidContext;
+
+   vc->newQuery();
+   return vc;
+}
+
+//
+// ValidContext::Release
+//
+void ValidContext::Release(ValidContext *vc)
+{
+   if(M_JobWorkerIndex() >= 0)
+      I_Error("ValidContext::Release: called from a job worker\n");
+
+   vc->nextfree = freecontexts;
+   freecontexts = vc;
+}
+
+//
+// P_ThreadValidContext
+//
+// The main thread gets the global context, so existing code sees validcount
+// behave as it always has. Job workers get their own, which exist once a
+// level has been set up; a worker must never fall back on validcount.
+//
+ValidContext &P_ThreadValidContext()
+{
+   int index = M_JobWorkerIndex();
+
+   if(index < 0)
+      return ValidContext::Global();
+
+   if(index >= numworkercontexts)
+      I_Error("P_ThreadValidContext: no context for job worker %d\n", index);
+
+   return workercontexts[index];
+}
+
+// EOF
+
@@ -0,0 +1,114 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//
+//   Visited marks for map queries. The global context is the classic
+//   validcount stamped into lines and polyobjects; other contexts keep
+//   their own stamps, so that queries using them don't disturb each other.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef P_VALID_H__
+#define P_VALID_H__
+
+#include "polyobj.h"
+#include "r_defs.h"
+#include "r_main.h"
+#include "r_state.h"
+
+//
+// ValidContext
+//
+// Call newQuery before a query, then markLine and markPolyobj as it goes.
+// A context serves one query at a time.
+//
+class ValidContext
+{
+public:
+   ValidContext();
+
+   void newQuery();
+
+   //
+   // Marks a line as checked by the current query. Returns false if it
+   // already was.
+   //
+   bool markLine(line_t *line)
+   {
+      int &stamp = linestamps ? linestamps[line - lines] : line->validcount;
+      int  cur   = linestamps ? count : validcount;
+
+      if(stamp == cur)
+         return false;
+      stamp = cur;
+      return true;
+   }
+
+   bool lineMarked(const line_t *line) const
+   {
+      return linestamps ? linestamps[line - lines] == count :
+                          line->validcount == validcount;
+   }
+
+   bool markPolyobj(polyobj_t *po)
+   {
+      int &stamp = polystamps ? polystamps[po - PolyObjects] : po->validcount;
+      int  cur   = polystamps ? count : validcount;
+
+      if(stamp == cur)
+         return false;
+      stamp = cur;
+      return true;
+   }
+
+   static ValidContext &Global() { return global; }
+
+   // Main thread only
+   static void          SetupLevel();
+   static ValidContext *Acquire();
+   static void          Release(ValidContext *vc);
+
+private:
+   explicit ValidContext(bool isglobal);
+   void setup();
+
+   int  count;
+   int *linestamps;     // NULL for the global context
+   int *polystamps;
+   int  numlinestamps;
+   int  numpolystamps;
+   bool isglobal;
+
+   ValidContext *next;      // all contexts
+   ValidContext *nextfree;  // pool of contexts for Acquire
+
+   static ValidContext  global;
+   static ValidContext *contexts;
+   static ValidContext *freecontexts;
+};
+
+// The context for queries made on the calling thread
+ValidContext &P_ThreadValidContext();
+
+#endif
+
+// EOF
+
@@ -929,6 +929,9 @@ static bool Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y, bool onload = fa
    // ioanch 20160226: update portal position
    Polyobj_movePortals(po, x, y, false);
 
+   // cached sight checks may no longer hold
+   P_SightWorldChanged();
+
    // translate vertices
    for(i = 0; i < po->numVertices; ++i)
       Polyobj_vecAdd(po->vertices[i], &vec);
@@ -1067,6 +1070,9 @@ static bool Polyobj_rotate(polyobj_t *po, angle_t delta, bool onload = false)
 
    angle = (po->angle + delta) >> ANGLETOFINESHIFT;
 
+   // cached sight checks may no longer hold
+   P_SightWorldChanged();
+
    // point about which to rotate is the spawn spot
    origin.x = po->spawnSpot.x;
    origin.y = po->spawnSpot.y;
@@ -648,7 +648,13 @@ sector_t *R_FakeFlat(sector_t *sec, sector_t *tempsec,
             tempsec->c_pflags = 0;
          }
          else
-            P_SetCeilingHeight(tempsec, R_CPLink(sec)->planez);
+         {
+            // Assign directly: tempsec is a render-only copy, and going through
+            // P_SetCeilingHeight would invalidate sound and sight data every 
+            // frame. Its portal flags were copied from a non-obscured sector.
+            tempsec->ceilingheight  = R_CPLink(sec)->planez;
+            tempsec->ceilingheightf = M_FixedToFloat(tempsec->ceilingheight);
+         }
          sec = tempsec;
       }
       else if(!(sec->c_pflags & PS_VISIBLE))
@@ -668,7 +674,11 @@ sector_t *R_FakeFlat(sector_t *sec, sector_t *tempsec,
             tempsec->f_pflags = 0;
          }
          else
-            P_SetFloorHeight(tempsec, R_FPLink(sec)->planez);
+         {
+            // see above
+            tempsec->floorheight  = R_FPLink(sec)->planez;
+            tempsec->floorheightf = M_FixedToFloat(tempsec->floorheight);
+         }
             
          sec = tempsec;
       }
@@ -34,6 +34,7 @@
 #include "doomstat.h"
 #include "e_hash.h"
 #include "m_compare.h"
+#include "m_jobs.h"
 #include "m_misc.h"
 #include "m_swap.h"
 #include "p_info.h"   // haleyjd
@@ -215,6 +216,62 @@ int tran_filter_pct = 66;       // filter percent
 
 #define TSC 12        /* number of fixed point digits in filter percent */
 
+//
+// R_tranMapRows
+//
+// Job function computing rows [start, stop) of a translucency map.
+//
+struct tranmapbuild_t
+{
+   byte *map;
+   int (*pal)[256];
+   int  *tot;
+   int (*palw)[256]; // palette scaled by the first weight; NULL for SUBMAP
+   int   w2;
+};
+
+static void R_tranMapRows(int start, int stop, void *data)
+{
+   const tranmapbuild_t *build = static_cast<tranmapbuild_t *>(data);
+   int (*pal)[256] = build->pal;
+   const int *tot  = build->tot;
+
+   for(int i = start; i < stop; i++)
+   {
+      byte *tp = build->map + i * 256;
+
+      for(int j = 0; j < 256; j++, tp++)
+      {
+         int color = 255;
+         int err;
+         int r, g, b;
+         int best = INT_MAX;
+
+         if(build->palw)
+         {
+            r = build->palw[0][j] + pal[0][i] * build->w2;
+            g = build->palw[1][j] + pal[1][i] * build->w2;
+            b = build->palw[2][j] + pal[2][i] * build->w2;
+         }
+         else
+         {
+            // haleyjd: subtract and clamp to 0
+            r = emax(pal[0][i] - pal[0][j], 0);
+            g = emax(pal[1][i] - pal[1][j], 0);
+            b = emax(pal[2][i] - pal[2][j], 0);
+         }
+
+         do
+         {
+            if((err = tot[color] - pal[0][color]*r
+               - pal[1][color]*g - pal[2][color]*b) < best)
+               best = err, *tp = color;
+         }
+         while(--color >= 0);
+      }
+   }
+}
+
 //
 // R_InitTranMap
 //
@@ -305,33 +362,22 @@ void R_InitTranMap(bool force)
          while (--i >= 0);
       }
 
-      // Next, compute all entries using minimum arithmetic.
-      byte *tp = main_tranmap;
-      for(int i = 0; i < 256; ++i)
-      {
-         int r1 = pal[0][i] * w2;
-         int g1 = pal[1][i] * w2;
-         int b1 = pal[2][i] * w2;
+      // Next, compute all entries using minimum arithmetic, spread over the
+      // job threads one row at a time.
+      tranmapbuild_t build;
 
-         if(!(i & 31) && force)
-            V_LoadingIncrease();        //sf 
+      build.map  = main_tranmap;
+      build.pal  = pal;
+      build.tot  = tot;
+      build.palw = pal_w1;
+      build.w2   = w2;
 
-         for(int j = 0; j < 256; j++, tp++)
-         {
-            int color = 255;
-            int err;
-            int r = pal_w1[0][j] + r1;
-            int g = pal_w1[1][j] + g1;
-            int b = pal_w1[2][j] + b1;
-            int best = INT_MAX;
-            do
-            {
-               if((err = tot[color] - pal[0][color]*r
-                  - pal[1][color]*g - pal[2][color]*b) < best)
-                  best = err, *tp = color;
-            }
-            while(--color >= 0);
-         }
+      M_ParallelFor("R_InitTranMap", 256, 8, R_tranMapRows, &build);
+
+      if(force)
+      {
+         for(int i = 0; i < 256; i += 32)
+            V_LoadingIncrease();        //sf 
       }
    }
 }
@@ -417,31 +463,15 @@ void R_InitSubMap(bool force)
       }
 
       // Next, compute all entries using minimum arithmetic.
-      byte *tp = main_submap;
-      for(int i = 0; i < 256; i++)
-      {
-         int r1 = pal[0][i];
-         int g1 = pal[1][i];
-         int b1 = pal[2][i];
+      tranmapbuild_t build;
 
-         for(int j = 0; j < 256; j++, tp++)
-         {
-            int color = 255;
-            int err;
-            // haleyjd: subtract and clamp to 0
-            int r = emax(r1 - pal[0][j], 0);
-            int g = emax(g1 - pal[1][j], 0);
-            int b = emax(b1 - pal[2][j], 0);
-            int best = INT_MAX;
-            do
-            {
-               if((err = tot[color] - pal[0][color]*r
-                  - pal[1][color]*g - pal[2][color]*b) < best)
-                  best = err, *tp = color;
-            }
-            while(--color >= 0);
-         }
-      }
+      build.map  = main_submap;
+      build.pal  = pal;
+      build.tot  = tot;
+      build.palw = NULL;
+      build.w2   = 0;
+
+      M_ParallelFor("R_InitSubMap", 256, 8, R_tranMapRows, &build);
    }
 }
 
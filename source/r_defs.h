@@ -39,6 +39,7 @@ struct line_t;
 struct particle_t;
 struct planehash_t;
 struct portal_t;
+struct rvoxelmodel_t;
 struct sector_t;
 struct ereverb_t;
 struct ETerrain;
@@ -217,6 +218,10 @@ struct soundzone_t
 //
 struct sector_t
 {
+   // Fields used most often by the playsim (movement clipping, height
+   // changes, line openings) come first so that they share cache lines;
+   // renderer-only and rarely used data follows.
+
    fixed_t floorheight;
    fixed_t ceilingheight;
    int     floorpic;
@@ -225,27 +230,61 @@ struct sector_t
    int16_t special;
    int16_t tag;
    int16_t leakiness;       // ioanch (UDMF): probability / 256 that the suit will leak
-   int nexttag, firsttag;   // killough 1/30/98: improves searches for tags.
-   int soundtraversed;      // 0 = untraversed, 1,2 = sndlines-1
-   Mobj *soundtarget;       // thing that made a sound (or null)
-   fixed_t blockbox[4];     // mapblock bounding box for height changes
-   PointThinker soundorg;   // origin for any sounds played by the sector
-   PointThinker csoundorg;  // haleyjd 10/16/06: separate sound origin for ceiling
    int validcount;          // if == validcount, already checked
+
+   // haleyjd 12/28/08: sector flags, for ED/UDMF use. Replaces stupid BOOM
+   // generalized sector types outside of DOOM-format maps.
+   unsigned int flags;
+   unsigned int intflags; // internal flags
+
+   // Flags for portals
+   unsigned int c_pflags, f_pflags;
+
+   int groupid;
+
+   // killough 3/7/98: support flat heights drawn at another sector's heights
+   int heightsec;    // other sector, or -1 if no other sector
+
    Mobj *thinglist;         // list of mobjs in sector
-   // ioanch 20160109: keep references to portal interfacing things
-   DLListItem<spriteprojnode_t> *spriteproj; // bipartite of sector/mobj sprite proj
 
-   // killough 8/28/98: friction is a sector property, not an mobj property.
-   // these fields used to be in Mobj, but presented performance problems
-   // when processed as mobj properties. Fix is to make them sector properties.
-   int friction, movefactor;
+   // list of mobjs that are at least partially in the sector
+   // thinglist is a subset of touching_thinglist
+   msecnode_t *touching_thinglist;               // phares 3/14/98  
 
    // thinker_t for reversable actions
    Thinker *floordata;    // jff 2/22/98 make thinkers on
    Thinker *ceilingdata;  // floors, ceilings, lighting,
    Thinker *lightingdata; // independent of one another
 
+   // Portals
+   portal_t *c_portal;
+   portal_t *f_portal;
+
+   // SoM 5/10/09: Happy birthday to me. Err, Slopes!
+   pslope_t *f_slope;
+   pslope_t *c_slope;
+
+   // killough 8/28/98: friction is a sector property, not an mobj property.
+   // these fields used to be in Mobj, but presented performance problems
+   // when processed as mobj properties. Fix is to make them sector properties.
+   int friction, movefactor;
+
+   int soundtraversed;      // 0 = untraversed, 1,2 = sndlines-1
+   Mobj *soundtarget;       // thing that made a sound (or null)
+
+   fixed_t blockbox[4];     // mapblock bounding box for height changes
+
+   int linecount;
+   line_t **lines;
+
+   // End of frequently used fields.
+
+   int nexttag, firsttag;   // killough 1/30/98: improves searches for tags.
+   PointThinker soundorg;   // origin for any sounds played by the sector
+   PointThinker csoundorg;  // haleyjd 10/16/06: separate sound origin for ceiling
+   // ioanch 20160109: keep references to portal interfacing things
+   DLListItem<spriteprojnode_t> *spriteproj; // bipartite of sector/mobj sprite proj
+
    // jff 2/26/98 lockout machinery for stairbuilding
    int stairlock;   // -2 on first locked -1 after thinker done 0 normally
    int prevsec;     // -1 or number of sector for previous step
@@ -255,9 +294,6 @@ struct sector_t
    fixed_t   floor_xoffs,   floor_yoffs;
    fixed_t ceiling_xoffs, ceiling_yoffs;
 
-   // killough 3/7/98: support flat heights drawn at another sector's heights
-   int heightsec;    // other sector, or -1 if no other sector
-   
    // killough 4/11/98: support for lightlevels coming from another sector
    int floorlightsec, ceilinglightsec;
    // ioanch: UDMF-given floor and ceiling delta light level
@@ -273,13 +309,6 @@ struct sector_t
    // and which isn't, etc.
    
    int sky;
-   
-   // list of mobjs that are at least partially in the sector
-   // thinglist is a subset of touching_thinglist
-   msecnode_t *touching_thinglist;               // phares 3/14/98  
-   
-   int linecount;
-   line_t **lines;
 
    // SoM 9/19/02: Better way to move 3dsides with a sector.
    // SoM 11/09/04: Improved yet again!
@@ -301,15 +330,6 @@ struct sector_t
    int f_asurfacecount;
    attachedsurface_t *f_asurfaces;
 
-   // Flags for portals
-   unsigned int c_pflags, f_pflags;
-   
-   // Portals
-   portal_t *c_portal;
-   portal_t *f_portal;
-   
-   int groupid;
-
    // haleyjd 03/12/03: Heretic wind specials
    int     hticPushType;
    angle_t hticPushAngle;
@@ -330,21 +350,12 @@ struct sector_t
    float ceilingheightf;
    float floorheightf;
 
-   // haleyjd 12/28/08: sector flags, for ED/UDMF use. Replaces stupid BOOM
-   // generalized sector types outside of DOOM-format maps.
-   unsigned int flags;
-   unsigned int intflags; // internal flags
-   
    // haleyjd 12/31/08: sector damage properties
    int damage;      // if > 0, sector is damaging
    int damagemask;  // damage is done when !(leveltime % mask)
    int damagemod;   // damage method to use
    unsigned int damageflags; // special damage behaviors
 
-   // SoM 5/10/09: Happy birthday to me. Err, Slopes!
-   pslope_t *f_slope;
-   pslope_t *c_slope;
-
    // haleyjd 08/30/09 - used by the lightning code
    int16_t oldlightlevel; 
 
@@ -393,34 +404,39 @@ struct seg_t;
 
 struct line_t
 {
+   // Fields used by movement clipping and blockmap iteration come first.
+   int validcount;         // if == validcount, already checked
+   fixed_t bbox[4];        // A bounding box, for the linedef's extent
    vertex_t *v1, *v2;      // Vertices, from v1 to v2.
    fixed_t  dx, dy;        // Precalculated v2 - v1 for side checking.
+   slopetype_t slopetype;  // To aid move clipping.
    int16_t  flags;         // Animation related.
    int      special;         
+   sector_t *frontsector;  // Front and back sector.
+   sector_t *backsector; 
+   int intflags;           // haleyjd 01/22/11: internal flags
+
+   // SoM 12/10/03: wall portals
+   int      pflags;
+   portal_t *portal;
+
+   // haleyjd 02/26/05: ExtraData fields
+   unsigned int extflags;   // activation flags for param specials
+
+   // End of frequently used fields.
+
    int      tag;           // haleyjd 02/27/07: line id's
 
    // haleyjd 06/19/06: extended from short to long for 65535 sidedefs
    int      sidenum[2];    // Visual appearance: SideDefs.
 
-   fixed_t bbox[4];        // A bounding box, for the linedef's extent
-   slopetype_t slopetype;  // To aid move clipping.
-   sector_t *frontsector;  // Front and back sector.
-   sector_t *backsector; 
-   int validcount;         // if == validcount, already checked
    int tranlump;           // killough 4/11/98: translucency filter, -1 == none
    int firsttag, nexttag;  // killough 4/17/98: improves searches for tags.
    PointThinker soundorg;  // haleyjd 04/19/09: line sound origin
-   int intflags;           // haleyjd 01/22/11: internal flags
-
-   // SoM 12/10/03: wall portals
-   int      pflags;
-   portal_t *portal;
 
    // SoM 05/11/09: Pre-calculated 2D normal for the line
    float nx, ny;
 
-   // haleyjd 02/26/05: ExtraData fields
-   unsigned int extflags;   // activation flags for param specials
    int   args[NUMLINEARGS]; // argument values for param specials
    float alpha;             // alpha
 
@@ -555,6 +571,8 @@ struct spriteframe_t
   // Flip bit (1 = flip) to use for view angles 0-7.
   byte  flip[8];
 
+  // Voxel model drawn instead of the patches, if any.
+  rvoxelmodel_t *voxel;
 };
 
 //
@@ -601,13 +619,11 @@ struct visplane_t
    fixed_t xoffs, yoffs;         // killough 2/28/98: Support scrolling flats
 
    // SoM: The plane silhouette arrays are allocated based on screen-size now.
-   int *top;
-   int *bottom;
-
-   // This is the width of the above silhouette buffers. If a video mode is set
-   // that is wider than max_width, the visplane's buffers need to be
-   // reallocated to use the wider screen res.
-   unsigned int   max_width;
+   // They are taken from a per-frame arena and only cover the columns from
+   // clipminx to clipmaxx (plus one padding column at each end).
+   int16_t *top;
+   int16_t *bottom;
+   int      clipminx, clipmaxx;
 
    fixed_t viewx, viewy, viewz;
 
@@ -42,6 +42,7 @@
 #include "i_video.h"
 #include "m_bbox.h"
 #include "m_random.h"
+#include "m_vidcap.h"
 #include "mn_engin.h"
 #include "p_chase.h"
 #include "p_partcl.h"
@@ -757,20 +758,33 @@ void R_IncrementFrameid()
 //
 static void R_interpolateViewPoint(player_t *player, fixed_t lerp)
 {
+   angle_t pending = 0, lastmouse = 0;
+   bool    live;
+
+   // mouse turning not yet run by the game is shown right away; see
+   // G_LocalViewTurn
+   live = (player == &players[consoleplayer] && 
+           G_LocalViewTurn(pending, lastmouse));
+
    if(lerp == FRACUNIT)
    {
       viewx     = player->mo->x;
       viewy     = player->mo->y;
       viewz     = player->viewz;
-      viewangle = player->mo->angle; //+ viewangleoffset;
+      viewangle = player->mo->angle + pending; //+ viewangleoffset;
       viewpitch = player->pitch;
    }
    else
    {
+      angle_t prevangle = player->mo->prevpos.angle;
+
+      if(live)
+         prevangle += lastmouse;
+
       viewx     = lerpCoord(lerp, player->mo->prevpos.x,     player->mo->x);
       viewy     = lerpCoord(lerp, player->mo->prevpos.y,     player->mo->y);
       viewz     = lerpCoord(lerp, player->prevviewz,         player->viewz);
-      viewangle = lerpAngle(lerp, player->mo->prevpos.angle, player->mo->angle);
+      viewangle = lerpAngle(lerp, prevangle, player->mo->angle) + pending;
       viewpitch = lerpAngle(lerp, player->prevpitch,         player->pitch);
    }
 }
@@ -868,7 +882,8 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
 //
 static fixed_t R_getLerp()
 {
-   if(d_fastrefresh && d_interpolate &&
+   // -renderdemo always interpolates, since its frames fall between tics
+   if((vidcapactive || (d_fastrefresh && d_interpolate)) &&
       !(paused || ((menuactive || consoleactive) && !demoplayback && !netgame)))
       return i_haltimer.GetFrac();
    else
@@ -43,6 +43,7 @@
 #include "d_gi.h"
 #include "doomstat.h"
 #include "ev_specials.h"
+#include "m_compare.h"
 #include "p_anim.h"
 #include "p_info.h"
 #include "p_slopes.h"
@@ -141,6 +142,133 @@ VALLOCATION(spanstart)
    spanstart = ecalloctag(int *, h, sizeof(int), PU_VALLOC, NULL);
 }
 
+// Value of an unused column in a visplane's top silhouette array
+#define PL_UNSETTOP 0x7FFF
+
+//
+// Visplane silhouette arena
+//
+// Silhouette arrays are only needed for the duration of a frame, so they are
+// carved out of a list of blocks which is rewound by R_ClearPlanes.
+//
+struct planeclipblock_t
+{
+   planeclipblock_t *next;
+   size_t   size;  // number of int16_t in data
+   int16_t *data;
+};
+
+static planeclipblock_t *planeclipblocks; // head of block list
+static planeclipblock_t *planeclipcur;    // block currently being allocated from
+static size_t            planeclipused;   // amount of planeclipcur in use
+
+#define PLANECLIPBLOCKSIZE 65536
+
+VALLOCATION(planeclipblocks)
+{
+   // blocks were PU_VALLOC and have been freed
+   planeclipblocks = planeclipcur = NULL;
+   planeclipused = 0;
+}
+
+//
+// R_planeClipAlloc
+//
+// Returns space for count int16_t values from the silhouette arena.
+//
+static int16_t *R_planeClipAlloc(size_t count)
+{
+   while(!planeclipcur || planeclipused + count > planeclipcur->size)
+   {
+      if(planeclipcur && planeclipcur->next)
+         planeclipcur = planeclipcur->next;
+      else
+      {
+         size_t size = emax<size_t>(PLANECLIPBLOCKSIZE, count);
+         planeclipblock_t *block = 
+            emalloctag(planeclipblock_t *, sizeof(planeclipblock_t) + 
+                       size * sizeof(int16_t), PU_VALLOC, NULL);
+
+         block->next = NULL;
+         block->size = size;
+         block->data = reinterpret_cast<int16_t *>(block + 1);
+
+         if(planeclipcur)
+            planeclipcur->next = block;
+         else
+            planeclipblocks = block;
+         planeclipcur = block;
+      }
+      planeclipused = 0;
+   }
+
+   int16_t *ret = planeclipcur->data + planeclipused;
+   planeclipused += count;
+   return ret;
+}
+
+//
+// R_unsetPlaneColumns
+//
+static void R_unsetPlaneColumns(visplane_t *pl, int x1, int x2)
+{
+   for(int x = x1; x <= x2; x++)
+   {
+      pl->top[x]    = PL_UNSETTOP;
+      pl->bottom[x] = 0;
+   }
+}
+
+//
+// R_growPlaneClips
+//
+// Extends the visplane's [minx, maxx] range to include x1 through x2, making
+// sure its silhouette arrays cover those columns and that the newly included
+// columns are marked as unused.
+//
+static void R_growPlaneClips(visplane_t *pl, int x1, int x2)
+{
+   bool empty  = (pl->minx > pl->maxx);
+   int newminx = empty ? x1 : emin(x1, pl->minx);
+   int newmaxx = empty ? x2 : emax(x2, pl->maxx);
+
+   if(!pl->top || newminx < pl->clipminx || newmaxx > pl->clipmaxx)
+   {
+      // leave room for the plane to grow by half again before reallocating
+      int slack = (newmaxx - newminx + 1) / 2;
+      int lo    = emax(newminx - slack, 0);
+      int hi    = emin(newmaxx + slack, video.width - 1);
+      int len   = hi - lo + 3; // one padding column at each end
+
+      int16_t *buffer = R_planeClipAlloc(2 * len);
+      int16_t *top    = buffer + 1 - lo;
+      int16_t *bottom = buffer + len + 1 - lo;
+
+      if(!empty)
+      {
+         size_t count = pl->maxx - pl->minx + 1;
+         memcpy(top    + pl->minx, pl->top    + pl->minx, count * sizeof(int16_t));
+         memcpy(bottom + pl->minx, pl->bottom + pl->minx, count * sizeof(int16_t));
+      }
+
+      pl->top      = top;
+      pl->bottom   = bottom;
+      pl->clipminx = lo;
+      pl->clipmaxx = hi;
+   }
+
+   if(empty)
+      R_unsetPlaneColumns(pl, newminx, newmaxx);
+   else
+   {
+      R_unsetPlaneColumns(pl, newminx, pl->minx - 1);
+      R_unsetPlaneColumns(pl, pl->maxx + 1, newmaxx);
+   }
+
+   pl->minx = newminx;
+   pl->maxx = newmaxx;
+}
+
 //
 // texture mapping
 //
@@ -666,6 +794,10 @@ void R_ClearPlanes()
 
    R_ClearPlaneHash(&mainhash);
 
+   // rewind the silhouette arena
+   planeclipcur  = planeclipblocks;
+   planeclipused = 0;
+
    lastopening = openings;
 }
 
@@ -690,17 +822,9 @@ static visplane_t *new_visplane(unsigned hash, planehash_t *table)
    
    check->table = table;
 
-   if(!check->top)
-   {
-      int *paddedTop, *paddedBottom;
-
-      check->max_width = (unsigned int)video.width;
-      paddedTop    = ecalloctag(int *, 2 * (video.width + 2), sizeof(int), PU_VALLOC, NULL);
-      paddedBottom = paddedTop + video.width + 2;
-
-      check->top    = paddedTop    + 1;
-      check->bottom = paddedBottom + 1;
-   }
+   // silhouette arrays are allocated once the plane has columns
+   check->top    = NULL;
+   check->bottom = NULL;
    
    return check;
 }
@@ -817,13 +941,6 @@ visplane_t *R_FindPlane(fixed_t height, int picnum, int lightlevel,
       check->viewzf =  view.z;
    }
    
-   {
-      unsigned int i = 0;
-      int *p = check->top;
-      while(i < check->max_width) 
-         p[i++] = 0x7FFFFFFF;
-   }
-   
    return check;
 }
 
@@ -846,11 +963,11 @@ visplane_t *R_CheckPlane(visplane_t *pl, int start, int stop)
    else
       unionh  = pl->maxx, intrh  = stop;
 
-   for(x = intrl; x <= intrh && pl->top[x] == 0x7FFFFFFF; ++x)
+   for(x = intrl; x <= intrh && pl->top[x] == PL_UNSETTOP; ++x)
       ;
 
    if(x > intrh)
-      pl->minx = unionl, pl->maxx = unionh;
+      R_growPlaneClips(pl, unionl, unionh);
    else
    {
       unsigned hash = visplane_hash(pl->picnum, pl->lightlevel, pl->height, table->chaincount);
@@ -889,14 +1006,9 @@ visplane_t *R_CheckPlane(visplane_t *pl, int start, int stop)
       new_pl->fullcolormap = pl->fullcolormap;
 
       pl = new_pl;
-      pl->minx = start;
-      pl->maxx = stop;
-      {
-         int *p = pl->top;
-         unsigned i = 0;
-         while(i < pl->max_width)
-            p[i++] = 0x7FFFFFFF;
-      }
+      pl->minx = viewwindow.width;
+      pl->maxx = -1;
+      R_growPlaneClips(pl, start, stop);
    }
    
    return pl;
@@ -1227,7 +1339,8 @@ static void do_draw_plane(visplane_t *pl)
          light = 0;
 
       stop = pl->maxx + 1;
-      pl->top[pl->minx-1] = pl->top[stop] = 0x7FFFFFFF;
+      pl->top[pl->minx-1] = pl->top[stop] = PL_UNSETTOP;
+      pl->bottom[pl->minx-1] = pl->bottom[stop] = 0;
 
       plane.planezlight   = pl->colormap[light]; //zlight[light];
       plane.colormap      = pl->fullcolormap;
@@ -1239,7 +1352,11 @@ static void do_draw_plane(visplane_t *pl)
       plane.MapFunc = (plane.slope == NULL ? R_MapPlane : R_MapSlope);
 
       for(x = pl->minx ; x <= stop ; x++)
-         R_MakeSpans(x, pl->top[x-1], pl->bottom[x-1], pl->top[x], pl->bottom[x]);
+      {
+         // columns matching their predecessor neither end nor start spans
+         if(pl->top[x] != pl->top[x-1] || pl->bottom[x] != pl->bottom[x-1])
+            R_MakeSpans(x, pl->top[x-1], pl->bottom[x-1], pl->top[x], pl->bottom[x]);
+      }
    }
 }
 
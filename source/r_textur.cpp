@@ -32,7 +32,9 @@
 #include "d_io.h"
 #include "d_main.h"
 #include "e_hash.h"
+#include "m_collection.h"
 #include "m_compare.h"
+#include "m_jobs.h"
 #include "m_swap.h"
 #include "p_setup.h"
 #include "p_skin.h"
@@ -627,26 +629,25 @@ struct tempmask_s
 //
 // AddTexColumn
 //
-// Copies from src to the tex buffer and optionally marks the temporary mask
+// Copies from src to the tex buffer and marks the mask, if there is one
 //
-static void AddTexColumn(texture_t *tex, const byte *src, int srcstep, 
-                         int ptroff, int len)
+static void AddTexColumn(texture_t *tex, byte *mask, const byte *src, 
+                         int srcstep, int ptroff, int len)
 {
    byte *dest = tex->buffer + ptroff;
    
 #ifdef RANGECHECK
-   if(ptroff < 0 || ptroff + len > tex->width * tex->height ||
-      ptroff + len > tempmask.buffermax)
+   if(ptroff < 0 || ptroff + len > tex->width * tex->height)
    {
-      I_Error("AddTexColumn(%s) invalid ptroff: %i / (%i, %i)\n", 
+      I_Error("AddTexColumn(%s) invalid ptroff: %i / %i\n", 
               (const char *)(tex->name), 
-              ptroff + len, tex->width * tex->height, tempmask.buffermax);
+              ptroff + len, tex->width * tex->height);
    }
 #endif
 
-   if(tempmask.mask && tex == tempmask.tex)
+   if(mask)
    {
-      byte *mask = tempmask.buffer + ptroff;
+      mask += ptroff;
       
       while(len > 0)
       {
@@ -673,9 +674,9 @@ static void AddTexColumn(texture_t *tex, const byte *src, int srcstep,
 // 
 // Paints the given flat-based component to the texture and marks mask info
 //
-static void AddTexFlat(texture_t *tex, tcomponent_t *component)
+static void AddTexFlat(texture_t *tex, byte *mask, 
+                       const tcomponent_t *component, const byte *src)
 {
-   byte      *src = (byte *)(wGlobalDir.cacheLumpNum(component->lump, PU_CACHE));
    int       destoff, srcoff, deststep, srcxstep, srcystep;
    int       xstart, ystart, xstop, ystop;
    int       width, height, wcount, hcount;
@@ -735,7 +736,7 @@ static void AddTexFlat(texture_t *tex, tcomponent_t *component)
          I_Error("AddTexFlat(%s): Invalid srcoff %i / %i\n", 
                  (const char *)(tex->name), srcoff, tex->width * tex->height);
 #endif
-      AddTexColumn(tex, src + srcoff, srcystep, destoff, hcount);
+      AddTexColumn(tex, mask, src + srcoff, srcystep, destoff, hcount);
       srcoff += srcxstep;
       destoff += deststep;
       wcount--;
@@ -747,9 +748,9 @@ static void AddTexFlat(texture_t *tex, tcomponent_t *component)
 // 
 // Paints the given flat-based component to the texture and marks mask info
 //
-static void AddTexPatch(texture_t *tex, tcomponent_t *component)
+static void AddTexPatch(texture_t *tex, byte *mask, 
+                        const tcomponent_t *component, const patch_t *patch)
 {
-   patch_t *patch = PatchLoader::CacheNum(wGlobalDir, component->lump, PU_CACHE);
    int      destoff;
    int      xstart, ystart, xstop;
    int      colindex, colstep;
@@ -781,7 +782,7 @@ static void AddTexPatch(texture_t *tex, tcomponent_t *component)
    {
       int top, y1, y2, destbase;
       const column_t *column = 
-         (const column_t *)((byte *)patch + patch->columnofs[colindex]);
+         (const column_t *)((const byte *)patch + patch->columnofs[colindex]);
          
       destbase = x * tex->height;
       top = 0;
@@ -827,7 +828,7 @@ static void AddTexPatch(texture_t *tex, tcomponent_t *component)
 #endif
             
          if(y2 - y1 > 0)
-            AddTexColumn(tex, src + srcoff, 1, destoff, y2 - y1);
+            AddTexColumn(tex, mask, src + srcoff, 1, destoff, y2 - y1);
             
          column = (const column_t *)(src + column->length + 1);
       }
@@ -835,12 +836,12 @@ static void AddTexPatch(texture_t *tex, tcomponent_t *component)
 }
 
 //
-// StartTexture
+// AllocTexBuffer
 //
-// Allocates the texture buffer, as well as managing the temporary structs and
-// the mask buffer.
+// Allocates the texture buffer and returns its length, which is also the
+// length a mask buffer for the texture must have.
 //
-static void StartTexture(texture_t *tex, bool mask)
+static int AllocTexBuffer(texture_t *tex)
 {
    // haleyjd 11/18/12: We *must* allocate some pad space in the texture buffer.
    // Due to intermixed use of float and fixed_t in Cardboard, it is impossible
@@ -852,6 +853,19 @@ static void StartTexture(texture_t *tex, bool mask)
    
    // Static for now
    tex->buffer = ecalloctag(byte *, 1, bufferlen, PU_STATIC, (void **)&tex->buffer);
+
+   return bufferlen;
+}
+
+//
+// StartTexture
+//
+// Allocates the texture buffer, as well as managing the temporary structs and
+// the mask buffer.
+//
+static void StartTexture(texture_t *tex, bool mask)
+{
+   int bufferlen = AllocTexBuffer(tex);
    
    if((tempmask.mask = mask))
    {
@@ -1011,6 +1025,8 @@ texture_t *R_CacheTexture(int num)
    StartTexture(tex, tex->columns == NULL);
    
    // Add the components to the buffer/mask
+   byte *mask = tempmask.mask ? tempmask.buffer : NULL;
+
    for(i = 0; i < tex->ccount; i++)
    {
       tcomponent_t *component = tex->components + i;
@@ -1022,10 +1038,12 @@ texture_t *R_CacheTexture(int num)
       switch(component->type)
       {
       case TC_FLAT:
-         AddTexFlat(tex, component);
+         AddTexFlat(tex, mask, component, 
+                    (byte *)(wGlobalDir.cacheLumpNum(component->lump, PU_CACHE)));
          break;
       case TC_PATCH:
-         AddTexPatch(tex, component);
+         AddTexPatch(tex, mask, component, 
+                     PatchLoader::CacheNum(wGlobalDir, component->lump, PU_CACHE));
          break;
       default:
          break;
@@ -1037,6 +1055,346 @@ texture_t *R_CacheTexture(int num)
    return tex;
 }
 
+//=============================================================================
+//
+// Texture precaching on the job threads
+//
+// The main thread reads the component lumps and allocates the buffers, since
+// neither the WAD code nor the zone heap may be used from a job. Painting the
+// components and finding the masked columns is done by one job per texture,
+// with the mask kept in the job's scratch memory. Textures are handled a
+// batch at a time, and a join job depending on every texture in the batch
+// lets the main thread read in the next batch while the last one is built.
+//
+
+#define TEXBATCHSIZE 64
+
+struct texbuild_t
+{
+   texture_t   *tex;
+   const void **lumps;     // component data, NULL where there is no lump
+   bool         mask;      // columns must be built
+   texcol_t    *cols;      // columns found, in order
+   int         *colcounts; // number of columns at each x
+   job_t       *job;
+};
+
+struct texbatch_t
+{
+   texbuild_t            builds[TEXBATCHSIZE];
+   int                   numbuilds;
+   PODCollection<void *> locked; // lumps made static for the batch
+   job_t                *join;
+};
+
+//
+// ScanTexMask
+//
+// Finds the runs of opaque pixels in a mask, storing them in cols and the
+// number found at each x in colcounts unless cols is NULL. Returns the total.
+//
+static int ScanTexMask(const texture_t *tex, const byte *mask, 
+                       texcol_t *cols, int *colcounts)
+{
+   const byte *maskp = mask;
+   int         total = 0;
+
+   for(int x = 0; x < tex->width; x++)
+   {
+      int y = 0, count = 0;
+
+      while(y < tex->height)
+      {
+         // Skip transparent pixels
+         while(y < tex->height && !*maskp)
+         {
+            maskp++;
+            y++;
+         }
+
+         if(y == tex->height)
+            break;
+
+         int yoff = y;
+         while(y < tex->height && *maskp)
+         {
+            maskp++;
+            y++;
+         }
+
+         if(cols)
+         {
+            texcol_t &col = cols[total + count];
+            col.yoff   = yoff;
+            col.len    = y - yoff;
+            col.ptroff = uint32_t(maskp - mask) - col.len;
+            col.next   = NULL;
+         }
+         count++;
+      }
+
+      if(cols)
+         colcounts[x] = count;
+      total += count;
+   }
+
+   return total;
+}
+
+//
+// R_texBuildJob
+//
+// Paints one texture and finds its columns.
+//
+static void R_texBuildJob(void *data)
+{
+   texbuild_t *build = static_cast<texbuild_t *>(data);
+   texture_t  *tex   = build->tex;
+   byte       *mask  = NULL;
+   bool        owned = false;
+
+   if(build->mask)
+   {
+      int masklen = tex->width * tex->height + 4;
+
+      if(!(mask = static_cast<byte *>(M_JobScratch(masklen))))
+      {
+         mask  = new byte[masklen];
+         owned = true;
+      }
+      memset(mask, 0, masklen);
+   }
+
+   for(int i = 0; i < tex->ccount; i++)
+   {
+      const tcomponent_t *component = tex->components + i;
+
+      if(!build->lumps[i])
+         continue;
+
+      switch(component->type)
+      {
+      case TC_FLAT:
+         AddTexFlat(tex, mask, component, 
+                    static_cast<const byte *>(build->lumps[i]));
+         break;
+      case TC_PATCH:
+         AddTexPatch(tex, mask, component, 
+                     static_cast<const patch_t *>(build->lumps[i]));
+         break;
+      default:
+         break;
+      }
+   }
+
+   if(mask)
+   {
+      int total = ScanTexMask(tex, mask, NULL, NULL);
+
+      build->cols      = total ? new texcol_t[total] : NULL;
+      build->colcounts = new int[tex->width];
+      ScanTexMask(tex, mask, build->cols, build->colcounts);
+
+      if(owned)
+         delete [] mask;
+   }
+}
+
+//
+// R_texBatchJoin
+//
+// Runs once every texture in a batch has been built, and frees their jobs.
+//
+static void R_texBatchJoin(void *data)
+{
+   texbatch_t *batch = static_cast<texbatch_t *>(data);
+
+   for(int i = 0; i < batch->numbuilds; i++)
+      M_WaitJob(batch->builds[i].job);
+}
+
+//
+// R_lockTexLump
+//
+// Keeps a cached lump from being purged until the batch is finished. A lump
+// the previous batch locked is handed over, since this batch finishes last.
+// Lumps that were already static are left alone.
+//
+static const void *R_lockTexLump(texbatch_t &batch, texbatch_t &prev, void *lump)
+{
+   if(Z_CheckTag(lump) >= PU_PURGELEVEL)
+   {
+      Z_ChangeTag(lump, PU_STATIC);
+      batch.locked.add(lump);
+      return lump;
+   }
+
+   for(size_t i = 0; i < prev.locked.getLength(); i++)
+   {
+      if(prev.locked[i] == lump)
+      {
+         prev.locked[i] = NULL;
+         batch.locked.add(lump);
+         break;
+      }
+   }
+
+   return lump;
+}
+
+//
+// R_startTexBatch
+//
+// Reads in the lumps for textures [start, stop) and starts building them.
+// prev is the batch still being built, if any.
+//
+static void R_startTexBatch(texbatch_t &batch, texbatch_t &prev, 
+                            int start, int stop)
+{
+   batch.numbuilds = 0;
+   batch.join      = M_NewJob("R_PrecacheTextures", R_texBatchJoin, &batch);
+
+   for(int i = start; i < stop; i++)
+   {
+      texture_t *tex = textures[i];
+
+      // already built, or an error; either way R_CacheTexture will handle it
+      if(tex->buffer || !tex->ccount)
+      {
+         R_CacheTexture(i);
+         continue;
+      }
+
+      texbuild_t &build = batch.builds[batch.numbuilds++];
+
+      build.tex       = tex;
+      build.lumps     = new const void *[tex->ccount];
+      build.mask      = (tex->columns == NULL);
+      build.cols      = NULL;
+      build.colcounts = NULL;
+
+      AllocTexBuffer(tex);
+
+      for(int c = 0; c < tex->ccount; c++)
+      {
+         const tcomponent_t *component = tex->components + c;
+
+         if(component->lump == -1)
+            build.lumps[c] = NULL;
+         else if(component->type == TC_FLAT)
+         {
+            build.lumps[c] = R_lockTexLump(batch, prev, 
+               wGlobalDir.cacheLumpNum(component->lump, PU_CACHE));
+         }
+         else
+         {
+            build.lumps[c] = R_lockTexLump(batch, prev, 
+               PatchLoader::CacheNum(wGlobalDir, component->lump, PU_CACHE));
+         }
+      }
+
+      build.job = M_NewJob("R_CacheTexture", R_texBuildJob, &build);
+      M_JobDepends(batch.join, build.job);
+   }
+
+   for(int i = 0; i < batch.numbuilds; i++)
+      M_SubmitJob(batch.builds[i].job);
+   M_SubmitJob(batch.join);
+}
+
+//
+// R_finishTexBatch
+//
+// Waits for a batch, then gives its textures their columns and releases the
+// lumps and buffers to the cache.
+//
+static void R_finishTexBatch(texbatch_t &batch)
+{
+   M_WaitJob(batch.join);
+   batch.join = NULL;
+
+   for(int i = 0; i < batch.numbuilds; i++)
+   {
+      texbuild_t &build = batch.builds[i];
+      texture_t  *tex   = build.tex;
+
+      if(build.mask)
+      {
+         const texcol_t *src = build.cols;
+
+         tex->columns = ecalloctag(texcol_t **, sizeof(texcol_t **), tex->width, 
+                                   PU_RENDERER, NULL);
+
+         for(int x = 0; x < tex->width; x++)
+         {
+            int count = build.colcounts[x];
+
+            // No columns? No problem!
+            if(!count)
+               continue;
+
+            texcol_t *tcol = tex->columns[x] = 
+               estructalloctag(texcol_t, count, PU_RENDERER);
+
+            memcpy(tcol, src, count * sizeof(texcol_t));
+            for(int c = 0; c < count - 1; c++)
+               tcol[c].next = tcol + c + 1;
+            src += count;
+         }
+
+         delete [] build.cols;
+         delete [] build.colcounts;
+      }
+
+      Z_ChangeTag(tex->buffer, PU_CACHE);
+      delete [] build.lumps;
+   }
+
+   for(size_t i = 0; i < batch.locked.getLength(); i++)
+   {
+      if(batch.locked[i])
+         Z_ChangeTag(batch.locked[i], PU_CACHE);
+   }
+   batch.locked.makeEmpty();
+}
+
+//
+// R_PrecacheTextures
+//
+// Builds textures [start, stop), spread over the job threads when there are
+// any.
+//
+static void R_PrecacheTextures(int start, int stop)
+{
+   if(!M_NumJobWorkers())
+   {
+      for(int i = start; i < stop; i++)
+         R_CacheTexture(i);
+      return;
+   }
+
+   texbatch_t *batches = new texbatch_t[2];
+   int         cur     = 0;
+
+   batches[0].join = batches[1].join = NULL;
+
+   for(int i = start; i < stop; i += TEXBATCHSIZE)
+   {
+      R_startTexBatch(batches[cur], batches[cur ^ 1], i, 
+                      emin(i + TEXBATCHSIZE, stop));
+
+      cur ^= 1;
+      if(batches[cur].join)
+         R_finishTexBatch(batches[cur]);
+   }
+
+   cur ^= 1;
+   if(batches[cur].join)
+      R_finishTexBatch(batches[cur]);
+
+   delete [] batches;
+}
+
 //
 // R_checkerBoardTexture
 //
@@ -1337,7 +1695,7 @@ void R_InitTextures()
    auto &tns = wGlobalDir.getNamespace(lumpinfo_t::ns_textures);
    int *patchlookup;
    int errors = 0;
-   int i, texnum = 0;
+   int texnum = 0;
    bool needDummy = false;
    
    texturelump_t *maptex1;
@@ -1417,8 +1775,7 @@ void R_InitTextures()
    // SoM: This REALLY hits us when starting EE with large wads. Caching 
    // textures on map start would probably be preferable 99.9% of the time...
    // Precache textures
-   for(i = wallstart; i < wallstop; i++)
-      R_CacheTexture(i);
+   R_PrecacheTextures(wallstart, wallstop);
    
    if(errors)
       I_Error("\n\n%d texture errors.\n", errors); 
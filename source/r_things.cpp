@@ -55,6 +55,7 @@
 #include "r_segs.h"
 #include "r_state.h"
 #include "r_things.h"
+#include "r_voxels.h"
 #include "v_alloc.h"
 #include "v_misc.h"
 #include "v_patchfmt.h"
@@ -115,6 +116,8 @@ int        inactiveParticles;
 particle_t *Particles;
 int        particle_trans;
 
+particlemotion_t ParticleMotion;
+
 float *mfloorclip, *mceilingclip;
 
 cb_maskedcolumn_t maskedcolumn;
@@ -167,6 +170,10 @@ struct vissprite_t
 
   int    sector; // SoM: sector the sprite is in.
 
+  // voxel model drawn instead of a patch, with the thing's orientation
+  rvoxelmodel_t *voxel;
+  angle_t voxangle;
+  float   voxxscale, voxyscale;
 };
 
 // haleyjd 04/25/10: drawsegs optimization
@@ -174,6 +181,8 @@ struct drawsegs_xrange_t
 {
    int x1, x2;
    drawseg_t *user;
+   unsigned int sprstamp; // last sprite to test this drawseg
+   bool         behind;   // result of depth test against that sprite
 };
 
 //=============================================================================
@@ -203,6 +212,24 @@ static drawsegs_xrange_t *drawsegs_xrange;
 static unsigned int drawsegs_xrange_size = 0;
 static int drawsegs_xrange_count = 0;
 
+// drawsegs_xrange entries bucketed into bins of screen columns, so that
+// each sprite only needs to examine the drawsegs which overlap it
+#define DSBINSHIFT 5
+#define DSBINSIZE  (1 << DSBINSHIFT)
+
+static int *drawsegs_binstart;  // first index into drawsegs_binlist per bin
+static int *drawsegs_binlist;   // indices into drawsegs_xrange, in order
+static unsigned int drawsegs_binlist_size = 0;
+static int drawsegs_numbins;
+static unsigned int drawsegs_sprstamp;
+
+VALLOCATION(drawsegs_binstart)
+{
+   drawsegs_numbins  = (w + DSBINSIZE - 1) >> DSBINSHIFT;
+   drawsegs_binstart = 
+      ecalloctag(int *, drawsegs_numbins + 1, sizeof(int), PU_VALLOC, NULL);
+}
+
 static float *pscreenheightarray; // for psprites
 
 VALLOCATION(pscreenheightarray)
@@ -279,7 +306,7 @@ VALLOCATION(clipbot)
 
 // Forward declarations:
 static void R_DrawParticle(vissprite_t *vis);
-static void R_ProjectParticle(particle_t *particle);
+static void R_ProjectParticles(sector_t *sector);
 
 //
 // R_SetMaskedSilhouette
@@ -516,6 +543,7 @@ static void R_InitSpriteDefs(char **namelist)
 void R_InitSprites(char **namelist)
 {
    R_InitSpriteDefs(namelist);
+   R_InitVoxels(namelist);
 }
 
 //
@@ -686,6 +714,175 @@ void R_DrawNewMaskedColumn(texture_t *tex, texcol_t *tcol)
    column.texmid = basetexturemid;
 }
 
+//
+// R_voxelDrawOrder
+//
+// Orders the rows of a voxel model along one axis from far to near, as
+// seen from viewpos on that axis.
+//
+static void R_voxelDrawOrder(int *order, int size, float viewpos)
+{
+   int split = eclamp((int)floorf(viewpos), -1, size);
+   int i;
+
+   for(i = 0; i < split; i++)
+      *order++ = i;
+   for(i = size - 1; i > split; i--)
+      *order++ = i;
+   if(split >= 0 && split < size)
+      *order = split;
+}
+
+//
+// R_DrawVoxel
+//
+// Draws a voxel model far to near as columns of slabs, using the column
+// drawer already set up for the vissprite. Slabs with no face toward the
+// viewer are skipped, and the level of detail is chosen so that voxels are
+// about a pixel in size at the model's distance.
+//
+//  mfloorclip and mceilingclip should also be set.
+//
+static void R_DrawVoxel(vissprite_t *vis)
+{
+   static int xorder[RVOXELMAXSIZE];
+   static int yorder[RVOXELMAXSIZE];
+
+   const rvoxelmodel_t *model = vis->voxel;
+   int mipnum = 0;
+
+   // use the coarsest level whose voxels are no larger than a pixel
+   while(mipnum + 1 < model->nummips &&
+         vis->scale * vis->voxyscale * (2 << mipnum) <= 1.0f)
+      ++mipnum;
+
+   const rvoxelmip_t &mip = model->mips[mipnum];
+   float voxsize   = vis->voxxscale * model->xsize / mip.xsize;
+   float voxheight = vis->voxyscale * model->zsize / mip.zsize;
+
+   // model origin relative to the viewer, in world and view space
+   float ox  = M_FixedToFloat(vis->gx) - view.x;
+   float oy  = M_FixedToFloat(vis->gy) - view.y;
+   float oz  = M_FixedToFloat(vis->gz - vis->footclip) - view.z;
+   float ovx = (ox * view.cos) - (oy * view.sin);
+   float ovy = (oy * view.cos) + (ox * view.sin);
+
+   // model x runs along the thing's facing, and model y to its right
+   float angle = vis->voxangle * PI / ANG180;
+   float ca = cosf(angle), sa = sinf(angle);
+   float fx = ( ca * view.cos - sa * view.sin) * voxsize;
+   float fy = ( sa * view.cos + ca * view.sin) * voxsize;
+   float rx = ( sa * view.cos + ca * view.sin) * voxsize;
+   float ry = (-ca * view.cos + sa * view.sin) * voxsize;
+   float halfwidth = 0.5f * (fabsf(fx) + fabsf(rx));
+
+   // viewer position in voxels; z is measured down from the model's top
+   float vlx = (-ox * ca - oy * sa) / voxsize + mip.xpivot;
+   float vly = (-ox * sa + oy * ca) / voxsize + mip.ypivot;
+   float vlz = mip.zsize + oz / voxheight;
+
+   // foot clipping hides the model below the thing's actual position
+   float footz = M_FixedToFloat(vis->gz) - view.z;
+
+   column.texheight = 0;
+
+   R_voxelDrawOrder(xorder, mip.xsize, vlx);
+   R_voxelDrawOrder(yorder, mip.ysize, vly);
+
+   for(int i = 0; i < mip.xsize; i++)
+   {
+      int  x = xorder[i];
+      byte xfaces = (vlx < x     ? RVOXFACE_LEFT  : 0) |
+                    (vlx > x + 1 ? RVOXFACE_RIGHT : 0);
+      float lx = x + 0.5f - mip.xpivot;
+
+      for(int j = 0; j < mip.ysize; j++)
+      {
+         int   y = yorder[j];
+         int   c = x * mip.ysize + y;
+         byte  sides = xfaces | (vly < y     ? RVOXFACE_BACK  : 0) |
+                                (vly > y + 1 ? RVOXFACE_FRONT : 0);
+         byte *slab    = mip.slabs + mip.columns[c];
+         byte *slabend = mip.slabs + mip.columns[c + 1];
+
+         // skip empty columns and those only showing their sides away
+         if(slab == slabend || 
+            !(mip.colfaces[c] & (sides | RVOXFACE_TOP | RVOXFACE_BOTTOM)))
+            continue;
+
+         float ly    = y + 0.5f - mip.ypivot;
+         float depth = ovy + lx * fy + ly * ry;
+
+         if(depth < 1.0f)
+            continue;
+
+         float idepth = 1.0f / depth;
+         float center = ovx + lx * fx + ly * rx;
+         float sx1    = view.xcenter + (center - halfwidth) * view.xfoc * idepth;
+         float sx2    = view.xcenter + (center + halfwidth) * view.xfoc * idepth;
+         int   x1     = (int)(sx1 + 0.999f);
+         int   x2     = (int)(sx2 - 0.001f);
+
+         // columns thinner than a pixel still cover the one they fall in
+         if(x1 > x2)
+            x1 = x2 = (int)((sx1 + sx2) * 0.5f);
+         if(x1 < vis->x1)
+            x1 = vis->x1;
+         if(x2 > vis->x2)
+            x2 = vis->x2;
+         if(x1 > x2)
+            continue;
+
+         float pscale  = voxheight * view.yfoc * idepth;
+         float ipscale = 1.0f / pscale;
+         float ybase   = view.ycenter - (oz + mip.zsize * voxheight) * view.yfoc * idepth;
+         float ymax    = vis->footclip ? 
+                         view.ycenter - footz * view.yfoc * idepth : view.height;
+
+         column.step = M_FloatToFixed(ipscale);
+
+         while(slab < slabend)
+         {
+            int ztop = slab[0], zlen = slab[1];
+            byte mask = sides | (vlz < ztop        ? RVOXFACE_TOP    : 0) |
+                                (vlz > ztop + zlen ? RVOXFACE_BOTTOM : 0);
+
+            if(slab[2] & mask)
+            {
+               float top    = ybase + ztop * pscale;
+               int   bottom = (int)ceilf(emin(top + zlen * pscale, ymax)) - 1;
+
+               column.source = slab + 3;
+
+               for(column.x = x1; column.x <= x2; column.x++)
+               {
+                  float ctop = emax(top, mceilingclip[column.x]);
+
+                  column.y1 = (int)ceilf(ctop);
+                  column.y2 = emin(bottom, (int)mfloorclip[column.x]);
+
+                  // same failsafe as for masked columns
+                  if(column.y1 > column.y2 || column.y1 < 0 || 
+                     column.y2 >= viewwindow.height)
+                     continue;
+
+                  // start exactly at the first voxel the column covers
+                  fixed_t frac = M_FloatToFixed((column.y1 - top) * ipscale);
+                  if(frac < 0)
+                     frac = 0;
+                  column.texmid = frac - 
+                     (int)((column.y1 - view.ycenter + 1) * column.step);
+
+                  colfunc();
+               }
+            }
+
+            slab += 3 + zlen;
+         }
+      }
+   }
+}
+
 //
 // R_DrawVisSprite
 //
@@ -707,8 +904,6 @@ static void R_DrawVisSprite(vissprite_t *vis, int x1, int x2)
       R_DrawParticle(vis);
       return;
    }
-  
-   patch = PatchLoader::CacheNum(wGlobalDir, vis->patch+firstspritelump, PU_CACHE);
    
    column.colormap = vis->colormap;
    
@@ -728,6 +923,15 @@ static void R_DrawVisSprite(vissprite_t *vis, int x1, int x2)
    // haleyjd: faster selection for drawstyles
    colfunc = r_column_engine->ByVisSpriteStyle[vis->drawstyle][!!vis->colour];
 
+   if(vis->voxel)
+   {
+      R_DrawVoxel(vis);
+      colfunc = r_column_engine->DrawColumn;
+      return;
+   }
+
+   patch = PatchLoader::CacheNum(wGlobalDir, vis->patch+firstspritelump, PU_CACHE);
+
    //column.step = M_FloatToFixed(vis->ystep);
    column.step = M_FloatToFixed(1.0f / vis->scale);
    column.texmid = vis->texturemid;
@@ -822,6 +1026,7 @@ static void R_ProjectSprite(Mobj *thing, v3fixed_t *delta = nullptr)
    vissprite_t   *vis;
    int            heightsec;      // killough 3/27/98
    sector_t      *sec;            // haleyjd: for interpolation
+   rvoxelmodel_t *voxel;
 
    float tempx, tempy;
    float rotx, roty;
@@ -915,64 +1120,105 @@ static void R_ProjectSprite(Mobj *thing, v3fixed_t *delta = nullptr)
 
    sprframe = &sprdef->spriteframes[thing->frame & FF_FRAMEMASK];
    
-   if(sprframe->rotate)
+   if((voxel = sprframe->voxel))
    {
-      // SoM: Use old rotation code
-      // choose a different rotation based on player view
-      angle_t ang = R_PointToAngle(spritepos.x, spritepos.y);
-      unsigned int rot = (ang - thing->angle + (unsigned int)(ANG45/2)*9) >> 29;
-      lump = sprframe->lump[rot];
-      flip = !!sprframe->flip[rot];
+      // Bound the model's projection by a cylinder around its pivot; the
+      // model stands on the thing's position, sunk by any foot clipping.
+      float radius = voxel->radius * thing->xscale;
+      float nearz  = emax(roty - radius, 1.0f);
+      float farz   = roty + radius;
+
+      lump   = sprframe->lump[0];
+      flip   = false;
+      swidth = 0.0f;
+
+      idist = 1.0f / roty;
+      distyscale = idist * view.yfoc;
+
+      tx1 = rotx - radius;
+      x1  = view.xcenter + tx1 * view.xfoc / (tx1 < 0.0f ? nearz : farz);
+      if(x1 >= view.width)
+         return;
+
+      tx2 = rotx + radius;
+      x2  = view.xcenter + tx2 * view.xfoc / (tx2 > 0.0f ? nearz : farz);
+      if(x2 < 0.0f)
+         return;
+
+      tz2 = M_FixedToFloat(spritepos.z - thing->floorclip) - view.z;
+      tz1 = tz2 + voxel->zsize * thing->yscale;
+      y1  = view.ycenter - tz1 * view.yfoc / (tz1 > 0.0f ? nearz : farz);
+      if(y1 >= view.height)
+         return;
+
+      y2 = view.ycenter - tz2 * view.yfoc / (tz2 < 0.0f ? nearz : farz) - 1.0f;
+      if(y2 < 0.0f)
+         return;
+
+      gzt = spritepos.z - thing->floorclip + 
+            M_FloatToFixed(voxel->zsize * thing->yscale);
    }
    else
    {
-      // use single rotation for all views
-      lump = sprframe->lump[0];
-      flip = !!sprframe->flip[0];
-   }
+      if(sprframe->rotate)
+      {
+         // SoM: Use old rotation code
+         // choose a different rotation based on player view
+         angle_t ang = R_PointToAngle(spritepos.x, spritepos.y);
+         unsigned int rot = (ang - thing->angle + (unsigned int)(ANG45/2)*9) >> 29;
+         lump = sprframe->lump[rot];
+         flip = !!sprframe->flip[rot];
+      }
+      else
+      {
+         // use single rotation for all views
+         lump = sprframe->lump[0];
+         flip = !!sprframe->flip[0];
+      }
 
 
-   // Calculate the edges of the shape
-   swidth      = M_FixedToFloat(spritewidth[lump]);
-   stopoffset  = M_FixedToFloat(spritetopoffset[lump]);
-   sleftoffset = M_FixedToFloat(spriteoffset[lump]);
+      // Calculate the edges of the shape
+      swidth      = M_FixedToFloat(spritewidth[lump]);
+      stopoffset  = M_FixedToFloat(spritetopoffset[lump]);
+      sleftoffset = M_FixedToFloat(spriteoffset[lump]);
 
 
-   tx1 = rotx - (flip ? swidth - sleftoffset : sleftoffset) * thing->xscale;
-   tx2 = tx1 + swidth * thing->xscale;
+      tx1 = rotx - (flip ? swidth - sleftoffset : sleftoffset) * thing->xscale;
+      tx2 = tx1 + swidth * thing->xscale;
 
-   idist = 1.0f / roty;
-   distxscale = idist * view.xfoc;
+      idist = 1.0f / roty;
+      distxscale = idist * view.xfoc;
 
-   x1 = view.xcenter + (tx1 * distxscale);
-   if(x1 >= view.width)
-      return;
+      x1 = view.xcenter + (tx1 * distxscale);
+      if(x1 >= view.width)
+         return;
 
-   x2 = view.xcenter + (tx2 * distxscale);
-   if(x2 < 0.0f)
-      return;
+      x2 = view.xcenter + (tx2 * distxscale);
+      if(x2 < 0.0f)
+         return;
 
-   intx1 = (int)(x1 + 0.999f);
-   intx2 = (int)(x2 - 0.001f);
+      distyscale = idist * view.yfoc;
+      // SoM: forgot about footclipping
+      tz1 = thing->yscale * stopoffset + M_FixedToFloat(spritepos.z - thing->floorclip) - view.z;
+      y1  = view.ycenter - (tz1 * distyscale);
+      if(y1 >= view.height)
+         return;
 
-   distyscale = idist * view.yfoc;
-   // SoM: forgot about footclipping
-   tz1 = thing->yscale * stopoffset + M_FixedToFloat(spritepos.z - thing->floorclip) - view.z;
-   y1  = view.ycenter - (tz1 * distyscale);
-   if(y1 >= view.height)
-      return;
+      tz2 = tz1 - spriteheight[lump] * thing->yscale;
+      y2  = view.ycenter - (tz2 * distyscale) - 1.0f;
+      if(y2 < 0.0f)
+         return;
 
-   tz2 = tz1 - spriteheight[lump] * thing->yscale;
-   y2  = view.ycenter - (tz2 * distyscale) - 1.0f;
-   if(y2 < 0.0f)
-      return;
+      if(x2 >= x1)
+         pstep = 1.0f / (x2 - x1 + 1.0f);
 
-   if(x2 >= x1)
-      pstep = 1.0f / (x2 - x1 + 1.0f);
+      // Cardboard
+      // SoM: Block of old code that stays
+      gzt = spritepos.z + (fixed_t)(spritetopoffset[lump] * thing->yscale);
+   }
 
-   // Cardboard
-   // SoM: Block of old code that stays
-   gzt = spritepos.z + (fixed_t)(spritetopoffset[lump] * thing->yscale);
+   intx1 = (int)(x1 + 0.999f);
+   intx2 = (int)(x2 - 0.001f);
 
    // killough 3/27/98: exclude things totally separated
    // from the viewer, by either water or fake ceilings
@@ -1042,6 +1288,15 @@ static void R_ProjectSprite(Mobj *thing, v3fixed_t *delta = nullptr)
 
    vis->patch = lump;
 
+   vis->voxel = voxel;
+   if(voxel)
+   {
+      vis->scale     = distyscale;
+      vis->voxangle  = thing->angle;
+      vis->voxxscale = thing->xscale;
+      vis->voxyscale = thing->yscale;
+   }
+
    // get light level
    if(thing->flags & MF_SHADOW)     // sf
       vis->colormap = colormaps[global_cmap_index]; // haleyjd: NGCS -- was 0
@@ -1122,13 +1377,8 @@ void R_AddSprites(sector_t* sec, int lightlevel)
 
    // haleyjd 02/20/04: Handle all particles in sector.
 
-   if(drawparticles)
-   {
-      DLListItem<particle_t> *link;
-
-      for(link = sec->ptcllist; link; link = link->dllNext)
-         R_ProjectParticle(*link);
-   }
+   if(drawparticles && sec->ptcllist)
+      R_ProjectParticles(sec);
 }
 
 //
@@ -1245,6 +1495,7 @@ static void R_DrawPSprite(pspdef_t *psp)
       vis->startx += vis->xstep * (vis->x1-x1);
    
    vis->patch = lump;
+   vis->voxel = NULL;
 
    vis->drawstyle = VS_DRAWSTYLE_NORMAL;
    
@@ -1436,6 +1687,59 @@ static void R_SortVisSpriteRange(int first, int last)
    }
 }
 
+//
+// R_BinDrawsegs
+//
+// Buckets the entries of drawsegs_xrange by the screen column bins they
+// overlap, preserving their order within each bin.
+//
+static void R_BinDrawsegs()
+{
+   int bin, total;
+   int *binstart = drawsegs_binstart;
+
+   memset(binstart, 0, (drawsegs_numbins + 1) * sizeof(*binstart));
+
+   // count the entries in each bin
+   for(int i = 0; i < drawsegs_xrange_count; i++)
+   {
+      const drawsegs_xrange_t &dsx = drawsegs_xrange[i];
+      for(bin = dsx.x1 >> DSBINSHIFT; bin <= dsx.x2 >> DSBINSHIFT; bin++)
+         ++binstart[bin + 1];
+   }
+
+   // convert the counts into starting offsets
+   for(bin = 0, total = 0; bin < drawsegs_numbins; bin++)
+   {
+      int count = binstart[bin + 1];
+      binstart[bin] = total;
+      total += count;
+   }
+   binstart[drawsegs_numbins] = total;
+
+   if(drawsegs_binlist_size < (unsigned int)total)
+   {
+      drawsegs_binlist_size = 2 * total;
+      drawsegs_binlist = erealloc(int *, drawsegs_binlist,
+                                  drawsegs_binlist_size * sizeof(int));
+   }
+
+   // fill in the bins; each start offset is advanced to the start of the
+   // following bin, so shift them all back up afterward
+   for(int i = 0; i < drawsegs_xrange_count; i++)
+   {
+      drawsegs_xrange_t &dsx = drawsegs_xrange[i];
+      for(bin = dsx.x1 >> DSBINSHIFT; bin <= dsx.x2 >> DSBINSHIFT; bin++)
+         drawsegs_binlist[binstart[bin]++] = i;
+      dsx.sprstamp = 0;
+   }
+
+   memmove(binstart + 1, binstart, (drawsegs_numbins - 1) * sizeof(*binstart));
+   binstart[0] = 0;
+
+   drawsegs_sprstamp = 0;
+}
+
 //
 // R_DrawSpriteInDSRange
 //
@@ -1457,66 +1761,86 @@ static void R_DrawSpriteInDSRange(vissprite_t *spr, int firstds, int lastds)
    // e6y: optimization
    if(drawsegs_xrange_count)
    {
-      drawsegs_xrange_t *dsx = drawsegs_xrange;
+      int firstbin = spr->x1 >> DSBINSHIFT;
+      int lastbin  = spr->x2 >> DSBINSHIFT;
+
+      ++drawsegs_sprstamp;
 
-      // drawsegs_xrange is sorted by ::x1
-      // haleyjd: way faster to use a pointer here
-      while((ds = dsx->user))
+      // Each bin holds, in drawsegs_xrange order, every drawseg which covers
+      // any of its columns, so restricting the clipping done for a bin to its
+      // own columns gives the same result per column as a full scan.
+      for(int bin = firstbin; bin <= lastbin; bin++)
       {
-         // determine if the drawseg obscures the sprite
-         if(dsx->x1 > spr->x2 || dsx->x2 < spr->x1)
-         {
-            ++dsx;
-            continue;      // does not cover sprite
-         }
-         ++dsx;
+         int bx1 = bin << DSBINSHIFT;
+         int bx2 = bx1 + DSBINSIZE - 1;
+         const int *idx    = drawsegs_binlist + drawsegs_binstart[bin];
+         const int *idxend = drawsegs_binlist + drawsegs_binstart[bin + 1];
 
-         if(ds->dist1 > ds->dist2)
-         {
-            fardist = ds->dist2;
-            dist = ds->dist1;
-         }
-         else
-         {
-            fardist = ds->dist1;
-            dist = ds->dist2;
-         }
+         if(bx1 < spr->x1)
+            bx1 = spr->x1;
+         if(bx2 > spr->x2)
+            bx2 = spr->x2;
 
-         if(dist < spr->dist || (fardist < spr->dist &&
-            !R_PointOnSegSide(spr->gx, spr->gy, ds->curline)))
+         for(; idx != idxend; ++idx)
          {
-            if(ds->maskedtexturecol) // masked mid texture?
+            drawsegs_xrange_t *dsx = drawsegs_xrange + *idx;
+
+            // determine if the drawseg obscures this part of the sprite
+            if(dsx->x1 > bx2 || dsx->x2 < bx1)
+               continue;      // does not cover sprite
+
+            ds = dsx->user;
+
+            // only do the depth test once per sprite for segs spanning bins
+            if(dsx->sprstamp != drawsegs_sprstamp)
             {
-               r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-               r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
-               R_RenderMaskedSegRange(ds, r1, r2);
+               if(ds->dist1 > ds->dist2)
+               {
+                  fardist = ds->dist2;
+                  dist = ds->dist1;
+               }
+               else
+               {
+                  fardist = ds->dist1;
+                  dist = ds->dist2;
+               }
+
+               dsx->sprstamp = drawsegs_sprstamp;
+               dsx->behind   = (dist < spr->dist || (fardist < spr->dist &&
+                                !R_PointOnSegSide(spr->gx, spr->gy, ds->curline)));
             }
-            continue;                // seg is behind sprite
-         }
 
-         r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-         r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+            r1 = ds->x1 < bx1 ? bx1 : ds->x1;
+            r2 = ds->x2 > bx2 ? bx2 : ds->x2;
 
-         // clip this piece of the sprite
-         // killough 3/27/98: optimized and made much shorter
+            if(dsx->behind)
+            {
+               if(ds->maskedtexturecol) // masked mid texture?
+                  R_RenderMaskedSegRange(ds, r1, r2);
+               continue;                // seg is behind sprite
+            }
 
-         // bottom sil
-         if(ds->silhouette & SIL_BOTTOM && spr->gz < ds->bsilheight)
-         {
-            for(x = r1; x <= r2; x++)
+            // clip this piece of the sprite
+            // killough 3/27/98: optimized and made much shorter
+
+            // bottom sil
+            if(ds->silhouette & SIL_BOTTOM && spr->gz < ds->bsilheight)
             {
-               if(clipbot[x] == -2)
-                  clipbot[x] = ds->sprbottomclip[x];
+               for(x = r1; x <= r2; x++)
+               {
+                  if(clipbot[x] == -2)
+                     clipbot[x] = ds->sprbottomclip[x];
+               }
             }
-         }
 
-         // top sil
-         if(ds->silhouette & SIL_TOP && spr->gzt > ds->tsilheight)
-         {
-            for(x = r1; x <= r2; x++)
+            // top sil
+            if(ds->silhouette & SIL_TOP && spr->gzt > ds->tsilheight)
             {
-               if(cliptop[x] == -2)
-                  cliptop[x] = ds->sprtopclip[x];
+               for(x = r1; x <= r2; x++)
+               {
+                  if(cliptop[x] == -2)
+                     cliptop[x] = ds->sprtopclip[x];
+               }
             }
          }
       }
@@ -1742,8 +2066,8 @@ void R_DrawPostBSP()
                      drawsegs_xrange_count++;
                   }
                }
-               // haleyjd: terminate with a NULL user for faster loop - adds ~3 FPS
-               drawsegs_xrange[drawsegs_xrange_count].user = NULL;
+
+               R_BinDrawsegs();
             }
 
             ptop    = masked->ceilingclip;
@@ -2020,6 +2344,22 @@ void R_InitParticles()
       numParticles = 100;
    
    Particles = (particle_t *)(Z_Malloc(numParticles*sizeof(particle_t), PU_STATIC, NULL));
+
+   // motion arrays are padded so the integration pass works in fours
+   const int count = (numParticles + 3) & ~3;
+   fixed_t *motion = (fixed_t *)(Z_Malloc(9*count*sizeof(fixed_t), PU_STATIC, NULL));
+
+   ParticleMotion.count = count;
+   ParticleMotion.x     = motion;
+   ParticleMotion.y     = motion + count;
+   ParticleMotion.z     = motion + 2*count;
+   ParticleMotion.velx  = motion + 3*count;
+   ParticleMotion.vely  = motion + 4*count;
+   ParticleMotion.velz  = motion + 5*count;
+   ParticleMotion.accx  = motion + 6*count;
+   ParticleMotion.accy  = motion + 7*count;
+   ParticleMotion.accz  = motion + 8*count;
+
    R_ClearParticles();
 }
 
@@ -2033,6 +2373,7 @@ void R_ClearParticles()
    int i;
    
    memset(Particles, 0, numParticles*sizeof(particle_t));
+   memset(ParticleMotion.x, 0, 9*ParticleMotion.count*sizeof(fixed_t));
    activeParticles = -1;
    inactiveParticles = 0;
    for(i = 0; i < numParticles - 1; i++)
@@ -2040,10 +2381,22 @@ void R_ClearParticles()
    Particles[i].next = -1;
 }
 
+//
+// particlebatch_t
+//
+// Lighting shared by all particles in a sector, worked out by the first
+// particle which needs it.
+//
+struct particlebatch_t
+{
+   bool           colormapset; // R_SectorColormap has been called
+   lighttable_t **ltable;
+};
+
 //
 // R_ProjectParticle
 //
-static void R_ProjectParticle(particle_t *particle)
+static void R_ProjectParticle(particle_t *particle, particlebatch_t &batch)
 {
    fixed_t gzt;
    int x1, x2;
@@ -2054,10 +2407,14 @@ static void R_ProjectParticle(particle_t *particle)
    float tempx, tempy, ty1, tx1, tx2, tz;
    float idist, xscale, yscale;
    float y1, y2;
+   const int     n  = P_ParticleNum(particle);
+   const fixed_t px = ParticleMotion.x[n];
+   const fixed_t py = ParticleMotion.y[n];
+   const fixed_t pz = ParticleMotion.z[n];
 
    // SoM: Cardboard translate the mobj coords and just project the sprite.
-   tempx = M_FixedToFloat(particle->x) - view.x;
-   tempy = M_FixedToFloat(particle->y) - view.y;
+   tempx = M_FixedToFloat(px) - view.x;
+   tempy = M_FixedToFloat(py) - view.y;
    ty1   = (tempy * view.cos) + (tempx * view.sin);
 
    // lies in front of the front view plane
@@ -2086,7 +2443,7 @@ static void R_ProjectParticle(particle_t *particle)
    if(x1 >= viewwindow.width || x2 < 0)
       return;
 
-   tz = M_FixedToFloat(particle->z) - view.z;
+   tz = M_FixedToFloat(pz) - view.z;
 
    y1 = (view.ycenter - (tz * yscale));
    y2 = (view.ycenter - ((tz - 1.0f) * yscale));
@@ -2094,7 +2451,7 @@ static void R_ProjectParticle(particle_t *particle)
    if(y2 < 0.0f || y1 >= view.height)
       return;
    
-   gzt = particle->z + 1;
+   gzt = pz + 1;
    
    // killough 3/27/98: exclude things totally separated
    // from the viewer, by either water or fake ceilings
@@ -2106,8 +2463,8 @@ static void R_ProjectParticle(particle_t *particle)
       sector = subsector->sector;
       heightsec = sector->heightsec;
 
-      if(particle->z < sector->floorheight || 
-	 particle->z > sector->ceilingheight)
+      if(pz < sector->floorheight || 
+	 pz > sector->ceilingheight)
 	 return;
    }
    
@@ -2118,7 +2475,7 @@ static void R_ProjectParticle(particle_t *particle)
       
       if(phs != -1 && 
 	 viewz < sectors[phs].floorheight ?
-	 particle->z >= sectors[heightsec].floorheight :
+	 pz >= sectors[heightsec].floorheight :
          gzt < sectors[heightsec].floorheight)
          return;
 
@@ -2126,22 +2483,23 @@ static void R_ProjectParticle(particle_t *particle)
 	 viewz > sectors[phs].ceilingheight ?
 	 gzt < sectors[heightsec].ceilingheight &&
 	 viewz >= sectors[heightsec].ceilingheight :
-         particle->z >= sectors[heightsec].ceilingheight)
+         pz >= sectors[heightsec].ceilingheight)
          return;
    }
    
    // store information in a vissprite
    vis = R_NewVisSprite();
    vis->heightsec = heightsec;
-   vis->gx = particle->x;
-   vis->gy = particle->y;
-   vis->gz = particle->z;
+   vis->gx = px;
+   vis->gy = py;
+   vis->gz = pz;
    vis->gzt = gzt;
    vis->texturemid = vis->gzt - viewz;
    vis->x1 = x1 < 0 ? 0 : x1;
    vis->x2 = x2 >= viewwindow.width ? viewwindow.width-1 : x2;
    vis->colour = particle->color;
    vis->patch = -1;
+   vis->voxel = NULL;
    vis->translucency = static_cast<uint16_t>(particle->trans - 1);
    // Cardboard
    vis->dist = idist;
@@ -2158,7 +2516,11 @@ static void R_ProjectParticle(particle_t *particle)
    } 
    else
    {
-      R_SectorColormap(sector);
+      if(!batch.colormapset)
+      {
+         R_SectorColormap(sector);
+         batch.colormapset = true;
+      }
 
       if(LevelInfo.useFullBright && (particle->styleflags & PS_FULLBRIGHT))
       {
@@ -2166,32 +2528,50 @@ static void R_ProjectParticle(particle_t *particle)
       }
       else
       {
-         lighttable_t **ltable;
-         sector_t tmpsec;
-         int floorlightlevel, ceilinglightlevel, lightnum, index;
+         int index;
 
-         R_FakeFlat(sector, &tmpsec, &floorlightlevel, 
-                    &ceilinglightlevel, false);
+         if(!batch.ltable)
+         {
+            sector_t tmpsec;
+            int floorlightlevel, ceilinglightlevel, lightnum;
+
+            R_FakeFlat(sector, &tmpsec, &floorlightlevel, 
+                       &ceilinglightlevel, false);
 
-         lightnum = (floorlightlevel + ceilinglightlevel) / 2;
-         lightnum = (lightnum >> LIGHTSEGSHIFT) + (extralight * LIGHTBRIGHT);
+            lightnum = (floorlightlevel + ceilinglightlevel) / 2;
+            lightnum = (lightnum >> LIGHTSEGSHIFT) + (extralight * LIGHTBRIGHT);
          
-         if(lightnum >= LIGHTLEVELS || fixedcolormap)
-            ltable = scalelight[LIGHTLEVELS - 1];      
-         else if(lightnum < 0)
-            ltable = scalelight[0];
-         else
-            ltable = scalelight[lightnum];
+            if(lightnum >= LIGHTLEVELS || fixedcolormap)
+               batch.ltable = scalelight[LIGHTLEVELS - 1];      
+            else if(lightnum < 0)
+               batch.ltable = scalelight[0];
+            else
+               batch.ltable = scalelight[lightnum];
+         }
          
          index = (int)(idist * 2560.0f);
          if(index >= MAXLIGHTSCALE)
             index = MAXLIGHTSCALE - 1;
          
-         vis->colormap = ltable[index];
+         vis->colormap = batch.ltable[index];
       }
    }
 }
 
+//
+// R_ProjectParticles
+//
+// Projects all the particles linked into a sector. They share the sector's
+// colormap and light level, which are only determined once per batch.
+//
+static void R_ProjectParticles(sector_t *sector)
+{
+   particlebatch_t batch = { false, NULL };
+
+   for(auto link = sector->ptcllist; link; link = link->dllNext)
+      R_ProjectParticle(link->dllObject, batch);
+}
+
 //
 // R_DrawParticle
 //
@@ -20,75 +20,430 @@
 //
 // DESCRIPTION:
 //
-//   Abandoned to the mists of time!!!
+//   Voxel models: loading of KVX and VOX resources into slab columns
+//   that the software renderer can draw in place of sprite frames.
 //
 //-----------------------------------------------------------------------------
 
 #include "z_zone.h"
 #include "doomtype.h"
+
+#include "autopalette.h"
+#include "m_compare.h"
 #include "m_swap.h"
+#include "r_defs.h"
+#include "r_state.h"
+#include "r_voxels.h"
+#include "v_video.h"
 #include "w_wad.h"
 
-#include "r_voxels.h"
+//
+// R_voxelRemapPalette
+//
+// Converts the model's 6-bit palette to 8 bits per component and builds
+// a table mapping its colors to the closest colors in the game palette.
+//
+static void R_voxelRemapPalette(rvoxelmodel_t *model, byte *remap)
+{
+   AutoPalette pal(wGlobalDir);
+   const byte *playpal = pal.get();
+
+   // transform palette data into 0-255 range
+   for(int i = 0; i < 768; i++)
+      model->palette[i] <<= 2;
+
+   for(int i = 0; i < 256; i++)
+   {
+      const byte *rgb = model->palette + i * 3;
+      remap[i] = V_FindBestColor(playpal, rgb[0], rgb[1], rgb[2]);
+   }
+}
 
 //
-// R_LoadVoxelResource
+// R_voxelAllocMip
 //
-// Loads a .vox-format voxel model into an rvoxelmodel_t structure.
+// Allocates the column tables and slab buffer of a model level.
 //
-rvoxelmodel_t *R_LoadVoxelResource(int lumpnum)
+static void R_voxelAllocMip(rvoxelmip_t &mip, int xsize, int ysize, int zsize,
+                            size_t slabbytes)
 {
-   rvoxelmodel_t *model = NULL;
-   byte *buffer = NULL, *rover = NULL;
-   int lumplen  = W_LumpLength(lumpnum);
-   int xsize, ysize, zsize, voxsize;
-   int i;
+   int numcolumns = xsize * ysize;
 
-   // minimum size test
-   if(lumplen < 12)
+   mip.xsize    = xsize;
+   mip.ysize    = ysize;
+   mip.zsize    = zsize;
+   mip.columns  = ecalloctag(int *,  numcolumns + 1, sizeof(int), PU_RENDERER, NULL);
+   mip.colfaces = ecalloctag(byte *, numcolumns, 1, PU_RENDERER, NULL);
+   mip.slabs    = emalloctag(byte *, slabbytes ? slabbytes : 1, PU_RENDERER, NULL);
+}
+
+//
+// R_voxelFreeMip
+//
+static void R_voxelFreeMip(rvoxelmip_t &mip)
+{
+   efree(mip.columns);
+   efree(mip.colfaces);
+   efree(mip.slabs);
+   memset(&mip, 0, sizeof(mip));
+}
+
+//
+// R_voxelSetRadius
+//
+// Computes the horizontal extent of the model around its pivot, used to
+// bound its projection on screen.
+//
+static void R_voxelSetRadius(rvoxelmodel_t *model)
+{
+   const rvoxelmip_t &mip = model->mips[0];
+   float dx = emax(mip.xpivot, mip.xsize - mip.xpivot);
+   float dy = emax(mip.ypivot, mip.ysize - mip.ypivot);
+
+   model->radius = sqrtf(dx * dx + dy * dy);
+}
+
+//=============================================================================
+//
+// KVX Models
+//
+// The Build engine format: a series of mip levels, each holding columns of
+// slabs with precomputed face visibility, followed by a 6-bit palette.
+//
+
+#define KVXHEADERSIZE 28
+
+//
+// R_loadKVXMip
+//
+// Loads one level of a KVX model. Returns the number of bytes it occupies
+// in the lump, or 0 if the data is not valid.
+//
+static int R_loadKVXMip(rvoxelmip_t &mip, const byte *data, int avail, 
+                        const byte *remap)
+{
+   int numbytes, xsize, ysize, zsize, tablesize;
+   const byte *xoffsets, *xyoffsets;
+   int x, y, out = 0, slabbytes;
+
+   if(avail < KVXHEADERSIZE)
+      return 0;
+
+   numbytes = SwapLong(*(int32_t *)(data +  0));
+   xsize    = SwapLong(*(int32_t *)(data +  4));
+   ysize    = SwapLong(*(int32_t *)(data +  8));
+   zsize    = SwapLong(*(int32_t *)(data + 12));
+
+   if(xsize <= 0 || ysize <= 0 || zsize <= 0 || xsize > RVOXELMAXSIZE ||
+      ysize > RVOXELMAXSIZE || zsize > RVOXELMAXSIZE)
+      return 0;
+
+   tablesize = (xsize + 1) * 4 + xsize * (ysize + 1) * 2;
+   if(numbytes < 24 + tablesize || numbytes > avail - 4)
+      return 0;
+
+   // offsets are relative to the start of the x offset table
+   xoffsets  = data + KVXHEADERSIZE;
+   xyoffsets = xoffsets + (xsize + 1) * 4;
+
+   slabbytes = numbytes - 24 - tablesize;
+   R_voxelAllocMip(mip, xsize, ysize, zsize, slabbytes);
+
+   mip.xpivot = SwapLong(*(int32_t *)(data + 16)) / 256.0f;
+   mip.ypivot = SwapLong(*(int32_t *)(data + 20)) / 256.0f;
+
+   for(x = 0; x < xsize; x++)
+   {
+      int xoffset = SwapLong(*(int32_t *)(xoffsets + x * 4));
+      const byte *xyoffs = xyoffsets + x * (ysize + 1) * 2;
+
+      for(y = 0; y < ysize; y++)
+      {
+         int column = x * ysize + y;
+         int start  = xoffset + SwapUShort(*(uint16_t *)(xyoffs + y * 2));
+         int end    = xoffset + SwapUShort(*(uint16_t *)(xyoffs + y * 2 + 2));
+         byte faces = 0;
+
+         if(start < tablesize || end < start || end > numbytes - 24)
+         {
+            R_voxelFreeMip(mip);
+            return 0;
+         }
+
+         mip.columns[column] = out;
+
+         for(const byte *slab = xoffsets + start; slab < xoffsets + end; )
+         {
+            int ztop = slab[0], zlen = slab[1];
+
+            // columns may overlap in the lump, but not in our copy
+            if(slab + 3 + zlen > xoffsets + end || ztop + zlen > zsize ||
+               out + 3 + zlen > slabbytes)
+            {
+               R_voxelFreeMip(mip);
+               return 0;
+            }
+
+            mip.slabs[out++] = slab[0];
+            mip.slabs[out++] = slab[1];
+            mip.slabs[out++] = slab[2];
+            for(int z = 0; z < zlen; z++)
+               mip.slabs[out++] = remap[slab[3 + z]];
+
+            faces |= slab[2];
+            slab  += 3 + zlen;
+         }
+
+         mip.colfaces[column] = faces;
+      }
+   }
+   mip.columns[xsize * ysize] = out;
+
+   return numbytes + 4;
+}
+
+//
+// R_loadKVX
+//
+static rvoxelmodel_t *R_loadKVX(const byte *data, int lumplen)
+{
+   rvoxelmodel_t *model;
+   byte remap[256];
+   int  offset = 0, avail = lumplen - 768;
+
+   if(avail < KVXHEADERSIZE)
       return NULL;
 
-   // cache the lump
-   rover = buffer = (byte *)(wGlobalDir.cacheLumpNum(lumpnum, PU_STATIC));
+   model = ecalloctag(rvoxelmodel_t *, 1, sizeof(rvoxelmodel_t), PU_RENDERER, NULL);
 
-   // get sizes
-   xsize = SwapLong(*(int32_t *)rover);
-   rover += 4;
-   ysize = SwapLong(*(int32_t *)rover);
-   rover += 4;
-   zsize = SwapLong(*(int32_t *)rover);
-   rover += 4;
+   // the palette follows the last mip level
+   memcpy(model->palette, data + avail, 768);
+   R_voxelRemapPalette(model, remap);
+
+   while(model->nummips < RVOXELMAXMIPS && avail - offset >= KVXHEADERSIZE)
+   {
+      int size = R_loadKVXMip(model->mips[model->nummips], data + offset, 
+                              avail - offset, remap);
+      if(!size)
+         break;
 
-   voxsize = xsize*ysize*zsize;
+      offset += size;
+      ++model->nummips;
+   }
 
-   // true size test
-   if(lumplen < 12 + voxsize + 768)
+   // a bad first level means this is not a usable KVX model; any trailing
+   // levels which fail to load are simply not used
+   if(!model->nummips)
    {
-      Z_ChangeTag(buffer, PU_CACHE);
+      efree(model);
       return NULL;
    }
 
-   // create the model and its voxel buffer
-   model         = (rvoxelmodel_t *)(Z_Calloc(1,       sizeof(rvoxelmodel_t), PU_RENDERER, NULL));
-   model->voxels =          (byte *)(Z_Calloc(voxsize, sizeof(byte),          PU_RENDERER, NULL));
+   model->xsize = model->mips[0].xsize;
+   model->ysize = model->mips[0].ysize;
+   model->zsize = model->mips[0].zsize;
+
+   return model;
+}
+
+//=============================================================================
+//
+// VOX Models
+//
+// A dense three-dimensional grid of palette indices, where 255 marks an
+// empty voxel, followed by a 6-bit palette. These are converted into the
+// same slab columns used for KVX models.
+//
+
+#define VOXEMPTY 255
+
+//
+// R_voxelSolid
+//
+inline static bool R_voxelSolid(const byte *voxels, int xsize, int ysize, 
+                                int zsize, int x, int y, int z)
+{
+   if(x < 0 || y < 0 || z < 0 || x >= xsize || y >= ysize || z >= zsize)
+      return false;
+
+   return voxels[(x * ysize + y) * zsize + z] != VOXEMPTY;
+}
+
+//
+// R_voxelFaces
+//
+// Returns the exposed faces of a solid voxel.
+//
+static byte R_voxelFaces(const byte *voxels, int xsize, int ysize, int zsize,
+                         int x, int y, int z)
+{
+   byte faces = 0;
+
+   if(!R_voxelSolid(voxels, xsize, ysize, zsize, x - 1, y, z))
+      faces |= RVOXFACE_LEFT;
+   if(!R_voxelSolid(voxels, xsize, ysize, zsize, x + 1, y, z))
+      faces |= RVOXFACE_RIGHT;
+   if(!R_voxelSolid(voxels, xsize, ysize, zsize, x, y - 1, z))
+      faces |= RVOXFACE_BACK;
+   if(!R_voxelSolid(voxels, xsize, ysize, zsize, x, y + 1, z))
+      faces |= RVOXFACE_FRONT;
+   if(!R_voxelSolid(voxels, xsize, ysize, zsize, x, y, z - 1))
+      faces |= RVOXFACE_TOP;
+   if(!R_voxelSolid(voxels, xsize, ysize, zsize, x, y, z + 1))
+      faces |= RVOXFACE_BOTTOM;
+
+   return faces;
+}
+
+//
+// R_voxelColumnSlabs
+//
+// Writes the slabs of one column of a dense voxel grid to out, and returns
+// the number of bytes used. Only counts the bytes if out is NULL.
+//
+static int R_voxelColumnSlabs(const byte *voxels, int xsize, int ysize, 
+                              int zsize, int x, int y, const byte *remap, 
+                              byte *out, byte &colfaces)
+{
+   const byte *column = voxels + (x * ysize + y) * zsize;
+   byte *slab = NULL;
+   int   size = 0;
+
+   colfaces = 0;
+
+   for(int z = 0; z < zsize; z++)
+   {
+      byte faces;
+
+      // empty and fully enclosed voxels end the current slab
+      if(column[z] == VOXEMPTY || 
+         !(faces = R_voxelFaces(voxels, xsize, ysize, zsize, x, y, z)))
+      {
+         slab = NULL;
+         continue;
+      }
+
+      if(!slab)
+      {
+         slab = out + size;
+         if(out)
+         {
+            slab[0] = byte(z);
+            slab[1] = 0;
+            slab[2] = 0;
+         }
+         size += 3;
+      }
+
+      if(out)
+      {
+         out[size] = remap[column[z]];
+         slab[1]++;
+         slab[2] |= faces;
+      }
+      ++size;
+      colfaces |= faces;
+   }
+
+   return size;
+}
+
+//
+// R_loadVOX
+//
+static rvoxelmodel_t *R_loadVOX(const byte *data, int xsize, int ysize, 
+                                int zsize)
+{
+   rvoxelmodel_t *model;
+   const byte    *voxels = data + 12;
+   byte remap[256], faces;
+   int  x, y, numbytes = 0, out = 0;
 
-   model->xsize = xsize;
-   model->ysize = ysize;
-   model->zsize = zsize;
+   model = ecalloctag(rvoxelmodel_t *, 1, sizeof(rvoxelmodel_t), PU_RENDERER, NULL);
 
-   // get voxel data
-   memcpy(model->voxels, rover, voxsize);
-   rover += voxsize;
+   model->xsize   = xsize;
+   model->ysize   = ysize;
+   model->zsize   = zsize;
+   model->nummips = 1;
 
    // get original palette data
-   memcpy(model->palette, rover, 768);
+   memcpy(model->palette, voxels + xsize * ysize * zsize, 768);
+   R_voxelRemapPalette(model, remap);
 
-   // transform palette data into 0-255 range
-   // TODO: verify color component order
-   for(i = 0; i < 768; i++)
-      model->palette[i] <<= 2;
+   // size the slab buffer, then fill it
+   for(x = 0; x < xsize; x++)
+   {
+      for(y = 0; y < ysize; y++)
+      {
+         numbytes += R_voxelColumnSlabs(voxels, xsize, ysize, zsize, x, y, 
+                                        remap, NULL, faces);
+      }
+   }
+
+   rvoxelmip_t &mip = model->mips[0];
+   R_voxelAllocMip(mip, xsize, ysize, zsize, numbytes);
+
+   // pivot around the center of the base
+   mip.xpivot = xsize / 2.0f;
+   mip.ypivot = ysize / 2.0f;
+
+   for(x = 0; x < xsize; x++)
+   {
+      for(y = 0; y < ysize; y++)
+      {
+         int column = x * ysize + y;
+
+         mip.columns[column] = out;
+         out += R_voxelColumnSlabs(voxels, xsize, ysize, zsize, x, y, remap,
+                                   mip.slabs + out, mip.colfaces[column]);
+      }
+   }
+   mip.columns[xsize * ysize] = out;
+
+   return model;
+}
+
+//=============================================================================
+//
+// Loading
+//
+
+//
+// R_LoadVoxelResource
+//
+// Loads a .kvx or .vox format voxel model into an rvoxelmodel_t structure.
+// Returns NULL if the lump is not a valid model.
+//
+rvoxelmodel_t *R_LoadVoxelResource(int lumpnum)
+{
+   rvoxelmodel_t *model = NULL;
+   byte *buffer = NULL;
+   int lumplen  = W_LumpLength(lumpnum);
+   int xsize, ysize, zsize;
+
+   // minimum size test
+   if(lumplen < 12 + 768)
+      return NULL;
+
+   // cache the lump
+   buffer = (byte *)(wGlobalDir.cacheLumpNum(lumpnum, PU_STATIC));
+
+   // VOX files are exactly the size of their grid plus a palette
+   xsize = SwapLong(*(int32_t *)(buffer + 0));
+   ysize = SwapLong(*(int32_t *)(buffer + 4));
+   zsize = SwapLong(*(int32_t *)(buffer + 8));
+
+   if(xsize > 0 && ysize > 0 && zsize > 0 && xsize <= RVOXELMAXSIZE &&
+      ysize <= RVOXELMAXSIZE && zsize <= RVOXELMAXSIZE &&
+      lumplen == 12 + xsize * ysize * zsize + 768)
+   {
+      model = R_loadVOX(buffer, xsize, ysize, zsize);
+   }
+   else
+      model = R_loadKVX(buffer, lumplen);
 
-   // TODO: run V_FindBestColor to create translated palette?
+   if(model)
+      R_voxelSetRadius(model);
 
    // done with lump
    Z_ChangeTag(buffer, PU_CACHE);
@@ -96,6 +451,47 @@ rvoxelmodel_t *R_LoadVoxelResource(int lumpnum)
    return model;
 }
 
-// EOF
+//
+// R_InitVoxels
+//
+// Attaches voxel models to sprite frames. A model in the voxels namespace
+// named after a sprite and frame (ie. "BON1A") replaces that frame; one
+// named after the sprite alone replaces every frame without its own model.
+//
+void R_InitVoxels(char **namelist)
+{
+   for(int i = 0; i < numsprites; i++)
+   {
+      spritedef_t   *sprdef    = &sprites[i];
+      rvoxelmodel_t *allframes = NULL;
+      char name[9];
+      int  lumpnum;
+
+      if(!sprdef->spriteframes)
+         continue;
+
+      strncpy(name, namelist[i], 4);
+      name[4] = '\0';
+
+      if((lumpnum = wGlobalDir.checkNumForName(name, lumpinfo_t::ns_voxels)) >= 0)
+         allframes = R_LoadVoxelResource(lumpnum);
+
+      for(int frame = 0; frame < sprdef->numframes; frame++)
+      {
+         spriteframe_t *sprframe = &sprdef->spriteframes[frame];
 
+         name[4] = char('A' + frame);
+         name[5] = '\0';
+
+         sprframe->voxel = allframes;
+         if((lumpnum = wGlobalDir.checkNumForName(name, lumpinfo_t::ns_voxels)) >= 0)
+         {
+            if(rvoxelmodel_t *model = R_LoadVoxelResource(lumpnum))
+               sprframe->voxel = model;
+         }
+      }
+   }
+}
+
+// EOF
 
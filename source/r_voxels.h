@@ -22,21 +22,65 @@
 //--------------------------------------------------------------------------
 //
 // DESCRIPTION:
+//   Voxel models, used by the renderer in place of sprite frames.
 //
 //-----------------------------------------------------------------------------
 
 #ifndef R_VOXELS_H__
 #define R_VOXELS_H__
 
-typedef struct rvoxelmodel_s
+// largest dimension accepted for a voxel model; KVX slabs store z in a byte
+#define RVOXELMAXSIZE 256
+
+// maximum number of mip levels kept per model (KVX files usually have 5)
+#define RVOXELMAXMIPS 5
+
+// Face visibility bits of a slab. A bit is set when the corresponding face
+// of at least one voxel in the slab is exposed to empty space.
+enum
+{
+   RVOXFACE_LEFT   = 0x01, // -x
+   RVOXFACE_RIGHT  = 0x02, // +x
+   RVOXFACE_BACK   = 0x04, // -y
+   RVOXFACE_FRONT  = 0x08, // +y
+   RVOXFACE_TOP    = 0x10, // -z
+   RVOXFACE_BOTTOM = 0x20, // +z
+   RVOXFACE_SIDES  = 0x0f
+};
+
+//
+// rvoxelmip_t
+//
+// One level of detail of a voxel model, stored as columns of slabs. Each
+// slab is a run of visible voxels along z, laid out as:
+//   byte ztop, zlength, faces, colors[zlength]
+// Empty voxels and voxels enclosed on all sides are not stored at all.
+//
+struct rvoxelmip_t
 {
-   int  xsize, ysize, zsize; // dimensions
-   byte *voxels;             // three-dimensional voxel buffer
-   byte palette[768];        // original palette
-} rvoxelmodel_t;
+   int   xsize, ysize, zsize;    // dimensions of this level
+   float xpivot, ypivot;         // rotation center, in voxels
+   int  *columns;                // xsize*ysize+1 offsets into slabs, x-major
+   byte *colfaces;               // union of slab face bits for each column
+   byte *slabs;                  // slab data, colors already in game palette
+};
+
+//
+// rvoxelmodel_t
+//
+struct rvoxelmodel_t
+{
+   int  xsize, ysize, zsize;     // dimensions of the most detailed level
+   float radius;                 // horizontal extent from the pivot, in voxels
+   int  nummips;                 // number of valid levels in mips
+   rvoxelmip_t mips[RVOXELMAXMIPS];
+   byte palette[768];            // original palette
+};
+
+rvoxelmodel_t *R_LoadVoxelResource(int lumpnum);
+void R_InitVoxels(char **namelist);
 
 #endif
 
 // EOF
 
-
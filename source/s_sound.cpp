@@ -114,6 +114,9 @@ static bool mus_paused;
 // music currently being played
 static musicinfo_t *mus_playing;
 
+// music loaded ahead of time by S_PrefetchMusic
+static musicinfo_t *mus_prefetched;
+
 // following is set
 //  by the defaults code in M_misc:
 // number of channels available
@@ -160,6 +163,53 @@ static void S_StopChannel(int cnum)
    }
 }
 
+//
+// S_pointSector
+//
+// Sector a sound source or listener is in. Mobjs already keep track of
+// their subsector, so the BSP only needs to be searched for other kinds of
+// sources.
+//
+static sector_t *S_pointSector(const PointThinker *pt)
+{
+   const Mobj *mo = thinker_cast<Mobj *>(const_cast<PointThinker *>(pt));
+
+   if(mo && mo->subsector)
+      return mo->subsector->sector;
+
+   return R_PointInSubsector(pt->x, pt->y)->sector;
+}
+
+// Cached listener location, so that an external camera's subsector is only
+// looked up again after it moves.
+static fixed_t      s_earx;
+static fixed_t      s_eary;
+static subsector_t *s_earsubsec;
+static subsector_t *s_earsubsecs; // subsectors array s_earsubsec belongs to
+
+//
+// S_earSector
+//
+// Get the sector the listener is in. If there's no external camera, the
+// listener is the mobj itself.
+//
+static sector_t *S_earSector(const camera_t *cam, const Mobj *listener)
+{
+   if(!camera && listener && listener->subsector)
+      return listener->subsector->sector;
+
+   if(!s_earsubsec || s_earsubsecs != subsectors ||
+      cam->x != s_earx || cam->y != s_eary)
+   {
+      s_earsubsec  = R_PointInSubsector(cam->x, cam->y);
+      s_earsubsecs = subsectors;
+      s_earx       = cam->x;
+      s_eary       = cam->y;
+   }
+
+   return s_earsubsec->sector;
+}
+
 //
 // S_CheckSectorKill
 //
@@ -176,8 +226,7 @@ static bool S_CheckSectorKill(const sector_t *earsec, const PointThinker *src)
          return true;
       
       // source in a killed-sound sector?
-      if(src &&
-         R_PointInSubsector(src->x, src->y)->sector->flags & SECF_KILLSOUND)
+      if(src && S_pointSector(src)->flags & SECF_KILLSOUND)
          return true;
    }
 
@@ -555,7 +604,7 @@ void S_StartSfxInfo(const soundparams_t &params)
          }
       }
 
-      earsec = R_PointInSubsector(playercam.x, playercam.y)->sector;
+      earsec = S_earSector(&playercam, players[displayplayer].mo);
    }
 
    // haleyjd 09/29/06: check for sector sound kill here.
@@ -849,14 +898,28 @@ void S_ResumeSound()
 // Currently active reverberation environment
 static ereverb_t *s_currentEnvironment;
 
+// Listener sector the environment was last chosen for
+static sector_t *s_environmentSector;
+static bool      s_environmentValid;
+
 //
 // S_updateEnvironment
 //
-// Update the active sound environment.
+// Update the active sound environment. Nothing needs to be done unless the
+// listener has moved into a different sector.
 //
 static void S_updateEnvironment(sector_t *earsec)
 {
    ereverb_t *reverb;
+
+   if(gamestate != GS_LEVEL)
+      earsec = NULL;
+
+   if(s_environmentValid && earsec == s_environmentSector)
+      return;
+
+   s_environmentSector = earsec;
+   s_environmentValid  = true;
    
    if(!earsec || gamestate != GS_LEVEL)
       reverb = E_GetDefaultReverb();
@@ -900,12 +963,17 @@ void S_UpdateSounds(const Mobj *listener)
          playercam.angle = listener->angle;
          playercam.groupid = listener->groupid;
       }
-      earsec = R_PointInSubsector(playercam.x, playercam.y)->sector;
+      earsec = S_earSector(&playercam, listener);
    }
 
    // update sound environment
    S_updateEnvironment(earsec);
 
+   // if the listener is in a killed-sound sector, every sound that would be
+   // adjusted for position is stopped
+   bool earkilled = (listener && gamestate == GS_LEVEL && earsec && 
+                     earsec->flags & SECF_KILLSOUND);
+
    // now update each individual channel
    for(int cnum = 0; cnum < numChannels; cnum++)
    {
@@ -942,7 +1010,7 @@ void S_UpdateSounds(const Mobj *listener)
          // inappropriately. The only reason he changed this was to get to
          // the code in S_AdjustSoundParams that checks for sector sound
          // killing. We do that here now instead.
-         if(listener && S_CheckSectorKill(earsec, c->origin))
+         if(earkilled || (listener && S_CheckSectorKill(NULL, c->origin)))
             S_StopChannel(cnum);
          else if(c->origin && (PointThinker *)listener != c->origin) // killough 3/20/98
          {
@@ -1011,6 +1079,10 @@ void S_StopSounds(bool killall)
       for(cnum = 0; cnum < numChannels; ++cnum)
          if(channels[cnum].sfxinfo && (killall || channels[cnum].origin))
             S_StopChannel(cnum);
+
+   // the level or the sound zones may be about to change, so choose the
+   // environment again on the next update
+   s_environmentValid = false;
 }
 
 //
@@ -1117,13 +1189,32 @@ void S_SetMusicVolume(int volume)
    snd_MusicVolume = volume;
 }
 
+//
+// S_musicLumpNum
+//
+// Finds the lump holding a song, or returns -1.
+//
+static int S_musicLumpNum(const musicinfo_t *music)
+{
+   char namebuf[16];
+
+   if(music->prefix)
+   {
+      psnprintf(namebuf, sizeof(namebuf), "%s%s", 
+                GameModeInfo->musPrefix, music->name);
+   }
+   else
+      psnprintf(namebuf, sizeof(namebuf), "%s", music->name);
+
+   return W_CheckNumForName(namebuf);
+}
+
 //
 // S_ChangeMusic
 //
 void S_ChangeMusic(musicinfo_t *music, int looping)
 {
    int lumpnum;
-   char namebuf[16];
 
    //jff 1/22/98 return if music is not enabled
    if(!mus_card || nomusicparm)
@@ -1136,15 +1227,7 @@ void S_ChangeMusic(musicinfo_t *music, int looping)
    // shutdown old music
    S_StopMusic();
 
-   if(music->prefix)
-   {
-      psnprintf(namebuf, sizeof(namebuf), "%s%s", 
-                GameModeInfo->musPrefix, music->name);
-   }
-   else
-      psnprintf(namebuf, sizeof(namebuf), "%s", music->name);
-
-   if((lumpnum = W_CheckNumForName(namebuf)) == -1)
+   if((lumpnum = S_musicLumpNum(music)) == -1)
    {
       doom_printf(FC_ERROR "bad music name '%s'\n", music->name);
       return;
@@ -1156,6 +1239,15 @@ void S_ChangeMusic(musicinfo_t *music, int looping)
 
    music->data = wGlobalDir.cacheLumpNum(lumpnum, PU_STATIC);   
 
+   // a prefetched copy of this lump now belongs to the playing song; the
+   // driver picks up its loaded data when the song is registered
+   if(mus_prefetched && mus_prefetched->data == music->data)
+   {
+      if(mus_prefetched != music)
+         mus_prefetched->data = NULL;
+      mus_prefetched = NULL;
+   }
+
    if(music->data)
    {
       music->handle = I_RegisterSong(music->data, W_LumpLength(lumpnum));
@@ -1253,6 +1345,74 @@ void S_StopMusic()
    mus_playing = NULL;
 }
 
+//
+// S_PrefetchMusic
+//
+// Loads a song that is expected to be played soon, such as the next level's
+// music, so that starting it later doesn't stall. Only one song is held; a
+// new prefetch replaces the last.
+//
+void S_PrefetchMusic(musicinfo_t *music)
+{
+   int lumpnum;
+   void *data;
+
+   if(!mus_card || nomusicparm || !music)
+      return;
+
+   if(music == mus_playing || music == mus_prefetched)
+      return;
+
+   if((lumpnum = S_musicLumpNum(music)) == -1)
+      return;
+
+   data = wGlobalDir.cacheLumpNum(lumpnum, PU_STATIC);
+
+   // already playing or held under another name?
+   if((mus_playing && mus_playing->data == data) ||
+      (mus_prefetched && mus_prefetched->data == data))
+      return;
+
+   // the driver drops any earlier prefetch before this returns
+   if(!I_PrefetchSong(data, W_LumpLength(lumpnum)))
+   {
+      Z_Free(data);
+      return;
+   }
+
+   if(mus_prefetched)
+   {
+      Z_Free(mus_prefetched->data);
+      mus_prefetched->data = NULL;
+   }
+
+   music->data    = data;
+   mus_prefetched = music;
+}
+
+//
+// S_PrefetchLevelMusic
+//
+// Prefetches the music S_Start is expected to choose for the given map.
+//
+void S_PrefetchLevelMusic(const char *mapname, int episode, int map)
+{
+   const char *name;
+
+   if(!mus_card || nomusicparm)
+      return;
+
+   if(*(name = P_LevelMusicName(mapname, map)))
+      S_PrefetchMusic(S_MusicForName(name));
+   else if(!s_randmusic) // random picks can't be known in advance
+   {
+      int mnum = GameModeInfo->MusicForMap(episode, map);
+
+      if(mnum > GameModeInfo->musMin && mnum < GameModeInfo->numMusic)
+         S_PrefetchMusic(&GameModeInfo->s_music[mnum]);
+   }
+}
+
 //=============================================================================
 //
 // S_Start Music Handlers
@@ -1267,7 +1427,7 @@ void S_StopMusic()
 // original episodes and the addition of episode 4, which is all 
 // over the place.
 //
-int S_MusicForMapDoom()
+int S_MusicForMapDoom(int episode, int map)
 {
    static const int spmus[] =     // Song - Who? - Where?
    {
@@ -1282,8 +1442,8 @@ int S_MusicForMapDoom()
       mus_e1m9      // Tim          e4m9
    };
 
-   int episode = eclamp(gameepisode, 1, 4);
-   int map     = eclamp(gamemap,     1, 9);
+   episode = eclamp(episode, 1, 4);
+   map     = eclamp(map,     1, 9);
             
    // sf: simplified
    return episode < 4 ? mus_e1m1 + (episode-1)*9 + map-1 : spmus[map-1];
@@ -1294,9 +1454,9 @@ int S_MusicForMapDoom()
 //
 // Drastically simpler.
 //
-int S_MusicForMapDoom2()
+int S_MusicForMapDoom2(int episode, int map)
 {
-   int map = eclamp(gamemap, 1, 35);
+   map = eclamp(map, 1, 35);
    return (mus_runnin + map - 1);
 }
 
@@ -1305,11 +1465,11 @@ int S_MusicForMapDoom2()
 //
 // Also simple, thanks to H_Mus_Matrix, which is my own invention.
 //
-int S_MusicForMapHtic()
+int S_MusicForMapHtic(int episode, int map)
 {
    // ensure bounds just for safety
-   int gep = eclamp(gameepisode, 1, 6);
-   int gmp = eclamp(gamemap,     1, 9);
+   int gep = eclamp(episode, 1, 6);
+   int gmp = eclamp(map,     1, 9);
      
    return H_Mus_Matrix[gep - 1][gmp - 1];
 }
@@ -1349,7 +1509,7 @@ void S_Start()
       if(idmusnum != -1)
          mnum = idmusnum; //jff 3/17/98 reload IDMUS music if not -1
       else
-         mnum = GameModeInfo->MusicForMap();
+         mnum = GameModeInfo->MusicForMap(gameepisode, gamemap);
          
       // start music
       S_ChangeMusicNum(mnum, true);
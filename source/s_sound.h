@@ -122,6 +122,10 @@ void S_ChangeMusicNum(int music_id, int looping);
 void S_ChangeMusicName(const char *name, int looping);
 void S_ChangeMusic(musicinfo_t *music, int looping);
 
+// Load music ahead of playing it
+void S_PrefetchMusic(musicinfo_t *music);
+void S_PrefetchLevelMusic(const char *mapname, int episode, int map);
+
 // Stops the music fer sure.
 void S_StopMusic(void);
 void S_StopSounds(bool killall);
@@ -170,9 +174,9 @@ extern bool s_randmusic;
 //
 // GameModeInfo music routines
 //
-int S_MusicForMapDoom();
-int S_MusicForMapDoom2();
-int S_MusicForMapHtic();
+int S_MusicForMapDoom(int episode, int map);
+int S_MusicForMapDoom2(int episode, int map);
+int S_MusicForMapHtic(int episode, int map);
 int S_DoomMusicCheat(const char *buf);
 int S_Doom2MusicCheat(const char *buf);
 int S_HereticMusicCheat(const char *buf);
@@ -475,6 +475,8 @@ i_sounddriver_t i_pcsound_driver =
    I_PCSSoundIsPlaying,    // SoundIsPlaying
    I_PCSUpdateSoundParams, // UpdateSoundParams
    NULL,                   // UpdateEQParams
+   NULL,                   // StartOfflineMix
+   NULL,                   // MixOffline
 };
 
 // EOF
@@ -41,6 +41,7 @@
 
 // Local driver header
 #include "i_sdlgl2d.h"
+#include "i_sdlpixels.h"
 
 // GL module headers
 #include "../gl/gl_primitives.h"
@@ -156,20 +157,9 @@ static void GL2D_setupVertexArray(GLfloat x, GLfloat y, GLfloat w, GLfloat h,
 //
 void SDLGL2DVideoDriver::DrawPixels(void *buffer, unsigned int destwidth)
 {
-   Uint32 *fb = (Uint32 *)buffer;
-
-   for(int y = 0; y < screen->h; y++)
-   {
-      byte   *src  = (byte *)screen->pixels + y * screen->pitch;
-      Uint32 *dest = fb + y * destwidth;
-
-      for(int x = 0; x < screen->w - bump; x++)
-      {
-         *dest = RGB8to32[*src];
-         ++src;
-         ++dest;
-      }
-   }
+   I_SDLExpandPixels32((byte *)screen->pixels, screen->pitch, 
+                       buffer, int(destwidth * sizeof(Uint32)),
+                       screen->w - bump, screen->h, RGB8to32);
 }
 
 //
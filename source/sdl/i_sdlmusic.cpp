@@ -45,6 +45,7 @@
 #include "../d_main.h"
 #include "../v_misc.h"
 #include "../m_argv.h"
+#include "../m_jobs.h"
 #include "../d_gi.h"
 #include "../s_sound.h"
 #include "../mn_engin.h"
@@ -188,7 +189,59 @@ static void *music_block = NULL;
 // Macro to make code more readable
 #define CHECK_MUSIC(h) ((h) && music != NULL)
 
+//
+// Song loading
+//
+// Converting a MUS to MIDI can take long enough to hitch the game, so it is
+// done by a job, which also loads SPC songs. I_SDLRegisterSong returns at once
+// and the song is opened and started from I_SDLUpdateMusic when the job is
+// done; play and pause requests made in between are remembered until then.
+// SDL_mixer and the MIDI RPC server are only driven from the main thread.
+//
+// There are two load slots: the registered song, and one prefetched ahead of
+// time, such as the next level's music during the intermission. Registering
+// the prefetched data takes over its slot, so there is usually nothing left to
+// wait for. Once its job is done, a prefetched digital song (OGG, MP3, and so
+// on) is also opened with SDL_mixer from I_SDLUpdateMusic while the current
+// song plays. MIDI is still opened after the previous song has been halted,
+// since the MIDI players can't be relied on to hold two songs at once.
+//
+// The job only touches the song data it was given and its slot; its buffers
+// come from the C allocator (see mmus2mid.cpp), never the zone heap.
+//
+
+struct songload_t
+{
+   void  *data;     // song lump, owned by the sound code; NULL if unused
+   int    size;
+   job_t *job;      // conversion job, until it has been waited on
+   int    err;      // mmus2mid error, if conversion failed
+   void  *mididata; // what to hand to the player: data, or block
+   int    midisize;
+   bool   isMIDI;
+   void  *block;    // MIDI converted from MUS, to be free()'d
+
+   bool       opened; // I_SDLOpenSong has been called
+   Mix_Music *music;
+   SDL_RWops *rw;
+
+#ifdef HAVE_SPCLIB
+   SNES_SPC   *spc;   // set by the job if the song is a SPC
+   SPC_Filter *filter;
+#endif
+};
+
+static songload_t songloads[2];
+static int        cursong;    // index of the registered song's slot
+
+// Requests made while the registered song is still loading
+static bool songpending;
+static bool pendingplay;
+static bool pendinglooping;
+static bool pendingpaused;
+
 static void I_SDLUnRegisterSong(int);
+static void I_SDLFreeSongLoad(songload_t *);
 
 //
 // I_SDLShutdownMusic
@@ -198,6 +251,7 @@ static void I_SDLUnRegisterSong(int);
 static void I_SDLShutdownMusic(void)
 {
    I_SDLUnRegisterSong(1);
+   I_SDLFreeSongLoad(&songloads[cursong ^ 1]);
 
 #ifdef EE_FEATURE_MIDIRPC
    I_MidiRPCClientShutDown();
@@ -267,6 +321,13 @@ static int I_SDLInitMusic(void)
 //
 static void I_SDLPlaySong(int handle, int looping)
 {
+   if(songpending)
+   {
+      pendingplay    = true;
+      pendinglooping = !!looping;
+      return;
+   }
+
 #ifdef HAVE_SPCLIB
    // if a SPC is set up, play it.
    if(snes_spc)
@@ -314,6 +375,12 @@ static int paused_midi_volume;
 //
 static void I_SDLPauseSong(int handle)
 {
+   if(songpending)
+   {
+      pendingpaused = true;
+      return;
+   }
+
 #ifdef EE_FEATURE_MIDIRPC
    if(serverMidiPlaying)
    {
@@ -341,6 +408,12 @@ static void I_SDLPauseSong(int handle)
 //
 static void I_SDLResumeSong(int handle)
 {
+   if(songpending)
+   {
+      pendingpaused = false;
+      return;
+   }
+
 #ifdef EE_FEATURE_MIDIRPC
    if(serverMidiPlaying)
    {
@@ -364,6 +437,8 @@ static void I_SDLResumeSong(int handle)
 //
 static void I_SDLStopSong(int handle)
 {
+   pendingplay = false;
+
 #ifdef EE_FEATURE_MIDIRPC
    if(serverMidiPlaying)
    {
@@ -386,6 +461,14 @@ static void I_SDLStopSong(int handle)
 //
 static void I_SDLUnRegisterSong(int handle)
 {
+   // drop a song that never finished loading
+   if(songpending)
+   {
+      I_SDLFreeSongLoad(&songloads[cursong]);
+      songpending = false;
+      pendingplay = false;
+   }
+
 #ifdef EE_FEATURE_MIDIRPC
    if(serverMidiPlaying)
    {
@@ -408,7 +491,7 @@ static void I_SDLUnRegisterSong(int handle)
    // Free music block
    if(music_block != NULL)
    {
-      efree(music_block);
+      free(music_block);
       music_block = NULL;
    }
 
@@ -430,114 +513,223 @@ static void I_SDLUnRegisterSong(int handle)
 
 #ifdef HAVE_SPCLIB
 //
-// I_TryLoadSPC
+// I_SDLLoadSPC
 //
-// haleyjd 04/02/08: Tries to load the music data as a SPC file.
+// haleyjd 04/02/08: Tries to load the music data as a SPC file. Called from
+// the conversion job, so the SPC objects are kept in the slot.
 //
-static int I_TryLoadSPC(void *data, int size)
+static void I_SDLLoadSPC(songload_t *load)
 {
-   spc_err_t err;
-
-#ifdef RANGECHECK
-   if(snes_spc)
-      I_Error("I_TryLoadSPC: snes_spc object displaced\n");
-#endif
+   SNES_SPC   *spc;
+   SPC_Filter *filter;
 
-   snes_spc = spc_new();
-
-   if(snes_spc == NULL)
-   {
-      doom_printf("Failed to allocate snes_spc");
-      return -1;
-   }
+   if(!(spc = spc_new()))
+      return;
    
-   if((err = spc_load_spc(snes_spc, data, (long)size)))
+   if(spc_load_spc(spc, load->data, (long)load->size))
    {
-      spc_delete(snes_spc);
-      snes_spc = NULL;
-      return -1;
+      spc_delete(spc);
+      return;
    }
 
    // It is a SPC, so set everything up for SPC playing
-   spc_filter = spc_filter_new();
-
-   if(spc_filter == NULL)
+   if(!(filter = spc_filter_new()))
    {
-      doom_printf("Failed to allocate spc_filter");
-      spc_delete(snes_spc);
-      snes_spc = NULL;
-      return -1;
+      spc_delete(spc);
+      return;
    }
 
    // clear echo buffer garbage, init filter
-   spc_clear_echo(snes_spc);
-   spc_filter_clear(spc_filter);
-
-   // set initial gain and bass parameters
-   spc_filter_set_gain(spc_filter, snd_MusicVolume * (256 * spc_preamp) / 15);
-   spc_filter_set_bass(spc_filter, spc_bass_boost);
+   spc_clear_echo(spc);
+   spc_filter_clear(filter);
 
-   return 0;
+   load->spc    = spc;
+   load->filter = filter;
 }
 #endif
 
 //
-// I_SDLRegisterSong
+// I_SDLSongToMIDI
 //
-static int I_SDLRegisterSong(void *data, int size)
+// Checks for MIDI or MUS format, and converts a MUS to MIDI. Returns the data
+// to hand to the player, adjusting size to match, or NULL if the conversion
+// failed.
+//
+static void *I_SDLSongToMIDI(songload_t *load, int &size, bool &isMIDI)
 {
-   int  err;
-   bool isMIDI = false;
-   bool isMUS  = false;
+   void *data = load->data;
 
-   if(music != NULL)
-      I_UnRegisterSong(1);
+   isMIDI = false;
 
-   // Check for MIDI or MUS format first:
    if(size >= 14)
    {
       if(!memcmp(data, "MThd", 4)) // Is it a MIDI?
          isMIDI = true;
       else if(mmuscheckformat((byte *)data, size)) // Is it a MUS?
-         isMUS = true;
+      {
+         MIDI mididata;
+         UBYTE *mid;
+         int midlen;
+
+         memset(&mididata, 0, sizeof(MIDI));
+
+         // Hurrah! Let's make it a mid and give it to SDL_mixer
+         if(!(load->err = mmus2mid((byte *)data, (size_t)size, &mididata, 89, 0)))
+            load->err = MIDIToMidi(&mididata, &mid, &midlen);
+
+         FreeTracks(&mididata);
+
+         if(load->err)
+            return NULL;
+
+         // save memory block to free when unregistering
+         load->block = mid;
+
+         data   = mid;
+         size   = midlen;
+         isMIDI = true;   // now it's a MIDI.
+      }
    }
 
-   // If it's a MUS, convert it to MIDI now.
-   if(isMUS)
+   return data;
+}
+
+//
+// I_SDLConvertSong
+//
+// Job function doing the slow part of registering a song.
+//
+static void I_SDLConvertSong(void *data)
+{
+   songload_t *load = static_cast<songload_t *>(data);
+
+   load->midisize = load->size;
+   load->mididata = I_SDLSongToMIDI(load, load->midisize, load->isMIDI);
+
+#ifdef HAVE_SPCLIB
+   if(load->mididata && !load->isMIDI)
+      I_SDLLoadSPC(load);
+#endif
+}
+
+//
+// I_SDLStartSongLoad
+//
+// Converts the song in a job, or in place when there are no job workers to
+// run it in the background.
+//
+static void I_SDLStartSongLoad(songload_t *load, void *data, int size)
+{
+   load->data = data;
+   load->size = size;
+
+   if(M_NumJobWorkers() > 0)
    {
-      MIDI mididata;
-      UBYTE *mid;
-      int midlen;
+      load->job = M_NewJob("I_SDLConvertSong", I_SDLConvertSong, load);
+      M_SubmitJob(load->job);
+   }
+   else
+      I_SDLConvertSong(load);
+}
 
-      rw = NULL;
-      memset(&mididata, 0, sizeof(MIDI));
+//
+// I_SDLSongLoaded
+//
+// Returns true if the slot's conversion is done, waiting for it if asked to.
+//
+static bool I_SDLSongLoaded(songload_t *load, bool wait)
+{
+   if(load->job)
+   {
+      if(!wait && !M_JobDone(load->job))
+         return false;
 
-      if((err = mmus2mid((byte *)data, (size_t)size, &mididata, 89, 0)))
-      {
-         doom_printf("Error loading music: %d", err);
-         return 0;
-      }
+      M_WaitJob(load->job);
+      load->job = NULL;
+   }
 
-      // Hurrah! Let's make it a mid and give it to SDL_mixer
-      MIDIToMidi(&mididata, &mid, &midlen);
+   return true;
+}
 
-      // save memory block to free when unregistering
-      music_block = mid;
+//
+// I_SDLFreeSongLoad
+//
+// Waits for a slot's conversion to finish, then throws its results away.
+//
+static void I_SDLFreeSongLoad(songload_t *load)
+{
+   if(!load->data)
+      return;
 
-      data   = mid;
-      size   = midlen;
-      isMIDI = true;   // now it's a MIDI.
+   I_SDLSongLoaded(load, true);
+
+   if(load->music)
+      Mix_FreeMusic(load->music);
+
+#ifdef HAVE_SPCLIB
+   if(load->spc)
+   {
+      spc_delete(load->spc);
+      spc_filter_delete(load->filter);
    }
-   
+#endif
+
+   if(load->block)
+      free(load->block);
+
+   memset(load, 0, sizeof(*load));
+}
+
+//
+// I_SDLOpenSong
+//
+// Opens a converted slot's song with SDL_mixer, unless it is a SPC.
+//
+static void I_SDLOpenSong(songload_t *load)
+{
+   load->opened = true;
+
+   if(!load->mididata)
+      return;
+
+#ifdef HAVE_SPCLIB
+   if(load->spc)
+      return;
+#endif
+
+   load->rw    = SDL_RWFromMem(load->mididata, load->midisize);
+   load->music = Mix_LoadMUS_RW(load->rw);
+}
+
+//
+// I_SDLFinishSong
+//
+// Opens a converted slot's song and makes it the current one. The previous
+// song must already have been unregistered. Returns 0 if it can't be played.
+//
+static int I_SDLFinishSong(songload_t *load)
+{
+   songload_t done = *load;
+
+   memset(load, 0, sizeof(*load));
+
+   music_block = done.block;
+
+   if(!done.mididata)
+   {
+      doom_printf("Error loading music: %d", done.err);
+      return 0;
+   }
+
 #ifdef EE_FEATURE_MIDIRPC
    // Check for option to invoke RPC server if isMIDI
-   if(isMIDI && haveMidiServer)
+   if(done.isMIDI && haveMidiServer)
    {
       // Init client if not yet started
       if(!haveMidiClient)
          haveMidiClient = I_MidiRPCInitClient();
 
-      if(I_MidiRPCRegisterSong(data, size))
+      if(I_MidiRPCRegisterSong(done.mididata, done.midisize))
       {
          serverMidiPlaying = true;
          return 1; // server will play this song.
@@ -545,22 +737,107 @@ static int I_SDLRegisterSong(void *data, int size)
    }
 #endif
 
-   // Try SDL_mixer locally
-   rw    = SDL_RWFromMem(data, size);
-   music = Mix_LoadMUS_RW(rw);
-
 #ifdef HAVE_SPCLIB
-   if(!music)
+   // Is it a SPC?
+   if(done.spc)
    {
-      // Is it a SPC?
-      if(!(err = I_TryLoadSPC(data, size)))
-         return 1;
+      snes_spc   = done.spc;
+      spc_filter = done.filter;
+
+      // set initial gain and bass parameters
+      spc_filter_set_gain(spc_filter, snd_MusicVolume * (256 * spc_preamp) / 15);
+      spc_filter_set_bass(spc_filter, spc_bass_boost);
+      return 1;
    }
 #endif
 
+   // Try SDL_mixer locally, unless it was opened ahead of time
+   if(!done.opened)
+      I_SDLOpenSong(&done);
+
+   rw    = done.rw;
+   music = done.music;
+
    return music != NULL;
 }
 
+//
+// I_SDLRegisterSong
+//
+static int I_SDLRegisterSong(void *data, int size)
+{
+   songload_t *next = &songloads[cursong ^ 1];
+
+   if(music != NULL || songpending)
+      I_UnRegisterSong(1);
+
+   // it was prefetched; take over its slot
+   if(next->data == data)
+      cursong ^= 1;
+   else
+      I_SDLStartSongLoad(&songloads[cursong], data, size);
+
+   if(I_SDLSongLoaded(&songloads[cursong], false))
+      return I_SDLFinishSong(&songloads[cursong]);
+
+   songpending   = true;
+   pendingplay   = false;
+   pendingpaused = false;
+
+   return 1;
+}
+
+//
+// I_SDLPrefetchSong
+//
+// Starts converting song data that is expected to be registered next. With
+// no job workers the conversion is done right away.
+//
+static int I_SDLPrefetchSong(void *data, int size)
+{
+   songload_t *next = &songloads[cursong ^ 1];
+
+   if(next->data)
+   {
+      if(next->data == data)
+         return 1;
+      I_SDLFreeSongLoad(next);
+   }
+
+   I_SDLStartSongLoad(next, data, size);
+
+   return 1;
+}
+
+//
+// I_SDLUpdateMusic
+//
+// Opens and starts the registered song once its conversion is done, and
+// opens a prefetched digital song once its job is done.
+//
+static void I_SDLUpdateMusic(void)
+{
+   songload_t *next = &songloads[cursong ^ 1];
+
+   if(next->data && !next->opened && I_SDLSongLoaded(next, false) &&
+      !next->isMIDI)
+      I_SDLOpenSong(next);
+
+   if(!songpending || !I_SDLSongLoaded(&songloads[cursong], false))
+      return;
+
+   songpending = false;
+
+   if(I_SDLFinishSong(&songloads[cursong]) && pendingplay)
+   {
+      I_SDLPlaySong(1, pendinglooping);
+      I_SDLSetMusicVolume(snd_MusicVolume);
+
+      if(pendingpaused)
+         I_SDLPauseSong(1);
+   }
+}
+
 //
 // I_SDLQrySongPlaying
 //
@@ -572,9 +849,9 @@ static int I_SDLQrySongPlaying(int handle)
    // julian: and is that a reason not to code it?!?
    // haleyjd: ::shrugs::
 #ifdef HAVE_SPCLIB
-   return CHECK_MUSIC(handle) || snes_spc != NULL;
+   return songpending || CHECK_MUSIC(handle) || snes_spc != NULL;
 #else
-   return CHECK_MUSIC(handle);
+   return songpending || CHECK_MUSIC(handle);
 #endif
 }
 
@@ -590,6 +867,8 @@ i_musicdriver_t i_sdlmusicdriver =
    I_SDLStopSong,       // StopSong
    I_SDLUnRegisterSong, // UnRegisterSong
    I_SDLQrySongPlaying, // QrySongPlaying
+   I_SDLUpdateMusic,    // UpdateMusic
+   I_SDLPrefetchSong,   // PrefetchSong
 };
 
 // EOF
@@ -0,0 +1,115 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:  
+//    Conversion of the 8-bit game screen to 32-bit pixels for presentation.
+//    Large screens are split into bands of rows converted by jobs.
+//
+//-----------------------------------------------------------------------------
+
+#include "SDL.h"
+
+#include "../z_zone.h"
+#include "../doomtype.h"
+#include "../m_jobs.h"
+
+#include "i_sdlpixels.h"
+
+// screens with fewer pixels than this are converted on the calling thread
+#define EXPAND_MINJOBPIXELS (1280 * 720)
+
+//
+// I_expandRow
+//
+// Looks up a row of palette indices in a 32-bit color table.
+//
+static void I_expandRow(const byte *src, Uint32 *dest, int width, 
+                        const Uint32 *palette)
+{
+   int x = 0;
+
+   for(; x + 4 <= width; x += 4)
+   {
+      dest[x + 0] = palette[src[x + 0]];
+      dest[x + 1] = palette[src[x + 1]];
+      dest[x + 2] = palette[src[x + 2]];
+      dest[x + 3] = palette[src[x + 3]];
+   }
+
+   for(; x < width; x++)
+      dest[x] = palette[src[x]];
+}
+
+//
+// expandscreen_t
+//
+// The screen being converted.
+//
+struct expandscreen_t
+{
+   const byte   *src;
+   byte         *dest;
+   int           srcpitch, destpitch;
+   int           width;
+   const Uint32 *palette;
+};
+
+//
+// I_expandRows
+//
+// Converts rows [start, stop) of the screen; also the M_ParallelFor callback.
+//
+static void I_expandRows(int start, int stop, void *data)
+{
+   const expandscreen_t *screen = static_cast<expandscreen_t *>(data);
+   const byte *src  = screen->src  + start * screen->srcpitch;
+   byte       *dest = screen->dest + start * screen->destpitch;
+
+   for(int y = start; y < stop; y++)
+   {
+      I_expandRow(src, (Uint32 *)dest, screen->width, screen->palette);
+      src  += screen->srcpitch;
+      dest += screen->destpitch;
+   }
+}
+
+//
+// I_SDLExpandPixels32
+//
+// Converts width x height 8-bit pixels at src to 32-bit pixels at dest
+// through the given 256-entry color table. Pitches are in bytes. Large
+// screens are split into bands of rows run as jobs.
+//
+void I_SDLExpandPixels32(const byte *src, int srcpitch, void *dest, 
+                         int destpitch, int width, int height, 
+                         const Uint32 *palette)
+{
+   expandscreen_t screen = 
+   { 
+      src, static_cast<byte *>(dest), srcpitch, destpitch, width, palette 
+   };
+
+   if(width * height < EXPAND_MINJOBPIXELS || M_NumJobWorkers() <= 0)
+      I_expandRows(0, height, &screen);
+   else
+      M_ParallelFor("I_SDLExpandPixels32", height, 0, I_expandRows, &screen);
+}
+
+// EOF
@@ -0,0 +1,40 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 Team Eternity et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:  
+//    Conversion of the 8-bit game screen to 32-bit pixels for presentation
+//
+//-----------------------------------------------------------------------------
+
+#ifndef I_SDLPIXELS_H__
+#define I_SDLPIXELS_H__
+
+#include "SDL_stdinc.h"
+
+#include "../doomtype.h"
+
+void I_SDLExpandPixels32(const byte *src, int srcpitch, void *dest, 
+                         int destpitch, int width, int height, 
+                         const Uint32 *palette);
+
+#endif
+
+// EOF
+
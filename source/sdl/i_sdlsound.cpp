@@ -746,6 +746,43 @@ static void I_SDLCacheSound(sfxinfo_t *sound)
    S_CacheDigitalSoundLump(sound);
 }
 
+//
+// I_SDLStartOfflineMix
+//
+// Detach the mixer from the audio device so that sound only advances when
+// I_SDLMixOffline asks for it.
+//
+static int I_SDLStartOfflineMix()
+{
+   Mix_SetPostMix(NULL, NULL);
+   SDL_PauseAudio(1);
+
+   return snd_samplerate;
+}
+
+//
+// I_SDLMixOffline
+//
+// Run the postmix callback directly on a silent buffer, in pieces no larger
+// than the mixing buffers were sized for.
+//
+static void I_SDLMixOffline(short *dest, int frames)
+{
+   int maxframes = (int)(mixbuffer_size / STEP);
+
+   while(frames > 0)
+   {
+      int count = frames < maxframes ? frames : maxframes;
+      int len   = count * STEP * SAMPLESIZE;
+
+      memset(dest, 0, len);
+      I_SDLUpdateSoundCB(NULL, (Uint8 *)dest, len);
+
+      dest   += count * STEP;
+      frames -= count;
+   }
+}
+
 static void I_SDLDummyCallback(void *, Uint8 *, int) {} 
 
 //
@@ -834,6 +871,8 @@ i_sounddriver_t i_sdlsound_driver =
    I_SDLSoundIsPlaying,    // SoundIsPlaying
    I_SDLUpdateSoundParams, // UpdateSoundParams
    I_SDLUpdateEQParams,    // UpdateEQParams
+   I_SDLStartOfflineMix,   // StartOfflineMix
+   I_SDLMixOffline,        // MixOffline
 };
 
 // EOF
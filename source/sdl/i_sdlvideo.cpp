@@ -28,11 +28,13 @@
 
 #include "../z_zone.h"  /* memory allocation wrappers -- killough */
 
+#include "i_sdlpixels.h"
 #include "i_sdlvideo.h"
 
 #include "../d_main.h"
 #include "../i_system.h"
 #include "../m_argv.h"
+#include "../m_compare.h"
 #include "../v_misc.h"
 #include "../v_patchfmt.h"
 #include "../v_video.h"
@@ -77,6 +79,54 @@ extern char *i_videomode;
 // haleyjd 12/03/07: 8-on-32 graphics support
 static bool crossbitdepth;
 
+// 32-bit pixel values of the current colors, for 8-on-32 modes
+static Uint32 RGB8to32[256];
+
+//
+// I_SDLUpdateColorTable
+//
+// Maps the current colors to pixel values of a 32-bit screen surface, so
+// that the frame can be converted without going through SDL_BlitSurface.
+//
+static void I_SDLUpdateColorTable()
+{
+   if(!sdlscreen || !crossbitdepth || sdlscreen->format->BytesPerPixel != 4)
+      return;
+
+   for(int i = 0; i < 256; i++)
+      RGB8to32[i] = SDL_MapRGB(sdlscreen->format, colors[i].r, colors[i].g, colors[i].b);
+}
+
+//
+// I_SDLBlitPrimary
+//
+// Copies the game's frame to the screen surface. 8-on-32 modes use the
+// shared palette expansion routine; other depths go through SDL.
+//
+static void I_SDLBlitPrimary()
+{
+   if(!crossbitdepth || sdlscreen->format->BytesPerPixel != 4)
+   {
+      SDL_BlitSurface(primary_surface, NULL, sdlscreen, destrect);
+      return;
+   }
+
+   if(SDL_MUSTLOCK(sdlscreen) && SDL_LockSurface(sdlscreen) < 0)
+      return;
+
+   byte *dest = (byte *)sdlscreen->pixels;
+   if(destrect)
+      dest += destrect->y * sdlscreen->pitch + destrect->x * 4;
+
+   I_SDLExpandPixels32((byte *)primary_surface->pixels, primary_surface->pitch,
+                       dest, sdlscreen->pitch, 
+                       emin(video.width, int(sdlscreen->w)),
+                       emin(video.height, int(sdlscreen->h)), RGB8to32);
+
+   if(SDL_MUSTLOCK(sdlscreen))
+      SDL_UnlockSurface(sdlscreen);
+}
+
 //
 // SDLVideoDriver::FinishUpdate
 //
@@ -101,12 +151,14 @@ void SDLVideoDriver::FinishUpdate()
       if(primary_surface)
          SDL_SetPalette(primary_surface, SDL_LOGPAL|SDL_PHYSPAL, colors, 0, 256);
 
+      I_SDLUpdateColorTable();
+
       setpalette = false;
    }
 
    // haleyjd 11/12/09: blit *after* palette set improves behavior.
    if(primary_surface)
-      SDL_BlitSurface(primary_surface, NULL, sdlscreen, destrect);
+      I_SDLBlitPrimary();
 
    // haleyjd 11/12/09: ALWAYS update. Causes problems with some video surface
    // types otherwise.
@@ -147,6 +199,8 @@ static void I_SDLSetPaletteDirect(byte *palette)
 
    if(primary_surface)
       SDL_SetPalette(primary_surface, SDL_LOGPAL|SDL_PHYSPAL, colors, 0, 256);
+
+   I_SDLUpdateColorTable();
 }
 
 //
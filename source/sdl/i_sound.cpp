@@ -199,6 +199,32 @@ void I_CacheSound(sfxinfo_t *sound)
       i_sounddriver->CacheSound(sound);
 }
 
+//
+// I_StartOfflineMix
+//
+// Switch the sound driver over to mixing on demand, for rendering sound to a
+// file rather than playing it. Returns the sample rate, or 0 if the driver
+// cannot do this.
+//
+int I_StartOfflineMix()
+{
+   if(snd_init && i_sounddriver->StartOfflineMix)
+      return i_sounddriver->StartOfflineMix();
+   else
+      return 0;
+}
+
+//
+// I_MixSoundOffline
+//
+// Mix frames stereo sample frames into dest. Only valid once I_StartOfflineMix
+// has succeeded.
+//
+void I_MixSoundOffline(short *dest, int frames)
+{
+   i_sounddriver->MixOffline(dest, frames);
+}
+
 // haleyjd 11/07/08: sound driver objects
 
 #ifdef _SDL_VER
@@ -369,6 +395,27 @@ int I_RegisterSong(void *data, int size)
    return mus_init ? i_musicdriver->RegisterSong(data, size) : 0;
 }
 
+//
+// I_PrefetchSong
+//
+// Hands song data to the driver ahead of I_RegisterSong.
+//
+int I_PrefetchSong(void *data, int size)
+{
+   return mus_init ? i_musicdriver->PrefetchSong(data, size) : 0;
+}
+
+//
+// I_UpdateMusic
+//
+// Lets the driver start a song once it has finished loading.
+//
+void I_UpdateMusic()
+{
+   if(mus_init)
+      i_musicdriver->UpdateMusic();
+}
+
 //
 // I_QrySongPlaying
 //
@@ -51,12 +51,13 @@
 #include "mmus2mid.h"
 
 //#define STANDALONE  /* uncomment this to make MMUS2MID.EXE */
-#ifndef STANDALONE
-#include "../z_zone.h"
-#else
-#define emalloc(t, n) (t)(malloc(n))
-#define efree(p)      free(p)
-#endif
+
+// Conversion runs in music loading jobs (see i_sdlmusic.cpp), which must
+// stay off the zone heap, so the C allocator is used in every build. Buffers
+// handed back from here are released with free().
+#define emalloc(t, n)     (t)(malloc(n))
+#define erealloc(t, p, n) (t)(realloc(p, n))
+#define efree(p)          free(p)
 
 // some macros to decode mus event bit fields
 
@@ -113,9 +114,10 @@ typedef struct Track
    int   alloced;
 } TrackInfo;
 
-// array of info about tracks
+// array of info about tracks; per thread, as songs may be converted by
+// several jobs at once
 
-static TrackInfo track[MIDI_TRACKS];
+static thread_local TrackInfo track[MIDI_TRACKS];
 
 // initial track size allocation
 static ULONG TRACKBUFFERSIZE = 1024L;   
@@ -146,7 +148,7 @@ static UBYTE midikey[]   =
 {0x00,0xff,0x59,0x02,0x00,0x00};        // C major
 static UBYTE miditempo[] =
 {0x00,0xff,0x51,0x03,0x09,0xa3,0x1a};   // uS/qnote
-static UBYTE midihdr[]   =
+static thread_local UBYTE midihdr[] =   // filled in by MIDIToMidi
 {'M','T','h','d',0,0,0,6,0,1,0,0,0,0};  // header (length 6, format 1)
 static UBYTE trackhdr[]  =
 {'M','T','r','k'};                      // track header
@@ -182,14 +184,19 @@ static int TWriteByte(MIDI *mididata, int MIDItrack, unsigned char byte)
    // proff: Added typecast to avoid warning
    if(pos >= (size_t)track[MIDItrack].alloced)
    {
+      unsigned char *newdata;
+
       track[MIDItrack].alloced =        // double allocation
         track[MIDItrack].alloced?       // or set initial TRACKBUFFERSIZE
         2*track[MIDItrack].alloced :
         TRACKBUFFERSIZE;
 
-      if(!(mididata->track[MIDItrack].data =     // attempt to reallocate
-         erealloc(unsigned char *, mididata->track[MIDItrack].data, track[MIDItrack].alloced)))
+      // attempt to reallocate; on failure the old block stays in the track
+      // so that FreeTracks can release it
+      if(!(newdata = erealloc(unsigned char *, mididata->track[MIDItrack].data, 
+                              track[MIDItrack].alloced)))
          return MEMALLOC;
+      mididata->track[MIDItrack].data = newdata;
    }
 
    mididata->track[MIDItrack].data[pos] = byte;
@@ -599,9 +606,11 @@ int mmus2mid(UBYTE *mus, size_t size, MIDI *mididata, UWORD division, int nocomp
             goto err;
          // jff 1/23/98 fix failure to set data NULL, len 0 for unused tracks
          // shorten allocation to proper length (important for Allegro)
-         if(!(mididata->track[i].data =
+         unsigned char *newdata;
+         if(!(newdata =
             erealloc(unsigned char *, mididata->track[i].data, mididata->track[i].len)))
             return MEMALLOC;
+         mididata->track[i].data = newdata;
       }
       else
       {
@@ -645,7 +654,8 @@ size_t ReadLength(UBYTE **mid)
 // Passed a pointer to a memory buffer with MIDI format music in it and a
 // pointer to an Allegro MIDI structure. 
 //
-// Returns 0 if successful, BADMIDHDR if the buffer is not MIDI format
+// Returns 0 if successful, BADMIDHDR if the buffer is not MIDI format,
+// MEMALLOC if a memory allocation error occurs
 //
 int MidiToMIDI(UBYTE *mid,MIDI *mididata)
 {
@@ -679,8 +689,11 @@ int MidiToMIDI(UBYTE *mid,MIDI *mididata)
       mididata->track[i].len = ReadLength(&mid);  // get length, move mid past it
       
       // read a track
-      mididata->track[i].data = 
-         erealloc(unsigned char *, mididata->track[i].data, mididata->track[i].len);
+      unsigned char *newdata;
+      if(!(newdata = 
+         erealloc(unsigned char *, mididata->track[i].data, mididata->track[i].len)))
+         return MEMALLOC;
+      mididata->track[i].data = newdata;
       memcpy(mididata->track[i].data, mid, mididata->track[i].len);
       mid += mididata->track[i].len;
    }
@@ -702,7 +715,6 @@ int MidiToMIDI(UBYTE *mid,MIDI *mididata)
 //                  /* it also provides a MUS to MID file converter*/
 // proff: I moved this down, because I need MIDItoMidi
 
-#ifdef STANDALONE
 //
 // FreeTracks()
 //
@@ -711,7 +723,7 @@ int MidiToMIDI(UBYTE *mid,MIDI *mididata)
 // Passed a pointer to an Allegro MIDI structure
 // Returns nothing
 // 
-static void FreeTracks(MIDI *mididata)
+void FreeTracks(MIDI *mididata)
 {
    int i;
    
@@ -722,7 +734,6 @@ static void FreeTracks(MIDI *mididata)
       mididata->track[i].len = 0;
    }
 }
-#endif
 
 //
 // TWriteLength()
@@ -62,6 +62,7 @@ bool mmuscheckformat(UBYTE *mus, int size);
 int  mmus2mid(UBYTE *mus, size_t size, MIDI *mid, UWORD division, int nocomp);
 int  MIDIToMidi(MIDI *mididata, UBYTE **mid, int *midlen);
 int  MidiToMIDI(UBYTE *mid,MIDI *mididata);
+void FreeTracks(MIDI *mididata);
 
 #endif
 
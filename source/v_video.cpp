@@ -35,6 +35,7 @@
 #include "doomstat.h"
 #include "i_video.h"
 #include "m_bbox.h"
+#include "m_jobs.h"
 #include "r_draw.h"
 #include "r_main.h"
 #include "v_block.h"
@@ -816,9 +817,32 @@ typedef struct tpalcol_s
    unsigned int r, g, b;
 } tpalcol_t;
 
+//
+// V_rgbTableRows
+//
+// Job function filling in RGB32k for red values [start, stop).
+//
+static void V_rgbTableRows(int start, int stop, void *data)
+{
+   const byte *palette = static_cast<byte *>(data);
+
+   for(int r = start; r < stop; ++r)
+   {
+      for(int g = 0; g < 32; ++g)
+      {
+         for(int b = 0; b < 32; ++b)
+         {
+            RGB32k[r][g][b] = 
+               V_FindBestColor(palette, 
+                               MAKECOLOR(r), MAKECOLOR(g), MAKECOLOR(b));
+         }
+      }
+   }
+}
+
 void V_InitFlexTranTable(const byte *palette)
 {
-   int i, r, g, b, x, y;
+   int i, x, y;
    tpalcol_t  *tempRGBpal;
    const byte *palRover;
 
@@ -835,18 +859,8 @@ void V_InitFlexTranTable(const byte *palette)
    }
 
    // build RGB table
-   for(r = 0; r < 32; ++r)
-   {
-      for(g = 0; g < 32; ++g)
-      {
-         for(b = 0; b < 32; ++b)
-         {
-            RGB32k[r][g][b] = 
-               V_FindBestColor(palette, 
-                               MAKECOLOR(r), MAKECOLOR(g), MAKECOLOR(b));
-         }
-      }
-   }
+   M_ParallelFor("V_InitFlexTranTable", 32, 1, V_rgbTableRows, 
+                 const_cast<byte *>(palette));
    
    // build lookup table
    for(x = 0; x < 65; ++x)
@@ -215,6 +215,7 @@ static namespace_matcher_t matchers[] =
    { "translations/", lumpinfo_t::ns_translations }, // EE extension
    { "gamepads/",     lumpinfo_t::ns_pads         }, // EE extension
    { "textures/",     lumpinfo_t::ns_textures     },
+   { "voxels/",       lumpinfo_t::ns_voxels       },
 
    { NULL,            -1                          }  // keep this last
 
@@ -223,7 +224,6 @@ static namespace_matcher_t matchers[] =
    { "hires/",        lumpinfo_t::ns_hires        },
    { "patches/",      lumpinfo_t::ns_patches      },
    { "voices/",       lumpinfo_t::ns_voices       },
-   { "voxels/",       lumpinfo_t::ns_voxels       },
    */
 };
 
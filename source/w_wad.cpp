@@ -1044,6 +1044,7 @@ static nsdata_t wadNameSpaces[lumpinfo_t::ns_max] =
    { "TX_START", "TX_END", lumpinfo_t::ns_textures     },
    { NULL,       NULL,     lumpinfo_t::ns_graphics     },
    { NULL,       NULL,     lumpinfo_t::ns_sounds       },
+   { "VX_START", "VX_END", lumpinfo_t::ns_voxels       },
 };
 
 //